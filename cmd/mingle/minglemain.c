@@ -24,6 +24,7 @@
     #pragma comment( lib, "cdt.lib" )
 #endif   /* not WIN32_DLL */
 
+#include <time.h>
 #include <cgraph.h>
 #include <agxbuf.h>
 #include <ingraphs.h>
@@ -36,6 +37,7 @@
 
 #include "DotIO.h"
 #include "edge_bundling.h"
+#include "ink.h"
 #include "nearest_neighbor_graph.h"
 
 typedef enum {
@@ -60,6 +62,7 @@ typedef struct {
 	int max_recursion;
 	real angle_param;
 	real angle;
+	int bench;
 } opts_t;
 
 static char *fname;
@@ -86,6 +89,7 @@ static FILE *openFile(char *name, char *mode, char* cmd)
 static char* use_msg =
 "Usage: mingle <options> <file>\n\
     -a t - max. turning angle [0-180] (40)\n\
+    -b - report the time and rate of ink evaluations\n\
     -c i - compatability measure; 0 : distance, 1: full (default)\n\
     -i iter: number of outer iterations/subdivisions (4)\n\
     -k k - number of neighbors in the nearest neighbor graph of edges (10)\n\
@@ -145,8 +149,9 @@ static void init(int argc, char *argv[], opts_t* opts)
 	opts->max_recursion = 100;
 	opts->angle_param = -1;
 	opts->angle = 40.0/180.0*M_PI;
+	opts->bench = 0;
 
-	while ((c = getopt(argc, argv, ":a:c:i:k:K:m:o:p:r:T:v:")) != -1) {
+	while ((c = getopt(argc, argv, ":a:bc:i:k:K:m:o:p:r:T:v:")) != -1) {
 		switch (c) {
 		case 'a':
             if ((sscanf(optarg,"%lf",&s) > 0) && (s >= 0))
@@ -154,6 +159,9 @@ static void init(int argc, char *argv[], opts_t* opts)
 			else 
 				fprintf (stderr, "-a arg %s must be positive real - ignored\n", optarg); 
 			break;
+		case 'b':
+			opts->bench = 1;
+			break;
 		case 'c':
             if ((sscanf(optarg,"%d",&i) > 0) && (0 <= i) && (i <= COMPATIBILITY_FULL))
 				opts->compatibility_method =  i;
@@ -411,6 +419,7 @@ bundle (Agraph_t* g, opts_t* opts)
     int nz = 0;
     int *ia, *ja, i, j, k;
 	int rv = 0;
+	clock_t start = 0;
 
 	if (checkG(g)) {
 		agerr (AGERR, "Graph %s (%s) contains loops or multiedges\n");
@@ -491,7 +500,18 @@ bundle (Agraph_t* g, opts_t* opts)
 
 	dim = 2;
 
+	if (opts->bench) {
+		ink_count = ink_calls = ink_requests = 0;
+		start = clock();
+	}
 	edges = edge_bundling(A, 2, x, opts->outer_iter, opts->K, opts->method, opts->nneighbors, opts->compatibility_method, opts->max_recursion, opts->angle_param, opts->angle, 0);
+	if (opts->bench) {
+		real secs = ((real) (clock() - start))/CLOCKS_PER_SEC;
+		fprintf(stderr, "%s: %d edges, %.0f candidate bundles, %.0f ink evaluations of %.0f edges\n",
+			agnameof(g), A->m, ink_requests, ink_calls, ink_count);
+		fprintf(stderr, "%s: bundling %.2f sec cpu, %.0f ink evaluations/sec\n",
+			agnameof(g), secs, (secs > 0 ? ink_calls/secs : 0));
+	}
 	
 	if (opts->fmt == FMT_GV) {
 	    	export_dot (outfile, A->m, edges, g);
@@ -70,6 +70,7 @@ typedef struct {
 char **Files;
 int verbose;
 int silent;
+static Agdisc_t *readDisc;	/* AgMmapDisc with -M */
 char *outfile = 0;
 char *path = 0;
 char *suffix = 0;
@@ -311,12 +312,13 @@ static int process(Agraph_t * g, int gcnt)
 }
 
 static char *useString =
-    "Usage: bcomps [-stvx?] [-o<out template>] <files>\n\
+    "Usage: bcomps [-stvxM?] [-o<out template>] <files>\n\
   -o - output file template\n\
   -s - don't print components\n\
   -t - emit block-cutpoint tree\n\
   -v - verbose\n\
   -x - external\n\
+  -M - read input in place, mapping regular files\n\
   -? - print usage\n\
 If no files are specified, stdin is used\n";
 
@@ -348,7 +350,7 @@ static void init(int argc, char *argv[])
     int c;
 
     opterr = 0;
-    while ((c = getopt(argc, argv, ":o:xstv")) != -1) {
+    while ((c = getopt(argc, argv, ":o:xstvM")) != -1) {
 	switch (c) {
 	case 'o':
 	    outfile = optarg;
@@ -370,6 +372,9 @@ static void init(int argc, char *argv[])
 	case ':':
 	    fprintf(stderr, "bcomps: option -%c missing argument - ignored\n", optopt);
 	    break;
+	case 'M':
+	    readDisc = &AgMmapDisc;
+	    break;
 	case '?':
 	    if (optopt == '?')
 		usage(0);
@@ -388,7 +393,7 @@ static void init(int argc, char *argv[])
 
 static Agraph_t *gread(FILE * fp)
 {
-  return agread(fp, (Agdisc_t *) 0);
+  return agread(fp, readDisc);
 }
 
 int main(int argc, char *argv[])
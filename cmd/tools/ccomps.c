@@ -89,9 +89,10 @@ int x_index = -1;
 int x_final = -1;  /* require 0 <= x_index <= x_final or x_final= -1 */ 
 int x_mode;
 char *x_node;
+static Agdisc_t *readDisc;	/* AgMmapDisc with -M */
 
 static char *useString =
-    "Usage: ccomps [-svenCx?] [-X[#%]s[-f]] [-o<out template>] <files>\n\
+    "Usage: ccomps [-svenCxM?] [-X[#%]s[-f]] [-o<out template>] <files>\n\
   -s - silent\n\
   -x - external\n\
   -X - extract component\n\
@@ -101,6 +102,7 @@ static char *useString =
   -v - verbose\n\
   -o - output file template\n\
   -z - sort by size, largest first\n\
+  -M - read input in place, mapping regular files\n\
   -? - print usage\n\
 If no files are specified, stdin is used\n";
 
@@ -142,7 +144,7 @@ static void init(int argc, char *argv[])
 
     Cmd = argv[0];
     opterr = 0;
-    while ((c = getopt(argc, argv, ":zo:xCX:nesv")) != -1) {
+    while ((c = getopt(argc, argv, ":zo:xCX:nesvM")) != -1) {
 	switch (c) {
 	case 'o':
 	    outfile = optarg;
@@ -210,6 +212,9 @@ static void init(int argc, char *argv[])
 	    fprintf(stderr,
 		"ccomps: option -%c missing argument - ignored\n", optopt);
 	    break;
+	case 'M':
+	    readDisc = &AgMmapDisc;
+	    break;
 	case '?':
 	    if (optopt == '?')
 		usage(0);
@@ -865,7 +870,7 @@ static int process(Agraph_t * g, char* graphName)
 
 static Agraph_t *gread(FILE * fp)
 {
-    return agread(fp, (Agdisc_t *) 0);
+    return agread(fp, readDisc);
 }
 
 /* chkGraphName:
@@ -71,10 +71,11 @@ static int verbose;
 static int gtype;
 static int flags;
 static char *fname;
+static Agdisc_t *readDisc;	/* AgMmapDisc with -M */
 static char **Files;
 static FILE *outfile;
 
-static char *useString = "Usage: gc [-necCaDUrsv?] <files>\n\
+static char *useString = "Usage: gc [-necCaDUrsvM?] <files>\n\
   -n - print number of nodes\n\
   -e - print number of edges\n\
   -c - print number of connected components\n\
@@ -85,6 +86,7 @@ static char *useString = "Usage: gc [-necCaDUrsv?] <files>\n\
   -r - recursively analyze subgraphs\n\
   -s - silent\n\
   -v - verbose\n\
+  -M - read input in place, mapping regular files\n\
   -? - print usage\n\
 By default, gc prints nodes and edges\n\
 If no files are specified, stdin is used\n";
@@ -100,7 +102,7 @@ static void init(int argc, char *argv[])
     unsigned int c;
 
     opterr = 0;
-    while ((c = getopt(argc, argv, "necCaDUrsv")) != -1) {
+    while ((c = getopt(argc, argv, "necCaDUrsvM")) != -1) {
 	switch (c) {
 	case 'e':
 	    flags |= EDGES;
@@ -133,6 +135,9 @@ static void init(int argc, char *argv[])
 	case 'U':
 	    gtype = UNDIRECTED;
 	    break;
+	case 'M':
+	    readDisc = &AgMmapDisc;
+	    break;
 	case '?':
 	    if (optopt == '?')
 		usage(0);
@@ -351,7 +356,7 @@ static int eval(Agraph_t * g, int root)
 
 static Agraph_t *gread(FILE * fp)
 {
-    return agread(fp, (Agdisc_t *) 0);
+    return agread(fp, readDisc);
 }
 
 int main(int argc, char *argv[])
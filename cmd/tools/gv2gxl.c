@@ -612,6 +612,7 @@ writeNondefaultAttr(void *obj, FILE * gxlFile, Dict_t * defdict)
 {
     Agattr_t *data;
     Agsym_t *sym;
+    char *val;
     int cnt = 0;
 
     if ((AGTYPE(obj) == AGINEDGE) || (AGTYPE(obj) == AGOUTEDGE)) {
@@ -622,6 +623,7 @@ writeNondefaultAttr(void *obj, FILE * gxlFile, Dict_t * defdict)
     if (data) {
 	for (sym = (Agsym_t *) dtfirst(defdict); sym;
 	     sym = (Agsym_t *) dtnext(defdict, sym)) {
+	    val = agxget(obj, sym);
 	    if (!isGxlGrammar(sym->name)) {
 		if ((AGTYPE(obj) == AGINEDGE)
 		    || (AGTYPE(obj) == AGOUTEDGE)) {
@@ -630,14 +632,14 @@ writeNondefaultAttr(void *obj, FILE * gxlFile, Dict_t * defdict)
 		    if (Headport && (sym->id == Headport->id))
 			continue;
 		}
-		if (data->str[sym->id] != sym->defval) {
+		if (val != sym->defval) {
 
-		    if (strcmp(data->str[sym->id], "") == 0)
+		    if (strcmp(val, "") == 0)
 			continue;
 
-		    if (isLocatorType(data->str[sym->id])) {
+		    if (isLocatorType(val)) {
 			char *locatorVal;
-			locatorVal = data->str[sym->id];
+			locatorVal = val;
 			locatorVal += 13;
 
 			tabover(gxlFile);
@@ -654,7 +656,7 @@ writeNondefaultAttr(void *obj, FILE * gxlFile, Dict_t * defdict)
 			fprintf(gxlFile, "\t<attr name=\"%s\">\n",
 				xml_string(sym->name));
 			tabover(gxlFile);
-			fprintf(gxlFile, "\t\t<string>%s</string>\n", xml_string(data->str[sym->id]));
+			fprintf(gxlFile, "\t\t<string>%s</string>\n", xml_string(val));
 			tabover(gxlFile);
 			fprintf(gxlFile, "\t</attr>\n");
 		    }
@@ -662,13 +664,13 @@ writeNondefaultAttr(void *obj, FILE * gxlFile, Dict_t * defdict)
 	    } else {
 		/* gxl attr; check for special cases like composites */
 		if (strncmp(sym->name, GXL_COMP, GXL_COMP_LEN) == 0) {
-		    if (data->str[sym->id] != sym->defval) {
+		    if (val != sym->defval) {
 
 			tabover(gxlFile);
 			fprintf(gxlFile, "\t<attr name=\"%s\">\n",
 				xml_string(((sym->name) + GXL_COMP_LEN)));
 			tabover(gxlFile);
-			fprintf(gxlFile, "\t\t%s\n", xml_string(data->str[sym->id]));
+			fprintf(gxlFile, "\t\t%s\n", xml_string(val));
 			tabover(gxlFile);
 			fprintf(gxlFile, "\t</attr>\n");
 		    }
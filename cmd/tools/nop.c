@@ -31,9 +31,11 @@
 
 char **Files;
 int chkOnly;
+static Agdisc_t *readDisc;	/* AgMmapDisc with -M */
 
-static char *useString = "Usage: nop [-p?] <files>\n\
+static char *useString = "Usage: nop [-pM?] <files>\n\
   -p - check for valid DOT\n\
+  -M - read input in place, mapping regular files\n\
   -? - print usage\n\
 If no files are specified, stdin is used\n";
 
@@ -53,11 +55,14 @@ static void init(int argc, char *argv[])
     int c;
 
     opterr = 0;
-    while ((c = getopt(argc, argv, "p")) != -1) {
+    while ((c = getopt(argc, argv, "pM")) != -1) {
 	switch (c) {
 	case 'p':
 	    chkOnly = 1;
 	    break;
+	case 'M':
+	    readDisc = &AgMmapDisc;
+	    break;
 	case '?':
 	    if (optopt == '?')
 		usage(0);
@@ -76,7 +81,7 @@ static void init(int argc, char *argv[])
 
 static Agraph_t *gread(FILE * fp)
 {
-    return agread(fp, (Agdisc_t *) 0);
+    return agread(fp, readDisc);
 }
 
 int main(int argc, char **argv)
@@ -146,6 +146,7 @@ static int StatsOnly;
 static int Verbose;
 static char *CmdName;
 static char **Files;
+static Agdisc_t *readDisc;	/* AgMmapDisc with -M */
 static FILE *outfp;		/* output; stdout by default */
 
 static void nodeInduce(Agraph_t * g, Agraph_t* map)
@@ -329,12 +330,13 @@ static FILE *openFile(char *name, char *mode)
     return (fp);
 }
 
-static char *useString = "Usage: %s [-sdv?] <files>\n\
+static char *useString = "Usage: %s [-sdvM?] <files>\n\
   -s           - only produce statistics\n\
   -S           - silent\n\
   -d           - allow degenerate components\n\
   -o<outfile>  - write to <outfile> (stdout)\n\
   -v           - verbose\n\
+  -M           - read input in place, mapping regular files\n\
   -?           - print usage\n\
 If no files are specified, stdin is used\n";
 
@@ -350,7 +352,7 @@ static void scanArgs(int argc, char **argv)
 
     CmdName = argv[0];
     opterr = 0;
-    while ((c = getopt(argc, argv, ":o:sdvS")) != EOF) {
+    while ((c = getopt(argc, argv, ":o:sdvSM")) != EOF) {
 	switch (c) {
 	case 's':
 	    StatsOnly = 1;
@@ -371,6 +373,9 @@ static void scanArgs(int argc, char **argv)
 	case ':':
 	    fprintf(stderr, "%s: option -%c missing argument - ignored\n", CmdName, optopt);
 	    break;
+	case 'M':
+	    readDisc = &AgMmapDisc;
+	    break;
 	case '?':
 	    if (optopt == '?')
 		usage(0);
@@ -391,7 +396,7 @@ static void scanArgs(int argc, char **argv)
 
 static Agraph_t *gread(FILE * fp)
 {
-    return agread(fp, (Agdisc_t *) 0);
+    return agread(fp, readDisc);
 }
 
 int main(int argc, char **argv)
@@ -49,6 +49,7 @@ typedef struct {
 
 char **Files;
 char *CmdName;
+static Agdisc_t *readDisc;	/* AgMmapDisc with -M */
 #define MARK(n)  (((Agnodeinfo_t*)(n->base.data))->mark)
 
 #ifdef WIN32 //*dependencies
@@ -90,7 +91,8 @@ static int dfs(Agnode_t * n, Agedge_t * link, int warn)
     return warn;
 }
 
-static char *useString = "Usage: %s [-?] <files>\n\
+static char *useString = "Usage: %s [-M?] <files>\n\
+  -M - read input in place, mapping regular files\n\
   -? - print usage\n\
 If no files are specified, stdin is used\n";
 
@@ -106,8 +108,11 @@ static void init(int argc, char *argv[])
 
     CmdName = argv[0];
     opterr = 0;
-    while ((c = getopt(argc, argv, ":")) != -1) {
+    while ((c = getopt(argc, argv, ":M")) != -1) {
 	switch (c) {
+	case 'M':
+	    readDisc = &AgMmapDisc;
+	    break;
 	case '?':
 	    if (optopt == '?')
 		usage(0);
@@ -139,7 +144,7 @@ static void process(Agraph_t * g)
 
 static Agraph_t *gread(FILE * fp)
 {
-    return agread(fp, (Agdisc_t *) 0);
+    return agread(fp, readDisc);
 }
 
 int main(int argc, char **argv)
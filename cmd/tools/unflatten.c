@@ -42,6 +42,7 @@ static int ChainSize = 0;
 static Agnode_t *ChainNode;
 static FILE *outFile;
 static char *cmd;
+static Agdisc_t *readDisc;	/* AgMmapDisc with -M */
 
 #ifdef WIN32 //*dependencies
     #pragma comment( lib, "cgraph.lib" )
@@ -145,11 +146,12 @@ static void transform(Agraph_t * g)
 
 
 static char *useString =
-    "Usage: %s [-f?] [-l l] [-c l] [-o outfile] <files>\n\
+    "Usage: %s [-fM?] [-l l] [-c l] [-o outfile] <files>\n\
   -o <file> - put output in <file>\n\
   -f        - adjust immediate fanout chains\n\
   -l <len>  - stagger length of leaf edges between [1,l]\n\
   -c <len>  - put disconnected nodes in chains of length l\n\
+  -M        - read input in place, mapping regular files\n\
   -?        - print usage\n";
 
 static void usage(int v)
@@ -182,7 +184,7 @@ static char **scanargs(int argc, char **argv)
 
     cmd = argv[0];
     opterr = 0;
-    while ((c = getopt(argc, argv, ":fl:c:o:")) != -1) {
+    while ((c = getopt(argc, argv, ":fl:c:o:M")) != -1) {
 	switch (c) {
 	case 'f':
 	    Do_fans = 1;
@@ -200,6 +202,9 @@ static char **scanargs(int argc, char **argv)
 	case 'o':
 	    outFile = openFile(optarg, "w");
 	    break;
+	case 'M':
+	    readDisc = &AgMmapDisc;
+	    break;
 	case '?':
 	    if (optopt == '?')
 		usage(0);
@@ -231,7 +236,7 @@ static char **scanargs(int argc, char **argv)
 
 static Agraph_t *gread(FILE * fp)
 {
-    return agread(fp, (Agdisc_t *) 0);
+    return agread(fp, readDisc);
 }
 
 int main(int argc, char **argv)
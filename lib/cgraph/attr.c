@@ -22,6 +22,7 @@
 #define MINATTR	4		/* minimum allocation */
 
 static void freesym(Dict_t * d, Void_t * obj, Dtdisc_t * disc);
+static void addcol(Agraph_t * g, Agsym_t * sym);
 
 Dtdisc_t AgDataDictDisc = {
     (int) offsetof(Agsym_t, name),	/* use symbol name as key */
@@ -101,6 +102,15 @@ static void agcopydict(Dict_t * src, Dict_t * dest, Agraph_t * g, int kind)
     }
 }
 
+static void addcols(Dict_t * dict, Agraph_t * g)
+{
+    Agsym_t *sym;
+
+    for (sym = (Agsym_t *) dtfirst(dict); sym;
+	 sym = (Agsym_t *) dtnext(dict, sym))
+	addcol(g, sym);
+}
+
 static Agdatadict_t *agmakedatadict(Agraph_t * g)
 {
     Agraph_t *par;
@@ -125,6 +135,11 @@ static Agdatadict_t *agmakedatadict(Agraph_t * g)
 	    agcopydict(parent_dd->dict.n, dd->dict.n, g, AGNODE);
 	    agcopydict(parent_dd->dict.e, dd->dict.e, g, AGEDGE);
 	    agcopydict(parent_dd->dict.g, dd->dict.g, g, AGRAPH);
+	    if (g->clos->attrcols) {
+		addcols(dd->dict.n, g);
+		addcols(dd->dict.e, g);
+		addcols(dd->dict.g, g);
+	    }
 	}
     }
     return dd;
@@ -176,10 +191,170 @@ static int topdictsize(Agobj_t * obj)
     return d ? dtsize(d) : 0;
 }
 
+/* allocation for n attribute values. this grows geometrically
+ * as attributes are declared, so objects are rarely resized.
+ */
+static size_t attrsize(size_t n)
+{
+    size_t sz = MINATTR;
+
+    while (sz < n)
+	sz *= 2;
+    return sz;
+}
+
+/*
+ * string attributes stored by column. each Agsym_t id has a column
+ * per kind of object, indexed by the object's sequence number, so
+ * declaring an attribute does not visit existing objects: they read
+ * the default through col->fill.
+ */
+
+#define COLKIND(kind)	((kind) == AGINEDGE ? AGOUTEDGE : (kind))
+
+static void addcol(Agraph_t * g, Agsym_t * sym)
+{
+    Agattrcols_t *cols = g->clos->attrcols;
+    int kind = COLKIND(sym->kind);
+    size_t sz;
+
+    if ((size_t) sym->id >= cols->size[kind]) {
+	sz = attrsize((size_t) sym->id + 1);
+	cols->col[kind] = agrealloc(g, cols->col[kind],
+				    cols->size[kind] * sizeof(Agattrcol_t),
+				    sz * sizeof(Agattrcol_t));
+	cols->size[kind] = sz;
+    }
+    cols->col[kind][sym->id].fill = agstrdup(g, sym->defval);
+    if (sym->id >= cols->ncol[kind])
+	cols->ncol[kind] = sym->id + 1;
+}
+
+static Agattrcol_t *colof(void *obj, Agsym_t * sym)
+{
+    Agattrcols_t *cols = agraphof(obj)->clos->attrcols;
+    int kind = COLKIND(AGTYPE(obj));
+
+    assert((sym->id >= 0) && (sym->id < cols->ncol[kind]));
+    return &cols->col[kind][sym->id];
+}
+
+static void growcol(Agraph_t * g, Agattrcol_t * col, unsigned long seq)
+{
+    size_t sz;
+
+    if (seq < col->size)
+	return;
+    sz = attrsize(seq + 1);
+    col->str = agrealloc(g, col->str, col->size * sizeof(char *),
+			 sz * sizeof(char *));
+    col->size = sz;
+}
+
+static char *colget(void *obj, Agsym_t * sym)
+{
+    Agattrcol_t *col = colof(obj, sym);
+    unsigned long seq = AGSEQ(obj);
+
+    if ((seq < col->size) && col->str[seq])
+	return col->str[seq];
+    return col->fill;
+}
+
+/* doesn't call agmethod_upd() */
+static void colset(Agraph_t * g, void *obj, Agsym_t * sym, char *value)
+{
+    Agattrcol_t *col = colof(obj, sym);
+    unsigned long seq = AGSEQ(obj);
+    char *s, *old;
+
+    s = agstrdup(g, value);
+    if (s == col->fill) {	/* the column holds this reference */
+	agstrfree(g, s);
+	s = NILstr;
+	if (seq >= col->size)
+	    return;
+    }
+    growcol(g, col, seq);
+    old = col->str[seq];
+    if (old && (old != col->fill))
+	agstrfree(g, old);
+    col->str[seq] = s;
+}
+
+static void freecols(Agobj_t * obj)
+{
+    Agraph_t *g = agraphof(obj);
+    Agattrcols_t *cols = g->clos->attrcols;
+    int i, kind = COLKIND(AGTYPE(obj));
+    unsigned long seq = AGSEQ(obj);
+    Agattrcol_t *col;
+
+    for (i = 0; i < cols->ncol[kind]; i++) {
+	col = &cols->col[kind][i];
+	if ((seq < col->size) && col->str[seq]) {
+	    if (col->str[seq] != col->fill)
+		agstrfree(g, col->str[seq]);
+	    col->str[seq] = NILstr;
+	}
+    }
+}
+
+static void closecols(Agraph_t * g)
+{
+    Agattrcols_t *cols = g->clos->attrcols;
+    Agattrcol_t *col;
+    int i, kind;
+    size_t j;
+
+    for (kind = 0; kind < 3; kind++) {
+	for (i = 0; i < cols->ncol[kind]; i++) {
+	    col = &cols->col[kind][i];
+	    for (j = 0; j < col->size; j++)
+		if (col->str[j] && (col->str[j] != col->fill))
+		    agstrfree(g, col->str[j]);
+	    agfree(g, col->str);
+	    agstrfree(g, col->fill);
+	}
+	agfree(g, cols->col[kind]);
+    }
+    agfree(g, cols);
+    g->clos->attrcols = NIL(Agattrcols_t *);
+}
+
+/*
+ * the values of sym, indexed by AGSEQ of the objects of its kind, in
+ * a graph opened with desc.attrcols. Returns NULL otherwise. *size is
+ * set to the number of entries; those of sequence numbers with no live
+ * object are unspecified. The array belongs to the graph and is valid
+ * until sym is next set or an object of its kind is created.
+ */
+char **agattrcol(Agraph_t * g, Agsym_t * sym, int *size)
+{
+    Agattrcols_t *cols = g->clos->attrcols;
+    Agattrcol_t *col;
+    int kind = COLKIND(sym->kind);
+    unsigned long i, n;
+
+    if (!cols) {
+	*size = 0;
+	return NIL(char **);
+    }
+    assert((sym->id >= 0) && (sym->id < cols->ncol[kind]));
+    col = &cols->col[kind][sym->id];
+    n = g->clos->seq[kind] + 1;
+    growcol(g, col, n - 1);
+    for (i = 0; i < n; i++)
+	if (!col->str[i])
+	    col->str[i] = col->fill;
+    *size = (int) n;
+    return col->str;
+}
+
 /* g can be either the enclosing graph, or ProtoGraph */
 static Agrec_t *agmakeattrs(Agraph_t * context, void *obj)
 {
-    int sz;
+    size_t sz;
     Agattr_t *rec;
     Agsym_t *sym;
     Dict_t *datadict;
@@ -189,10 +364,13 @@ static Agrec_t *agmakeattrs(Agraph_t * context, void *obj)
     assert(datadict);
     if (rec->dict == NIL(Dict_t *)) {
 	rec->dict = agdictof(agroot(context), AGTYPE(obj));
-	/* don't malloc(0) */
-	sz = topdictsize(obj);
-	if (sz < MINATTR)
-	    sz = MINATTR;
+	if (agraphof(obj)->clos->attrcols) {
+	    for (sym = (Agsym_t *) dtfirst(datadict); sym;
+		 sym = (Agsym_t *) dtnext(datadict, sym))
+		colset(agraphof(obj), obj, sym, sym->defval);
+	    return (Agrec_t *) rec;
+	}
+	sz = attrsize((size_t) topdictsize(obj));
 	rec->str = agalloc(agraphof(obj), sz * sizeof(char *));
 	/* doesn't call agxset() so no obj-modified callbacks occur */
 	for (sym = (Agsym_t *) dtfirst(datadict); sym;
@@ -210,6 +388,10 @@ static void freeattr(Agobj_t * obj, Agattr_t * attr)
     Agraph_t *g;
 
     g = agraphof(obj);
+    if (g->clos->attrcols) {
+	freecols(obj);
+	return;
+    }
     sz = topdictsize(obj);
     for (i = 0; i < sz; i++)
 	agstrfree(g, attr->str[i]);
@@ -240,13 +422,13 @@ static void addattr(Agraph_t * g, Agobj_t * obj, Agsym_t * sym)
 
     attr = (Agattr_t *) agattrrec(obj);
     assert(attr != NIL(Agattr_t *));
-    if (sym->id >= MINATTR)
+    if ((sym->id >= MINATTR) && ((sym->id & (sym->id - 1)) == 0))
 	attr->str = (char **) AGDISC(g, mem)->resize(AGCLOS(g, mem),
 						     attr->str,
 						     sym->id *
 						     sizeof(char *),
-						     (sym->id +
-						      1) * sizeof(char *));
+						     2 * sym->id *
+						     sizeof(char *));
     attr->str[sym->id] = agstrdup(g, sym->defval);
     /* agmethod_upd(g,obj,sym);  JCE and GN didn't like this. */
 }
@@ -280,7 +462,9 @@ static Agsym_t *setattr(Agraph_t * g, int kind, char *name, char *value)
 	    rdict = agdictof(root, kind);
 	    rsym = agnewsym(g, name, value, dtsize(rdict), kind);
 	    dtinsert(rdict, rsym);
-	    switch (kind) {
+	    if (root->clos->attrcols)
+		addcol(root, rsym);
+	    else switch (kind) {
 	    case AGRAPH:
 		agapply(root, (Agobj_t *) root, (agobjfn_t) addattr,
 			rsym, TRUE);
@@ -361,6 +545,8 @@ void agraphattr_init(Agraph_t * g)
     Agraph_t *context;
 
     g->desc.has_attrs = 1;
+    if (g->desc.attrcols && (g == agroot(g)) && !g->clos->attrcols)
+	g->clos->attrcols = agalloc(g, sizeof(Agattrcols_t));
     /* dd = */ agmakedatadict(g);
     if (!(context = agparent(g)))
 	context = g;
@@ -377,6 +563,8 @@ int agraphattr_delete(Agraph_t * g)
 	freeattr((Agobj_t *) g, attr);
 	agdelrec(g, attr->h.name);
     }
+    if (g->clos->attrcols && (g == agroot(g)))
+	closecols(g);
 
     if ((dd = agdatadict(g, FALSE))) {
 	if (agdtclose(g, dd->dict.n)) return 1;
@@ -434,6 +622,8 @@ char *agget(void *obj, char *name)
     sym = agattrsym(obj, name);
     if (sym == NILsym)
 	rv = 0;			/* note was "", but this provides more info */
+    else if (agraphof(obj)->clos->attrcols)
+	rv = colget(obj, sym);
     else {
 	data = agattrrec((Agobj_t *) obj);
 	rv = (char *) (data->str[sym->id]);
@@ -446,6 +636,8 @@ char *agxget(void *obj, Agsym_t * sym)
     Agattr_t *data;
     char *rv;
 
+    if (agraphof(obj)->clos->attrcols)
+	return colget(obj, sym);
     data = agattrrec((Agobj_t *) obj);
     assert((sym->id >= 0) && (sym->id < topdictsize(obj)));
     rv = (char *) (data->str[sym->id]);
@@ -474,10 +666,14 @@ int agxset(void *obj, Agsym_t * sym, char *value)
 
     g = agraphof(obj);
     hdr = (Agobj_t *) obj;
-    data = agattrrec(hdr);
-    assert((sym->id >= 0) && (sym->id < topdictsize(obj)));
-    agstrfree(g, data->str[sym->id]);
-    data->str[sym->id] = agstrdup(g, value);
+    if (g->clos->attrcols)
+	colset(g, obj, sym, value);
+    else {
+	data = agattrrec(hdr);
+	assert((sym->id >= 0) && (sym->id < topdictsize(obj)));
+	agstrfree(g, data->str[sym->id]);
+	data->str[sym->id] = agstrdup(g, value);
+    }
     if (hdr->tag.objtype == AGRAPH) {
 	/* also update dict default */
 	Dict_t *dict;
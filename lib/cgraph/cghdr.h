@@ -130,6 +130,19 @@ void agdictobjfree(Dict_t * dict, Void_t * p, Dtdisc_t * disc);
 Agdatadict_t *agdatadict(Agraph_t * g, int cflag);
 Agattr_t *agattrrec(void *obj);
 
+	/* string attributes stored by column, if desc.attrcols */
+typedef struct {
+    char **str;		/* values indexed by object sequence number */
+    size_t size;	/* allocated length of str */
+    char *fill;		/* value of NULL entries, which hold no reference */
+} Agattrcol_t;
+
+typedef struct Agattrcols_s {
+    Agattrcol_t *col[3];	/* per kind, indexed by Agsym_t id */
+    int ncol[3];		/* number of columns */
+    size_t size[3];		/* allocated length of col */
+} Agattrcols_t;
+
 void agraphattr_init(Agraph_t * g);
 int agraphattr_delete(Agraph_t * g);
 void agnodeattr_init(Agraph_t *g, Agnode_t * n);
@@ -138,6 +151,11 @@ void agedgeattr_init(Agraph_t *g, Agedge_t * e);
 void agedgeattr_delete(Agedge_t * e);
 
 	/* parsing and lexing graph files */
+extern agreader_t AgReader;
+extern int AgLineNum;
+extern char *AgInputFile;
+Agraph_t *agfastconcat(Agraph_t * g, void *chan, Agdisc_t * disc);
+Agraph_t *agfastmemread(const char *cp, Agdisc_t * disc);
 int aagparse(void);
 void aglexinit(Agdisc_t * disc, void *ifile);
 int aaglex(void);
@@ -155,6 +155,8 @@ struct Agdesc_s {		/* graph descriptor */
     unsigned no_write:1;	/* if a temporary subgraph */
     unsigned has_attrs:1;	/* if string attr tables should be initialized */
     unsigned has_cmpnd:1;	/* if may contain collapsed nodes */
+    unsigned attrcols:1;	/* if string attrs are stored by column */
+    unsigned arena:1;		/* if allocated from slabs, freed at once */
 };
 
 /* disciplines for external resources needed by libgraph */
@@ -200,10 +202,14 @@ struct Agdisc_s {		/* user's discipline */
 /*end visual studio*/
 
 extern Agmemdisc_t AgMemDisc;
+extern Agmemdisc_t AgArenaMemDisc;
 extern Agiddisc_t AgIdDisc;
 extern Agiodisc_t AgIoDisc;
+extern Agiodisc_t AgMmapIoDisc;	/* read FILE channels in place */
 
 extern Agdisc_t AgDefaultDisc;
+extern Agdisc_t AgMmapDisc;
+extern Agdisc_t AgArenaDisc;
 #undef extern
 
 struct Agdstate_s {
@@ -240,6 +246,7 @@ struct Agclos_s {
     unsigned char callbacks_enabled;	/* issue user callbacks or hold them? */
     Dict_t *lookup_by_name[3];
     Dict_t *lookup_by_id[3];
+    struct Agattrcols_s *attrcols;	/* attribute columns, if desc.attrcols */
 };
 
 struct Agraph_s {
@@ -277,6 +284,8 @@ extern Agraph_t *agmemread(const char *cp);
 extern void agreadline(int);
 extern void agsetfile(char *);
 extern Agraph_t *agconcat(Agraph_t * g, void *chan, Agdisc_t * disc);
+typedef enum { AGREAD_YACC, AGREAD_FAST } agreader_t;
+extern agreader_t agsetreader(agreader_t);	/* return prev value */
 extern int agwrite(Agraph_t * g, void *chan);
 extern int agisdirected(Agraph_t * g);
 extern int agisundirected(Agraph_t * g);
@@ -335,7 +344,7 @@ extern char *agcanonStr(char *str);  /* manages its own buf */
 struct Agattr_s {		/* dynamic string attributes */
     Agrec_t h;			/* common data header */
     Dict_t *dict;		/* shared dict to interpret attr field */
-    char **str;			/* the attribute string values */
+    char **str;			/* the attribute string values, unless desc.attrcols */
 };
 
 struct Agsym_s {		/* symbol in one of the above dictionaries */
@@ -373,6 +382,7 @@ extern char *agxget(void *obj, Agsym_t * sym);
 extern int agset(void *obj, char *name, char *value);
 extern int agxset(void *obj, Agsym_t * sym, char *value);
 extern int agsafeset(void* obj, char* name, char* value, char* def);
+extern char **agattrcol(Agraph_t * g, Agsym_t * sym, int *size);
 
 /* defintions for subgraphs */
 extern Agraph_t *agsubg(Agraph_t * g, char *name, int cflag);	/* constructor */
@@ -385,6 +395,25 @@ extern int agnnodes(Agraph_t * g), agnedges(Agraph_t * g), agnsubg(Agraph_t * g)
 extern int agdegree(Agraph_t * g, Agnode_t * n, int in, int out);
 extern int agcountuniqedges(Agraph_t * g, Agnode_t * n, int in, int out);
 
+/* read-only snapshot of the adjacency of a graph, in compressed sparse
+ * row form. invalid once nodes or edges of the graph are changed. */
+typedef struct Agcsr_s {
+    Agraph_t *g;
+    int nnodes, nedges;
+    Agnode_t **node;		/* nodes, in sequence order */
+    Agedge_t **edge;		/* edges, grouped by tail in out-edge order */
+    int *outoff;		/* out-edges of node[i] are edge[outoff[i] .. outoff[i+1]-1] */
+    int *head, *tail;		/* node indices of the ends of edge[k] */
+    int *inoff;			/* in-edges of node[i] are edge[in[inoff[i] .. inoff[i+1]-1]] */
+    int *in;
+    int ncol;			/* edge attribute columns */
+    double **col;
+} Agcsr_t;
+
+extern Agcsr_t *agcsr(Agraph_t * g);
+extern double *agcsrcol(Agcsr_t * csr, Agsym_t * sym, double dflt);
+extern void agcsrfree(Agcsr_t * csr);
+
 /* memory */
 extern void *agalloc(Agraph_t * g, size_t size);
 extern void *agrealloc(Agraph_t * g, void *ptr, size_t oldsize,
@@ -0,0 +1,141 @@
+/* $Id$ $Revision$ */
+/* vim:set shiftwidth=4 ts=8: */
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property 
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: See CVS logs. Details at http://www.graphviz.org/
+ *************************************************************************/
+
+#include <cghdr.h>
+
+/* Compressed sparse row snapshots of a graph, so that layout code can
+ * run over arrays rather than walk the node and edge dictionaries each
+ * time it needs the adjacency. The storage comes from the root graph.
+ */
+
+Agcsr_t *agcsr(Agraph_t * g)
+{
+    Agraph_t *root = agroot(g);
+    Agcsr_t *csr;
+    Agnode_t *n;
+    Agedge_t *e;
+    IDTYPE maxseq = 0;
+    int *idx, i, k;
+
+    csr = agnew(root, Agcsr_t);
+    csr->g = g;
+    csr->nnodes = agnnodes(g);
+    csr->nedges = agnedges(g);
+    csr->node = agnnew(root, csr->nnodes + 1, Agnode_t *);
+    csr->edge = agnnew(root, csr->nedges + 1, Agedge_t *);
+    csr->outoff = agnnew(root, csr->nnodes + 1, int);
+    csr->inoff = agnnew(root, csr->nnodes + 1, int);
+    csr->head = agnnew(root, csr->nedges + 1, int);
+    csr->tail = agnnew(root, csr->nedges + 1, int);
+    csr->in = agnnew(root, csr->nedges + 1, int);
+
+    /* node indices, by sequence number */
+    i = 0;
+    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	csr->node[i++] = n;
+	if (AGSEQ(n) > maxseq)
+	    maxseq = AGSEQ(n);
+    }
+    idx = agnnew(root, maxseq + 1, int);
+    for (i = 0; i < csr->nnodes; i++)
+	idx[AGSEQ(csr->node[i])] = i;
+
+    k = 0;
+    for (i = 0; i < csr->nnodes; i++) {
+	csr->outoff[i] = k;
+	for (e = agfstout(g, csr->node[i]); e; e = agnxtout(g, e)) {
+	    csr->edge[k] = e;
+	    csr->tail[k] = i;
+	    csr->head[k] = idx[AGSEQ(aghead(e))];
+	    csr->inoff[csr->head[k]]++;
+	    k++;
+	}
+    }
+    csr->outoff[i] = k;
+    agfree(root, idx);
+
+    /* in-edges by counting sort on the head, so each node's in-edges
+     * are ordered by tail index */
+    k = 0;
+    for (i = 0; i < csr->nnodes; i++) {
+	int d = csr->inoff[i];
+	csr->inoff[i] = k;
+	k += d;
+    }
+    csr->inoff[i] = k;
+    for (k = 0; k < csr->nedges; k++)
+	csr->in[csr->inoff[csr->head[k]]++] = k;
+    for (i = csr->nnodes; i > 0; i--)
+	csr->inoff[i] = csr->inoff[i - 1];
+    csr->inoff[0] = 0;
+
+    return csr;
+}
+
+/* the values of an edge attribute as numbers, in edge order. an edge
+ * whose value does not start with a number, or any edge if sym is NULL,
+ * gets dflt. the column is freed with the snapshot. if the graph stores
+ * its attributes by column, the values are read from there.
+ */
+double *agcsrcol(Agcsr_t * csr, Agsym_t * sym, double dflt)
+{
+    Agraph_t *root = agroot(csr->g);
+    double *col, v;
+    char **vals = NIL(char **);
+    char *s, *p;
+    int k, nvals;
+
+    if (sym)
+	vals = agattrcol(root, sym, &nvals);
+    col = agnnew(root, csr->nedges + 1, double);
+    for (k = 0; k < csr->nedges; k++) {
+	v = dflt;
+	if (vals)
+	    s = vals[AGSEQ(csr->edge[k])];
+	else if (sym)
+	    s = agxget(csr->edge[k], sym);
+	else
+	    s = NIL(char *);
+	if (s && *s) {
+	    v = strtod(s, &p);
+	    if (p == s)
+		v = dflt;
+	}
+	col[k] = v;
+    }
+    csr->col = agrealloc(root, csr->col, csr->ncol * sizeof(double *),
+			 (csr->ncol + 1) * sizeof(double *));
+    csr->col[csr->ncol++] = col;
+    return col;
+}
+
+void agcsrfree(Agcsr_t * csr)
+{
+    Agraph_t *root;
+    int i;
+
+    if (!csr)
+	return;
+    root = agroot(csr->g);
+    for (i = 0; i < csr->ncol; i++)
+	agfree(root, csr->col[i]);
+    agfree(root, csr->col);
+    agfree(root, csr->node);
+    agfree(root, csr->edge);
+    agfree(root, csr->outoff);
+    agfree(root, csr->inoff);
+    agfree(root, csr->head);
+    agfree(root, csr->tail);
+    agfree(root, csr->in);
+    agfree(root, csr);
+}
@@ -0,0 +1,1173 @@
+/* $Id$ $Revision$ */
+/* vim:set shiftwidth=4 ts=8: */
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: See CVS logs. Details at http://www.graphviz.org/
+ *************************************************************************/
+
+/*
+ * A hand-written reader for the graph file language, used by agread,
+ * agconcat and agmemread after agsetreader(AGREAD_FAST), and by agread
+ * and agconcat for channels read with AgMmapIoDisc.
+ *
+ * The input is scanned in place from a single buffer, which is mapped
+ * from the file when the channel is a regular file read through
+ * AgIoDisc or AgMmapIoDisc, and otherwise holds the text of the graph
+ * being read, read in chunks up to its closing brace. Statements are
+ * carried out as they are recognized, in the same order as the actions
+ * of grammar.y, so the graph, including the sequence numbers of its
+ * objects and the ids of its attributes, is the one the yacc parser
+ * builds. Names and values are handed to cgraph straight from a scratch
+ * buffer, so each string is interned once, when it is stored; only html
+ * strings are interned as they are scanned, to keep their mark.
+ */
+
+#include <stdio.h>
+#include <limits.h>
+#include <setjmp.h>
+#include <cghdr.h>
+#include <agxbuf.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+
+agreader_t AgReader = AGREAD_YACC;
+
+agreader_t agsetreader(agreader_t reader)
+{
+    agreader_t prev = AgReader;
+
+    AgReader = reader;
+    return prev;
+}
+
+/* tokens other than single characters */
+#define T_eof		256
+#define T_atom		257
+#define T_qatom		258
+#define T_graph		259
+#define T_node		260
+#define T_edge		261
+#define T_digraph	262
+#define T_subgraph	263
+#define T_strict	264
+#define T_edgeop	265
+
+typedef struct {		/* value of an atom */
+    size_t off;			/* text in Strs, unless ref is set */
+    char *ref;			/* interned html string */
+} str_t;
+
+typedef struct {		/* an attribute assignment */
+    str_t name, value;
+    Agsym_t *sym;		/* once bound */
+} attr_t;
+
+typedef struct {		/* a node of a node list */
+    Agnode_t *n;
+    str_t port;			/* port.off == NOPORT if none */
+} nitem_t;
+
+typedef struct {		/* operand of an edge statement */
+    Agraph_t *subg;		/* a subgraph, or */
+    int first, last;		/* the node list Nodes[first..last-1] */
+} simple_t;
+
+typedef struct {		/* interned string to free */
+    Agraph_t *g;
+    char *s;
+} ref_t;
+
+#define NOPORT	((size_t) -1)
+
+/* stacks of the statements being processed. Statements nest
+ * through subgraphs, so each one pops back to where it started.
+ */
+#define STACK(t) struct { t *v; int n, size; }
+static struct {
+    char *v;
+    size_t n, size;
+} Strs;
+static STACK(attr_t) Attrs;
+static STACK(nitem_t) Nodes;
+static STACK(simple_t) Simples;
+static STACK(ref_t) Refs;
+
+#define PUSH(s) ((s).n < (s).size ? &(s).v[(s).n++] : \
+    (grow((void **) &(s).v, &(s).size, sizeof((s).v[0])), &(s).v[(s).n++]))
+
+typedef struct {
+    size_t strs;
+    int attrs, nodes, simples, refs;
+} mark_t;
+
+static struct {			/* the input */
+    const char *start, *p, *end;
+    int type;			/* current token */
+    const char *tok;		/* its text */
+    size_t toklen;
+    str_t val;			/* its value, if an atom */
+    int graphtype;		/* T_graph or T_digraph, once seen */
+} In;
+
+static Agraph_t *G;		/* top level graph */
+static Agdisc_t *Disc;
+static jmp_buf Jbuf;
+static char Key[] = "key";
+
+static void grow(void **v, int *size, size_t sz)
+{
+    int nsize = (*size ? 2 * *size : 64);
+
+    *v = realloc(*v, (size_t) nsize * sz);
+    *size = nsize;
+}
+
+static size_t strreserve(size_t n)
+{
+    if (Strs.n + n > Strs.size) {
+	while (Strs.n + n > Strs.size)
+	    Strs.size = (Strs.size ? 2 * Strs.size : BUFSIZ);
+	Strs.v = realloc(Strs.v, Strs.size);
+    }
+    return Strs.n;
+}
+
+static void strput(const char *s, size_t n)
+{
+    strreserve(n);
+    memcpy(Strs.v + Strs.n, s, n);
+    Strs.n += n;
+}
+
+static void strputc(char c)
+{
+    strreserve(1);
+    Strs.v[Strs.n++] = c;
+}
+
+#define STR(x)	((x).ref ? (x).ref : Strs.v + (x).off)
+
+static void addref(Agraph_t * g, char *s)
+{
+    ref_t *r = PUSH(Refs);
+
+    r->g = g;
+    r->s = s;
+}
+
+static void getmark(mark_t * m)
+{
+    m->strs = Strs.n;
+    m->attrs = Attrs.n;
+    m->nodes = Nodes.n;
+    m->simples = Simples.n;
+    m->refs = Refs.n;
+}
+
+#define ISATOM(t)	(((t) == T_atom) || ((t) == T_qatom))
+
+/* pop the stacks back to m. the lookahead token was scanned
+ * after m was taken, so its value is kept.
+ */
+static void release(mark_t * m)
+{
+    ref_t look;
+    int keepref = FALSE;
+    size_t len;
+
+    if (ISATOM(In.type) && In.val.ref && (Refs.n > m->refs)
+	&& (Refs.v[Refs.n - 1].s == In.val.ref)) {
+	look = Refs.v[--Refs.n];
+	keepref = TRUE;
+    }
+    while (Refs.n > m->refs) {
+	Refs.n--;
+	agstrfree(Refs.v[Refs.n].g, Refs.v[Refs.n].s);
+    }
+    if (keepref)
+	*PUSH(Refs) = look;
+    if (ISATOM(In.type) && !In.val.ref && (In.val.off >= m->strs)) {
+	len = strlen(Strs.v + In.val.off) + 1;
+	memmove(Strs.v + m->strs, Strs.v + In.val.off, len);
+	In.val.off = m->strs;
+	Strs.n = m->strs + len;
+    } else
+	Strs.n = m->strs;
+    Attrs.n = m->attrs;
+    Nodes.n = m->nodes;
+    Simples.n = m->simples;
+}
+
+/* the scanner. this follows the rules of scan.l, including
+ * its handling of newlines within quoted strings.
+ */
+
+#define ISLETTER(c)	(isalpha(c) || ((c) == '_') || ((c) >= 0200))
+
+static void errtok(char *msg);
+
+static int keyword(const char *s, size_t len, const char *kw)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++)
+	if (!kw[i] || (tolower((unsigned char) s[i]) != kw[i]))
+	    return FALSE;
+    return (kw[len] == '\0');
+}
+
+/* process a possible preprocessor line directive, as in scan.l */
+static void ppdirective(const char *s, const char *e)
+{
+    static char *fname;
+    int r, cnt, lineno;
+    char buf[2];
+    char *line, *p, *q;
+    size_t off;
+
+    off = Strs.n;
+    strput(s, (size_t) (e - s));
+    strputc('\0');
+    line = Strs.v + off + 1;	/* skip initial # */
+    if (strncmp(line, "line", 4) == 0)
+	line += 4;
+    r = sscanf(line, "%d %1[\"]%n", &lineno, buf, &cnt);
+    if (r > 0) {
+	AgLineNum = lineno - 1;
+	if (r > 1) {
+	    p = q = line + cnt;
+	    while (*q && (*q != '"'))
+		q++;
+	    if ((q != p) && (*q == '"')) {
+		*q = '\0';
+		fname = realloc(fname, (size_t) (q - p) + 1);
+		strcpy(fname, p);
+		AgInputFile = fname;
+	    }
+	}
+    }
+    Strs.n = off;
+}
+
+/* a number may end in a letter or a second '.', which is then
+ * split off as in scan.l's chkNum.
+ */
+static const char *chknum(const char *s, const char *e)
+{
+    unsigned char c = (unsigned char) e[-1];
+    const char *p;
+    int twodots = FALSE;
+    agxbuf xb;
+    unsigned char xbuf[BUFSIZ];
+    char buf[BUFSIZ];
+
+    if (c == '.') {
+	for (p = e - 2; p >= s; p--)
+	    if (*p == '.')
+		twodots = TRUE;
+    }
+    if ((!isdigit(c) && (c != '.')) || twodots) {
+	agxbinit(&xb, BUFSIZ, xbuf);
+	agxbput(&xb, "syntax ambiguity - badly delimited number '");
+	agxbput_n(&xb, s, (size_t) (e - s));
+	sprintf(buf, "' in line %d of ", AgLineNum);
+	agxbput(&xb, buf);
+	agxbput(&xb, AgInputFile ? AgInputFile : "input");
+	agxbput(&xb, " splits into two tokens\n");
+	agerr(AGWARN, "%s", agxbuse(&xb));
+	agxbfree(&xb);
+	return e - 1;
+    }
+    return e;
+}
+
+static void qstring(const char *p)
+{
+    const char *end = In.end, *q;
+
+    In.val.ref = NILstr;
+    In.val.off = Strs.n;
+    for (p++; (p < end) && (*p != '"');) {
+	if (*p == '\\') {
+	    if ((p + 1 < end) && (p[1] == '"')) {
+		strputc('"');
+		p += 2;
+	    } else if ((p + 1 < end) && (p[1] == '\\')) {
+		strput("\\\\", 2);
+		p += 2;
+	    } else if ((p + 1 < end) && (p[1] == '\n')) {
+		AgLineNum++;	/* ignore escaped newlines */
+		p += 2;
+	    } else {
+		strputc('\\');
+		p++;
+	    }
+	} else {
+	    for (q = p; (q < end) && (*q != '"') && (*q != '\\'); q++);
+	    if ((q == p + 1) && (*p == '\n'))
+		AgLineNum++;	/* a lone newline is dropped by flex */
+	    else
+		strput(p, (size_t) (q - p));
+	    p = q;
+	}
+    }
+    if (p >= end) {
+	In.p = end;
+	errtok(" scanning a quoted string (missing endquote?)");
+    }
+    strputc('\0');
+    In.p = p + 1;
+}
+
+static void hstring(const char *p)
+{
+    const char *end = In.end, *q;
+    int nest = 1;
+    size_t off = Strs.n;
+
+    for (p++; p < end;) {
+	if (*p == '>') {
+	    if (--nest == 0)
+		break;
+	    strputc(*p++);
+	} else if (*p == '<') {
+	    nest++;
+	    strputc(*p++);
+	} else if (*p == '\n') {
+	    AgLineNum++;
+	    strputc(*p++);
+	} else {
+	    for (q = p; (q < end) && (*q != '>') && (*q != '<')
+		 && (*q != '\n'); q++);
+	    strput(p, (size_t) (q - p));
+	    p = q;
+	}
+    }
+    if (p >= end) {
+	In.p = end;
+	errtok(" scanning a HTML string (missing '>'? bad nesting?)");
+    }
+    strputc('\0');
+    In.val.ref = agstrdup_html(Ag_G_global, Strs.v + off);
+    In.val.off = 0;
+    addref(Ag_G_global, In.val.ref);
+    Strs.n = off;
+    In.p = p + 1;
+}
+
+static int lex(void)
+{
+    const char *p = In.p, *end = In.end, *q;
+    unsigned char c;
+    int t;
+
+    for (;;) {
+	if (p >= end) {
+	    In.p = In.tok = end;
+	    In.toklen = 0;
+	    return (In.type = T_eof);
+	}
+	c = (unsigned char) *p;
+	if (c == '\n') {
+	    AgLineNum++;
+	    p++;
+	} else if ((c == ' ') || (c == '\t') || (c == '\r'))
+	    p++;
+	else if ((c == '/') && (p + 1 < end) && (p[1] == '*')) {
+	    for (p += 2; (p < end)
+		 && !((*p == '*') && (p + 1 < end) && (p[1] == '/')); p++)
+		if (*p == '\n')
+		    AgLineNum++;
+	    p = (p < end ? p + 2 : end);
+	} else if ((c == '/') && (p + 1 < end) && (p[1] == '/')) {
+	    while ((p < end) && (*p != '\n'))
+		p++;
+	} else if (c == '#') {
+	    for (q = p; (q < end) && (*q != '\n'); q++);
+	    if ((p == In.start) || (p[-1] == '\n'))
+		ppdirective(p, q);
+	    p = q;
+	} else if ((c == 0xEF) && (p + 2 < end)
+		   && ((unsigned char) p[1] == 0xBB)
+		   && ((unsigned char) p[2] == 0xBF))
+	    p += 3;		/* ignore BOM */
+	else
+	    break;
+    }
+
+    In.tok = p;
+    t = c;
+    if (ISLETTER(c)) {
+	for (q = p + 1; (q < end) && (ISLETTER((unsigned char) *q)
+				      || isdigit((unsigned char) *q)); q++);
+	if (keyword(p, (size_t) (q - p), "node"))
+	    t = T_node;
+	else if (keyword(p, (size_t) (q - p), "edge"))
+	    t = T_edge;
+	else if (keyword(p, (size_t) (q - p), "graph")) {
+	    if (!In.graphtype)
+		In.graphtype = T_graph;
+	    t = T_graph;
+	} else if (keyword(p, (size_t) (q - p), "digraph")) {
+	    if (!In.graphtype)
+		In.graphtype = T_digraph;
+	    t = T_digraph;
+	} else if (keyword(p, (size_t) (q - p), "strict"))
+	    t = T_strict;
+	else if (keyword(p, (size_t) (q - p), "subgraph"))
+	    t = T_subgraph;
+	else
+	    t = T_atom;
+    } else if (isdigit(c) || (c == '.') || (c == '-')) {
+	/* [-]?(({DIGIT}+(\.{DIGIT}*)?)|(\.{DIGIT}+))(\.|{LETTER})? */
+	q = (c == '-' ? p + 1 : p);
+	if ((q < end) && isdigit((unsigned char) *q)) {
+	    while ((q < end) && isdigit((unsigned char) *q))
+		q++;
+	    if ((q < end) && (*q == '.'))
+		for (q++; (q < end) && isdigit((unsigned char) *q); q++);
+	} else if ((q + 1 < end) && (*q == '.')
+		   && isdigit((unsigned char) q[1])) {
+	    for (q++; (q < end) && isdigit((unsigned char) *q); q++);
+	} else
+	    q = p;
+	if (q > p) {
+	    if ((q < end) && ((*q == '.') || ISLETTER((unsigned char) *q)))
+		q = chknum(p, q + 1);
+	    t = T_atom;
+	} else if ((c == '-') && (p + 1 < end)
+		   && ((p[1] == '>') || (p[1] == '-'))) {
+	    q = p + 2;
+	    if (((p[1] == '>') && (In.graphtype == T_digraph))
+		|| ((p[1] == '-') && (In.graphtype == T_graph)))
+		t = T_edgeop;
+	} else
+	    q = p + 1;
+    } else if (c == '"') {
+	qstring(p);
+	In.toklen = (size_t) (In.p - p);
+	return (In.type = T_qatom);
+    } else if (c == '<') {
+	hstring(p);
+	In.toklen = (size_t) (In.p - p);
+	return (In.type = T_qatom);
+    } else
+	q = p + 1;
+
+    if (t == T_atom) {
+	In.val.ref = NILstr;
+	In.val.off = Strs.n;
+	strput(p, (size_t) (q - p));
+	strputc('\0');
+    } else if (c == '@')
+	t = T_eof;
+    In.p = q;
+    In.toklen = (size_t) (q - p);
+    return (In.type = t);
+}
+
+/* the parser, with the actions of grammar.y */
+
+static void errtok(char *msg)
+{
+    agxbuf xb;
+    unsigned char xbuf[BUFSIZ];
+    char buf[BUFSIZ];
+
+    agxbinit(&xb, BUFSIZ, xbuf);
+    if (AgInputFile) {
+	agxbput(&xb, AgInputFile);
+	agxbput(&xb, ": ");
+    }
+    agxbput(&xb, "syntax error");
+    sprintf(buf, " in line %d", AgLineNum);
+    agxbput(&xb, buf);
+    if (msg)
+	agxbput(&xb, msg);
+    else if (In.toklen) {
+	agxbput(&xb, " near '");
+	agxbput_n(&xb, In.tok, In.toklen);
+	agxbputc(&xb, '\'');
+    }
+    agxbputc(&xb, '\n');
+    agerr(AGERR, "%s", agxbuse(&xb));
+    agxbfree(&xb);
+    longjmp(Jbuf, 1);
+}
+
+static void expect(int t)
+{
+    if (In.type != t)
+	errtok(NIL(char *));
+    lex();
+}
+
+
+static void atom(str_t * v)
+{
+    size_t la, lb;
+    str_t b;
+
+    if (In.type == T_atom) {
+	*v = In.val;
+	lex();
+	return;
+    }
+    if (In.type != T_qatom)
+	errtok(NIL(char *));
+    *v = In.val;
+    while (lex() == '+') {
+	if (lex() != T_qatom)
+	    errtok(NIL(char *));
+	b = In.val;
+	/* as concat() in grammar.y, the result is not an html string */
+	la = strlen(STR(*v));
+	lb = strlen(STR(b));
+	strreserve(la + lb + 1);
+	memcpy(Strs.v + Strs.n, STR(*v), la);
+	memcpy(Strs.v + Strs.n + la, STR(b), lb + 1);
+	v->ref = NILstr;
+	v->off = Strs.n;
+	Strs.n += la + lb + 1;
+    }
+}
+
+static void attrlist(void)
+{
+    attr_t *a;
+    str_t name, value;
+
+    expect('[');
+    while (In.type != ']') {
+	atom(&name);
+	expect('=');
+	atom(&value);
+	a = PUSH(Attrs);
+	a->name = name;
+	a->value = value;
+	a->sym = NILsym;
+	if ((In.type == ';') || (In.type == ','))
+	    lex();
+    }
+    lex();
+}
+
+static int iskey(attr_t * a)
+{
+    return streq(STR(a->name), Key);
+}
+
+/* g is the graph whose body holds the statement, S->g in grammar.y,
+ * in which the attributes are looked up and, if new, declared.
+ */
+static void bindattrs(Agraph_t * g, int kind, int from)
+{
+    attr_t *a;
+    char *name;
+
+    for (a = Attrs.v + from; a < Attrs.v + Attrs.n; a++) {
+	if ((kind == AGEDGE) && iskey(a))
+	    continue;
+	name = STR(a->name);
+	if ((a->sym = agattr(g, kind, name, NIL(char *))) == NILsym)
+	    a->sym = agattr(g, kind, name, "");
+    }
+}
+
+static void applyattrs(void *obj, int from)
+{
+    attr_t *a;
+
+    for (a = Attrs.v + from; a < Attrs.v + Attrs.n; a++)
+	if (a->sym)
+	    agxset(obj, a->sym, STR(a->value));
+}
+
+static void attrstmt(Agraph_t * g, int kind, int from)
+{
+    attr_t *a;
+    Agsym_t *sym;
+
+    bindattrs(g, kind, from);
+    for (a = Attrs.v + from; a < Attrs.v + Attrs.n; a++) {
+	if (!a->sym)
+	    continue;
+	if (!(a->sym->fixed) || (g != G))
+	    sym = agattr(g, kind, a->sym->name, STR(a->value));
+	else
+	    sym = a->sym;
+	if (g == G)
+	    sym->print = TRUE;
+    }
+}
+
+static void stmt(Agraph_t * g);
+
+static void body(Agraph_t * g, int top)
+{
+    if (In.type != '{')
+	errtok(NIL(char *));
+    lex();
+    while (In.type != '}') {
+	if (In.type == T_eof)
+	    errtok(NIL(char *));
+	stmt(g);
+    }
+    if (!top)			/* leave the input after the graph untouched */
+	lex();
+}
+
+static void node(Agraph_t * g, str_t * name)
+{
+    nitem_t *item;
+    str_t port, sport;
+    size_t lp, ls;
+
+    port.off = NOPORT;
+    port.ref = NILstr;
+    if (In.type == ':') {
+	lex();
+	atom(&port);
+	if (In.type == ':') {	/* as concatPort() in grammar.y */
+	    lex();
+	    atom(&sport);
+	    lp = strlen(STR(port));
+	    ls = strlen(STR(sport));
+	    strreserve(lp + ls + 2);
+	    memcpy(Strs.v + Strs.n, STR(port), lp);
+	    Strs.v[Strs.n + lp] = ':';
+	    memcpy(Strs.v + Strs.n + lp + 1, STR(sport), ls + 1);
+	    port.ref = NILstr;
+	    port.off = Strs.n;
+	    Strs.n += lp + ls + 2;
+	}
+    }
+    item = PUSH(Nodes);
+    item->n = agnode(g, STR(*name), TRUE);
+    item->port = port;
+}
+
+/* a node list or subgraph; name is the first node if already scanned */
+static void simple(Agraph_t * g, str_t * name)
+{
+    simple_t *s;
+    Agraph_t *subg;
+    int first = Nodes.n;
+    str_t v;
+
+    if (name || ISATOM(In.type)) {
+	for (;;) {
+	    if (!name) {
+		atom(&v);
+		name = &v;
+	    }
+	    node(g, name);
+	    name = NIL(str_t *);
+	    if (In.type != ',')
+		break;
+	    lex();
+	}
+	subg = NILgraph;
+    } else {
+	v.ref = NILstr;
+	v.off = NOPORT;
+	if (In.type == T_subgraph) {
+	    lex();
+	    if (ISATOM(In.type))
+		atom(&v);
+	}
+	if (In.type != '{')
+	    errtok(NIL(char *));
+	subg = agsubg(g, (v.off == NOPORT ? NIL(char *) : STR(v)), TRUE);
+	body(subg, FALSE);
+    }
+    s = PUSH(Simples);
+    s->subg = subg;
+    s->first = first;
+    s->last = Nodes.n;
+}
+
+/* as mkport() in grammar.y, in the graph holding the edge statement */
+static Agsym_t *portsym(Agraph_t * g, char *name)
+{
+    Agsym_t *attr;
+
+    if ((attr = agattr(g, AGEDGE, name, NIL(char *))) == NILsym)
+	attr = agattr(g, AGEDGE, name, "");
+    return attr;
+}
+
+typedef struct {		/* per edge statement */
+    char *key;
+    int attrs;			/* first attribute */
+    Agsym_t *tailport, *headport;	/* bound on first use */
+} estate_t;
+
+static void newedge(Agraph_t * g, estate_t * st, Agnode_t * t, char *tport,
+		    Agnode_t * h, char *hport)
+{
+    Agedge_t *e;
+    char *tp, *hp, *temp;
+
+    e = agedge(g, t, h, st->key, TRUE);
+    if (e) {			/* can fail if graph is strict and t==h */
+	tp = tport;
+	hp = hport;
+	if ((agtail(e) != aghead(e)) && (aghead(e) == t)) {
+	    /* could happen with an undirected edge */
+	    temp = tp;
+	    tp = hp;
+	    hp = temp;
+	}
+	if (tp) {
+	    if (!st->tailport)
+		st->tailport = portsym(g, TAILPORT_ID);
+	    agxset(e, st->tailport, tp);
+	}
+	if (hp) {
+	    if (!st->headport)
+		st->headport = portsym(g, HEADPORT_ID);
+	    agxset(e, st->headport, hp);
+	}
+	applyattrs(e, st->attrs);
+    }
+}
+
+static char *portof(nitem_t * item)
+{
+    return (item->port.off == NOPORT ? NIL(char *) : STR(item->port));
+}
+
+static void edgerhs(Agraph_t * g, estate_t * st, Agnode_t * tail,
+		    char *tport, simple_t * hs)
+{
+    Agnode_t *head;
+    int i;
+
+    if (hs->subg) {
+	for (head = agfstnode(hs->subg); head;
+	     head = agnxtnode(hs->subg, head))
+	    newedge(g, st, tail, tport, agsubnode(g, head, FALSE),
+		    NIL(char *));
+    } else {
+	/* list nodes were made in g, so need no agsubnode() */
+	for (i = hs->first; i < hs->last; i++)
+	    newedge(g, st, tail, tport, Nodes.v[i].n, portof(&Nodes.v[i]));
+    }
+}
+
+static void endedge(Agraph_t * g, int simples, int attrs)
+{
+    estate_t st;
+    simple_t *s;
+    attr_t *a;
+    Agnode_t *t;
+    int i;
+
+    bindattrs(g, AGEDGE, attrs);
+
+    /* look for "key" pseudo-attribute */
+    st.key = NIL(char *);
+    for (a = Attrs.v + attrs; a < Attrs.v + Attrs.n; a++)
+	if (iskey(a))
+	    st.key = STR(a->value);
+    st.attrs = attrs;
+    st.tailport = st.headport = NILsym;
+
+    /* can make edges with node lists or subgraphs */
+    for (s = Simples.v + simples; s + 1 < Simples.v + Simples.n; s++) {
+	if (s->subg) {
+	    for (t = agfstnode(s->subg); t; t = agnxtnode(s->subg, t))
+		edgerhs(g, &st, agsubnode(g, t, FALSE), NIL(char *), s + 1);
+	} else {
+	    for (i = s->first; i < s->last; i++)
+		edgerhs(g, &st, Nodes.v[i].n, portof(&Nodes.v[i]), s + 1);
+	}
+    }
+}
+
+static void compound(Agraph_t * g, str_t * name)
+{
+    int isedge = FALSE, simples = Simples.n, attrs = Attrs.n, i;
+
+    simple(g, name);
+    while (In.type == T_edgeop) {
+	isedge = TRUE;
+	lex();
+	simple(g, NIL(str_t *));
+    }
+    while (In.type == '[')
+	attrlist();
+    if (isedge)
+	endedge(g, simples, attrs);
+    else {
+	bindattrs(g, AGNODE, attrs);
+	if (!Simples.v[simples].subg)
+	    for (i = Simples.v[simples].first;
+		 i < Simples.v[simples].last; i++)
+		applyattrs(Nodes.v[i].n, attrs);
+    }
+}
+
+static void stmt(Agraph_t * g)
+{
+    mark_t m;
+    int kind;
+    str_t name;
+    attr_t *a;
+
+    getmark(&m);
+    switch (In.type) {
+    case T_graph:
+    case T_node:
+    case T_edge:
+	kind = (In.type == T_graph ? AGRAPH :
+		In.type == T_node ? AGNODE : AGEDGE);
+	lex();
+	if (ISATOM(In.type)) {
+	    atom(&name);
+	    expect('=');
+	    agerr(AGWARN, "attribute macros not implemented");
+	}
+	if (In.type != '[')
+	    errtok(NIL(char *));
+	while (In.type == '[')
+	    attrlist();
+	attrstmt(g, kind, m.attrs);
+	break;
+    case T_atom:
+    case T_qatom:
+	atom(&name);
+	if (In.type == '=') {
+	    lex();
+	    a = PUSH(Attrs);
+	    a->name = name;
+	    atom(&a->value);
+	    a->sym = NILsym;
+	    attrstmt(g, AGRAPH, m.attrs);
+	} else
+	    compound(g, &name);
+	break;
+    case T_subgraph:
+    case '{':
+	compound(g, NIL(str_t *));
+	break;
+    default:
+	errtok(NIL(char *));
+    }
+    if (In.type == ';')
+	lex();
+    release(&m);
+}
+
+static void graph(Agraph_t * g)
+{
+    int strict = FALSE, directed;
+    str_t name;
+    char *s = NIL(char *);
+    Agdesc_t req;
+
+    if (lex() == T_eof)
+	return;
+    if (In.type == T_strict) {
+	strict = TRUE;
+	lex();
+    }
+    if ((In.type != T_graph) && (In.type != T_digraph))
+	errtok(NIL(char *));
+    directed = (In.type == T_digraph);
+    lex();
+    if (ISATOM(In.type)) {
+	atom(&name);
+	s = STR(name);
+    }
+    if (g == NILgraph) {
+	if (directed)
+	    req = (strict ? Agstrictdirected : Agdirected);
+	else
+	    req = (strict ? Agstrictundirected : Agundirected);
+	g = agopen(s, req, Disc);
+    }
+    Ag_G_global = G = g;
+    body(G, TRUE);
+    aginternalmapclearlocalnames(G);
+}
+
+/* read a graph from the input In.start[0..len-1]. the part of the
+ * input that was read is returned in *used.
+ */
+static Agraph_t *parse(Agraph_t * g, Agdisc_t * disc, const char *buf,
+		       size_t len, size_t * used)
+{
+    mark_t m;
+
+    In.start = In.p = buf;
+    In.end = buf + len;
+    In.graphtype = 0;
+    Disc = (disc ? disc : &AgDefaultDisc);
+    G = NILgraph;
+    Ag_G_global = NILgraph;
+    getmark(&m);
+    if (setjmp(Jbuf)) {
+	release(&m);
+	if (G) {
+	    aginternalmapclearlocalnames(G);
+	    agclose(G);
+	}
+	G = Ag_G_global = NILgraph;
+	*used = len;		/* as yacc's error recovery, skip the rest */
+	return NILgraph;
+    }
+    graph(g);
+    release(&m);
+    *used = (size_t) (In.p - buf);
+    return G;
+}
+
+/* input read from a channel that is not mapped: the text of the graph
+ * being read, and whatever followed it in the last chunk read, which
+ * is kept for the next graph read from the same channel. The scan for
+ * the end of the graph is resumed as each chunk arrives.
+ */
+typedef enum { S_CODE, S_STRING, S_ESCAPE, S_HTML, S_SLASH, S_LINE,
+    S_COMMENT, S_STAR
+} scan_t;
+
+static struct {
+    void *chan;
+    Agiodisc_t *io;
+    char *buf;
+    size_t cur, len, size;
+    int eof;
+    size_t scanned;		/* end of the text scanned so far */
+    scan_t state;
+    int depth, html, bol;
+} Pending;
+
+/* scan the text read since the last call; return TRUE when it holds the
+ * closing brace of the graph. The scan follows the lexical rules of
+ * lex() only as far as is needed to tell which braces count.
+ */
+static int graphend(void)
+{
+    char c;
+
+    while (Pending.scanned < Pending.len) {
+	c = Pending.buf[Pending.scanned];
+	switch (Pending.state) {
+	case S_CODE:
+	    if (c == '"')
+		Pending.state = S_STRING;
+	    else if (c == '<') {
+		Pending.state = S_HTML;
+		Pending.html = 1;
+	    } else if (c == '/')
+		Pending.state = S_SLASH;
+	    else if ((c == '#') && Pending.bol)
+		Pending.state = S_LINE;
+	    else if (c == '{')
+		Pending.depth++;
+	    else if ((c == '}') && (Pending.depth > 0)
+		     && (--Pending.depth == 0)) {
+		Pending.scanned++;
+		return TRUE;
+	    }
+	    break;
+	case S_STRING:
+	    if (c == '\\')
+		Pending.state = S_ESCAPE;
+	    else if (c == '"')
+		Pending.state = S_CODE;
+	    break;
+	case S_ESCAPE:
+	    Pending.state = S_STRING;
+	    break;
+	case S_HTML:
+	    if (c == '<')
+		Pending.html++;
+	    else if ((c == '>') && (--Pending.html == 0))
+		Pending.state = S_CODE;
+	    break;
+	case S_SLASH:
+	    if (c == '/')
+		Pending.state = S_LINE;
+	    else if (c == '*')
+		Pending.state = S_COMMENT;
+	    else {
+		Pending.state = S_CODE;
+		continue;	/* c is not part of a comment */
+	    }
+	    break;
+	case S_LINE:
+	    if (c == '\n')
+		Pending.state = S_CODE;
+	    break;
+	case S_COMMENT:
+	    if (c == '*')
+		Pending.state = S_STAR;
+	    break;
+	case S_STAR:
+	    if (c == '/')
+		Pending.state = S_CODE;
+	    else if (c != '*')
+		Pending.state = S_COMMENT;
+	    break;
+	default:
+	    break;
+	}
+	Pending.bol = (c == '\n');
+	Pending.scanned++;
+    }
+    return FALSE;
+}
+
+#ifdef HAVE_SYS_MMAN_H
+/* the mapping of the file last read, kept until its end is reached
+ * so that reading each graph of a file does not map it again.
+ */
+static struct {
+    char *base;
+    size_t len;
+    dev_t dev;
+    ino_t ino;
+} Map;
+
+static void unmap(void)
+{
+    if (Map.base) {
+	munmap(Map.base, Map.len);
+	Map.base = NIL(char *);
+    }
+}
+
+/* if chan is a regular file read with the default discipline, map it
+ * and read from the current position, leaving the file positioned
+ * after the graph.
+ */
+static int mapread(Agraph_t * g, void *chan, Agdisc_t * disc,
+		   Agraph_t ** rv)
+{
+    FILE *fp = (FILE *) chan;
+    struct stat st;
+    long pos;
+    size_t off, len, used;
+    char *base;
+
+    if (((disc->io != &AgIoDisc) && (disc->io != &AgMmapIoDisc))
+	|| (fstat(fileno(fp), &st) < 0)
+	|| !S_ISREG(st.st_mode) || ((pos = ftell(fp)) < 0))
+	return FALSE;
+    off = (size_t) pos;
+    len = (size_t) st.st_size;
+    if (off >= len) {
+	unmap();
+	*rv = NILgraph;
+	return TRUE;
+    }
+    if (!Map.base || (Map.dev != st.st_dev) || (Map.ino != st.st_ino)
+	|| (Map.len != len)) {
+	unmap();
+	base = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+	if (base == MAP_FAILED)
+	    return FALSE;
+#ifdef MADV_SEQUENTIAL
+	madvise(base, len, MADV_SEQUENTIAL);
+#endif
+	Map.base = base;
+	Map.len = len;
+	Map.dev = st.st_dev;
+	Map.ino = st.st_ino;
+    }
+    *rv = parse(g, disc, Map.base + off, len - off, &used);
+    fseek(fp, (long) (off + used), SEEK_SET);
+    if (off + used >= len)
+	unmap();
+#if defined(MADV_DONTNEED) && defined(_SC_PAGESIZE)
+    else {
+	/* nothing is kept from the text of the graphs read so far,
+	 * so their pages need not stay resident
+	 */
+	size_t done = (off + used) & ~((size_t) sysconf(_SC_PAGESIZE) - 1);
+	if (done > 0)
+	    madvise(Map.base, done, MADV_DONTNEED);
+    }
+#endif
+    return TRUE;
+}
+#endif
+
+Agraph_t *agfastconcat(Agraph_t * g, void *chan, Agdisc_t * disc)
+{
+    Agraph_t *rv;
+    size_t used, n;
+    int r;
+
+    if (!disc)
+	disc = &AgDefaultDisc;
+#ifdef HAVE_SYS_MMAN_H
+    if (mapread(g, chan, disc, &rv))
+	return rv;
+#endif
+    if ((Pending.chan != chan) || (Pending.io != disc->io)) {
+	Pending.chan = chan;
+	Pending.io = disc->io;
+	Pending.cur = Pending.len = 0;
+	Pending.eof = FALSE;
+    }
+    /* drop the previous graph, and read up to the end of this one */
+    Pending.bol = (Pending.cur == 0) || (Pending.buf[Pending.cur - 1] == '\n');
+    if (Pending.cur > 0) {
+	Pending.len -= Pending.cur;
+	memmove(Pending.buf, Pending.buf + Pending.cur, Pending.len);
+	Pending.cur = 0;
+    }
+    Pending.scanned = 0;
+    Pending.state = S_CODE;
+    Pending.depth = Pending.html = 0;
+    while (!graphend() && !Pending.eof) {
+	if (Pending.size - Pending.len < BUFSIZ) {
+	    Pending.size = (Pending.size ? 2 * Pending.size : 8 * BUFSIZ);
+	    Pending.buf = realloc(Pending.buf, Pending.size);
+	}
+	n = Pending.size - Pending.len;
+	r = disc->io->afread(chan, Pending.buf + Pending.len,
+			     (n > INT_MAX ? INT_MAX : (int) n));
+	if (r <= 0)
+	    Pending.eof = TRUE;
+	else
+	    Pending.len += (size_t) r;
+    }
+    rv = parse(g, disc, Pending.buf + Pending.cur,
+	       Pending.len - Pending.cur, &used);
+    Pending.cur += used;
+    /* forget the channel once none of its input is left over, so that
+     * another channel created at the same address does not see it, and
+     * release the buffer at the end of the input or on a failed read.
+     */
+    if (!rv || (Pending.cur >= Pending.len)) {
+	Pending.chan = NIL(void *);
+	Pending.cur = Pending.len = 0;
+    }
+    if (!rv) {
+	free(Pending.buf);
+	Pending.buf = NIL(char *);
+	Pending.size = 0;
+    }
+    return rv;
+}
+
+Agraph_t *agfastmemread(const char *cp, Agdisc_t * disc)
+{
+    size_t used;
+
+    return parse(NILgraph, disc, cp, strlen(cp), &used);
+}
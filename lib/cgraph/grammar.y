@@ -585,6 +585,8 @@ static void freestack()
 extern FILE *yyin;
 Agraph_t *agconcat(Agraph_t *g, void *chan, Agdisc_t *disc)
 {
+	if ((AgReader == AGREAD_FAST) || (disc && (disc->io == &AgMmapIoDisc)))
+		return agfastconcat(g,chan,disc);
 	yyin = chan;
 	G = g;
 	Ag_G_global = NILgraph;
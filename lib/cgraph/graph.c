@@ -20,14 +20,17 @@ const char AgraphVersion[] = "VERSION";
  * this code sets up the resource management discipline
  * and returns a new main graph struct.
  */
-static Agclos_t *agclos(Agdisc_t * proto)
+static Agclos_t *agclos(Agdisc_t * proto, Agdesc_t desc)
 {
     Agmemdisc_t *memdisc;
     void *memclosure;
     Agclos_t *rv;
 
     /* establish an allocation arena */
-    memdisc = ((proto && proto->mem) ? proto->mem : &AgMemDisc);
+    if (proto && proto->mem)
+	memdisc = proto->mem;
+    else
+	memdisc = (desc.arena ? &AgArenaMemDisc : &AgMemDisc);
     memclosure = memdisc->open(proto);
     rv = memdisc->alloc(memclosure, sizeof(Agclos_t));
     rv->disc.mem = memdisc;
@@ -47,7 +50,7 @@ Agraph_t *agopen(char *name, Agdesc_t desc, Agdisc_t * arg_disc)
     Agclos_t *clos;
     IDTYPE gid;
 
-    clos = agclos(arg_disc);
+    clos = agclos(arg_disc, desc);
     g = clos->disc.mem->alloc(clos->state.mem, sizeof(Agraph_t));
     AGTYPE(g) = AGRAPH;
     g->clos = clos;
@@ -100,6 +103,7 @@ int agclose(Agraph_t * g)
 	/* free entire heap */
 	agmethod_delete(g, g);	/* invoke user callbacks */
 	agfreeid(g, AGRAPH, AGID(g));
+	AGDISC(g, id)->close(AGCLOS(g, id));
 	AGDISC(g, mem)->close(AGCLOS(g, mem));	/* whoosh */
 	return SUCCESS;
     }
@@ -279,6 +283,8 @@ Agdesc_t Agundirected = { 0, 0, 0, 1 };
 Agdesc_t Agstrictundirected = { 0, 1, 0, 1 };
 
 Agdisc_t AgDefaultDisc = { &AgMemDisc, &AgIdDisc, &AgIoDisc };
+Agdisc_t AgArenaDisc = { &AgArenaMemDisc, &AgIdDisc, &AgIoDisc };
+Agdisc_t AgMmapDisc = { &AgMemDisc, &AgIdDisc, &AgMmapIoDisc };
 
 
 #include <stdio.h>
@@ -90,6 +90,17 @@ static int ioflush(void *chan)
 /* Agiodisc_t AgIoDisc = { iofreadiconv, ioputstr, ioflush }; */
 Agiodisc_t AgIoDisc = { iofread, ioputstr, ioflush };
 
+/* a FILE channel read with AgMmapIoDisc is scanned in place by the
+ * fast reader, from a mapping of the file if it is a regular one.
+ * iofreadchunk only reads other files, a chunk at a time.
+ */
+static int iofreadchunk(void *chan, char *buf, int bufsize)
+{
+    return fread(buf, 1, bufsize, (FILE *) chan);
+}
+
+Agiodisc_t AgMmapIoDisc = { iofreadchunk, ioputstr, ioflush };
+
 typedef struct {
     const char *data;
     int len;
@@ -143,6 +154,8 @@ Agraph_t *agmemread(const char *cp)
     disc.mem = &AgMemDisc;
     disc.id = &AgIdDisc;
     disc.io = &memIoDisc;
+    if (AgReader == AGREAD_FAST)
+	return agfastmemread(cp, &disc);
     g = agread (&rdr, &disc);
     return g;
 }
@@ -109,6 +109,146 @@ Agmemdisc_t AgMemDisc =
 
 #endif
 
+	/* arena allocator: blocks are carved from slabs and
+	 * recycled through free lists by size, and the whole
+	 * heap is released at once when the graph is closed.
+	 */
+
+typedef union {			/* block header, keeps blocks aligned */
+    size_t size;		/* usable size of the block */
+    void *p;
+    double d;
+} hdr_t;
+
+typedef struct slab_s {
+    struct slab_s *next;
+    hdr_t hdr[1];		/* start of the blocks */
+} slab_t;
+
+typedef struct big_s {		/* a large block, allocated alone */
+    struct big_s *prev, *next;
+    hdr_t hdr;
+} big_t;
+
+#define ARENA_UNIT	sizeof(hdr_t)
+#define ARENA_BIG	1024	/* larger blocks are not carved from slabs */
+#define ARENA_NBIN	(ARENA_BIG / ARENA_UNIT + 1)
+#define ARENA_MINSLAB	(8 * 1024)
+#define ARENA_MAXSLAB	(1024 * 1024)
+
+typedef struct {
+    slab_t *slabs;
+    char *cur, *end;		/* unused part of the current slab */
+    size_t slabsize;		/* size of the next slab */
+    big_t *bigs;
+    void *bins[ARENA_NBIN];	/* free blocks, by size in units */
+} arena_t;
+
+static void *arenaopen(Agdisc_t * disc)
+{
+    NOTUSED(disc);
+    return calloc(1, sizeof(arena_t));
+}
+
+static void *arenaalloc(void *heap, size_t request)
+{
+    arena_t *a = (arena_t *) heap;
+    size_t n, sz;
+    hdr_t *h;
+    big_t *b;
+    slab_t *s;
+
+    n = (request ? (request + ARENA_UNIT - 1) / ARENA_UNIT : 1);
+    sz = n * ARENA_UNIT;
+    if (sz > ARENA_BIG) {
+	if (!(b = malloc(sizeof(big_t) + sz)))
+	    return NIL(void *);
+	b->prev = NIL(big_t *);
+	if ((b->next = a->bigs))
+	    b->next->prev = b;
+	a->bigs = b;
+	h = &b->hdr;
+    } else if ((h = a->bins[n])) {
+	a->bins[n] = h->p;
+	h--;
+    } else {
+	if ((size_t) (a->end - a->cur) < sz + ARENA_UNIT) {
+	    a->slabsize = (a->slabsize ? a->slabsize : ARENA_MINSLAB);
+	    if (!(s = malloc(sizeof(slab_t) + a->slabsize)))
+		return NIL(void *);
+	    s->next = a->slabs;
+	    a->slabs = s;
+	    a->cur = (char *) s->hdr;
+	    a->end = a->cur + a->slabsize;
+	    if (a->slabsize < ARENA_MAXSLAB)
+		a->slabsize *= 2;
+	}
+	h = (hdr_t *) a->cur;
+	a->cur += sz + ARENA_UNIT;
+    }
+    h->size = sz;
+    memset(h + 1, 0, sz);
+    return h + 1;
+}
+
+static void arenafree(void *heap, void *ptr)
+{
+    arena_t *a = (arena_t *) heap;
+    hdr_t *h = (hdr_t *) ptr - 1;
+    big_t *b;
+
+    if (h->size > ARENA_BIG) {
+	b = (big_t *) ((char *) h - offsetof(big_t, hdr));
+	if (b->prev)
+	    b->prev->next = b->next;
+	else
+	    a->bigs = b->next;
+	if (b->next)
+	    b->next->prev = b->prev;
+	free(b);
+    } else {
+	h[1].p = a->bins[h->size / ARENA_UNIT];
+	a->bins[h->size / ARENA_UNIT] = h + 1;
+    }
+}
+
+static void *arenaresize(void *heap, void *ptr, size_t oldsize,
+			 size_t request)
+{
+    hdr_t *h = (hdr_t *) ptr - 1;
+    void *rv;
+
+    if (request <= h->size) {
+	if (request > oldsize)
+	    memset((char *) ptr + oldsize, 0, request - oldsize);
+	return ptr;
+    }
+    if ((rv = arenaalloc(heap, request))) {
+	memcpy(rv, ptr, (oldsize < h->size ? oldsize : h->size));
+	arenafree(heap, ptr);
+    }
+    return rv;
+}
+
+static void arenaclose(void *heap)
+{
+    arena_t *a = (arena_t *) heap;
+    slab_t *s;
+    big_t *b;
+
+    while ((s = a->slabs)) {
+	a->slabs = s->next;
+	free(s);
+    }
+    while ((b = a->bigs)) {
+	a->bigs = b->next;
+	free(b);
+    }
+    free(a);
+}
+
+Agmemdisc_t AgArenaMemDisc =
+    { arenaopen, arenaalloc, arenaresize, arenafree, arenaclose };
 
 void *agalloc(Agraph_t * g, size_t size)
 {
@@ -352,8 +352,9 @@ static int write_trl(Agraph_t * g, iochan_t * ofile)
 
 static int irrelevant_subgraph(Agraph_t * g)
 {
-    int i, n;
     Agattr_t *sdata, *pdata, *rdata;
+    Agsym_t *sym;
+    char *sval, *pval;
     Agdatadict_t *dd;
 
     char *name;
@@ -363,11 +364,13 @@ static int irrelevant_subgraph(Agraph_t * g)
 	return FALSE;
     if ((sdata = agattrrec(g)) && (pdata = agattrrec(agparent(g)))) {
 	rdata = agattrrec(agroot(g));
-	n = dtsize(rdata->dict);
-	for (i = 0; i < n; i++)
-	    if (sdata->str[i] && pdata->str[i]
-		&& strcmp(sdata->str[i], pdata->str[i]))
+	for (sym = (Agsym_t *) dtfirst(rdata->dict); sym;
+	     sym = (Agsym_t *) dtnext(rdata->dict, sym)) {
+	    sval = agxget(g, sym);
+	    pval = agxget(agparent(g), sym);
+	    if (sval && pval && strcmp(sval, pval))
 		return FALSE;
+	}
     }
     dd = agdatadict(g, FALSE);
     if (!dd)
@@ -418,7 +421,7 @@ static int not_default_attrs(Agraph_t * g, Agnode_t * n)
     if ((data = agattrrec(n))) {
 	for (sym = (Agsym_t *) dtfirst(data->dict); sym;
 	     sym = (Agsym_t *) dtnext(data->dict, sym)) {
-	    if (data->str[sym->id] != sym->defval)
+	    if (agxget(n, sym) != sym->defval)
 		return TRUE;
 	}
     }
@@ -468,6 +471,7 @@ static int write_nondefault_attrs(void *obj, iochan_t * ofile,
     Agattr_t *data;
     Agsym_t *sym;
     Agraph_t *g;
+    char *val;
     int cnt = 0;
     int rv;
 
@@ -487,7 +491,8 @@ static int write_nondefault_attrs(void *obj, iochan_t * ofile,
 		if (Headport && (sym->id == Headport->id))
 		    continue;
 	    }
-	    if (data->str[sym->id] != sym->defval) {
+	    val = agxget(obj, sym);
+	    if (val != sym->defval) {
 		if (cnt++ == 0) {
 		    CHKRV(indent(g, ofile));
 		    CHKRV(ioput(g, ofile, " ["));
@@ -498,7 +503,7 @@ static int write_nondefault_attrs(void *obj, iochan_t * ofile,
 		}
 		CHKRV(write_canonstr(g, ofile, sym->name));
 		CHKRV(ioput(g, ofile, "="));
-		CHKRV(write_canonstr(g, ofile, data->str[sym->id]));
+		CHKRV(write_canonstr(g, ofile, val));
 	    }
 	}
     if (cnt > 0) {
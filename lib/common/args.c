@@ -139,6 +139,11 @@ config_extra_args(GVC_t *gvc, int argc, char** argv)
       case 'O' :
           gvc->common.auto_outfile_names = TRUE;
 	  break;
+      case 'j' :
+	  gvc->common.detach_jobs = -1;
+	  if (isdigit(arg[2]))
+	    gvc->common.detach_jobs = atoi(&arg[2]);
+	  break;
       case 'c' :
           gvc->common.config = TRUE;
 	  break;
@@ -22,12 +22,23 @@
 #include <string.h>
 #include <ctype.h>
 #include <locale.h>
+#include <errno.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_SYS_WAIT_H
+#include <sys/wait.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "render.h"
 #include "agxbuf.h"
 #include "htmltable.h"
 #include "gvc.h"
 #include "cdt.h"
 #include "xdot.h"
+#include "index.h"
 
 #ifdef WIN32
 #define strtok_r strtok_s
@@ -3384,24 +3395,248 @@ static void emit_colors(GVJ_t * job, graph_t * g)
     }
 }
 
+/* Spatial index over the boxes of nodes and edges, so that the
+ * objects of a page or viewport can be found without testing every
+ * one of them.  emit_graph builds it before the first page if the
+ * pages or the viewport do not cover the whole graph, and it is kept
+ * in GD_drawing(g) until the boxes are recomputed or the layout freed.
+ * Coordinates are mapped onto an integer grid of at most SPDX_MAX units
+ * a side so that rectangle areas in the rtree cannot overflow.
+ */
+#define SPDX_MAX 32767
+
+typedef struct {
+    RTree_t *rtp;
+    pointf o;		/* lower left corner of all indexed boxes */
+    double s;		/* grid units per point */
+} spdx_t;
+
+static int spdx_coord(double v)
+{
+    if (v < -1.)
+	return -1;
+    if (v > SPDX_MAX + 1.)
+	return SPDX_MAX + 1;
+    v = floor(v);
+    return (int)v;
+}
+
+/* spdx_rect:
+ * Map b to a grid rectangle containing it.  The upper sides are pushed
+ * out by a unit so that no rectangle is empty.
+ */
+static void spdx_rect(spdx_t *sp, boxf b, Rect_t *r)
+{
+    r->boundary[0] = spdx_coord((b.LL.x - sp->o.x) * sp->s);
+    r->boundary[1] = spdx_coord((b.LL.y - sp->o.y) * sp->s);
+    r->boundary[2] = spdx_coord((b.UR.x - sp->o.x) * sp->s) + 1;
+    r->boundary[3] = spdx_coord((b.UR.y - sp->o.y) * sp->s) + 1;
+}
+
+static void label_bb(textlabel_t *lp, boxf *bb, boolean *found)
+{
+    boxf b;
+
+    b.LL.x = lp->pos.x - lp->dimen.x / 2.;
+    b.LL.y = lp->pos.y - lp->dimen.y / 2.;
+    b.UR.x = lp->pos.x + lp->dimen.x / 2.;
+    b.UR.y = lp->pos.y + lp->dimen.y / 2.;
+    if (*found)
+	EXPANDBB(*bb, b);
+    else
+	*bb = b;
+    *found = TRUE;
+}
+
+/* edge_bb:
+ * Box covering everything edge_in_box tests for e.
+ * Return FALSE if e has nothing to draw.
+ */
+static boolean edge_bb(edge_t *e, boxf *bb)
+{
+    boolean found = FALSE;
+    textlabel_t *lp;
+
+    if (ED_spl(e)) {
+	*bb = ED_spl(e)->bb;
+	found = TRUE;
+    }
+    if ((lp = ED_label(e)))
+	label_bb(lp, bb, &found);
+    if ((lp = ED_xlabel(e)) && lp->set)
+	label_bb(lp, bb, &found);
+    return found;
+}
+
+static spdx_t *spdx_build(graph_t *g)
+{
+    spdx_t *sp;
+    node_t *n;
+    edge_t *e;
+    boxf bb = {{0, 0}, {0, 0}}, b;
+    Rect_t r;
+    boolean found = FALSE;
+    double w;
+
+    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	if (ND_shape(n)) {
+	    if (found)
+		EXPANDBB(bb, ND_bb(n));
+	    else
+		bb = ND_bb(n);
+	    found = TRUE;
+	}
+	for (e = agfstout(g, n); e; e = agnxtout(g, e)) {
+	    if (edge_bb(e, &b)) {
+		if (found)
+		    EXPANDBB(bb, b);
+		else
+		    bb = b;
+		found = TRUE;
+	    }
+	}
+    }
+    if (!found)
+	return NULL;
+
+    sp = NEW(spdx_t);
+    sp->rtp = RTreeOpen();
+    /* RTreeOpen leaves MinFill at 0, which lets the quadratic split
+     * peel off one entry at a time; use Guttman's 40% */
+    sp->rtp->MinFill = 2 * NODECARD / 5;
+    sp->o = bb.LL;
+    w = MAX(bb.UR.x - bb.LL.x, bb.UR.y - bb.LL.y);
+    sp->s = (w > 1.) ? SPDX_MAX / w : 1.;
+    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	if (ND_shape(n)) {
+	    spdx_rect(sp, ND_bb(n), &r);
+	    RTreeInsert(sp->rtp, &r, n, &sp->rtp->root, 0);
+	}
+	for (e = agfstout(g, n); e; e = agnxtout(g, e)) {
+	    if (edge_bb(e, &b)) {
+		spdx_rect(sp, b, &r);
+		RTreeInsert(sp->rtp, &r, e, &sp->rtp->root, 0);
+	    }
+	}
+    }
+    return sp;
+}
+
+void emit_free_spdx(graph_t *g)
+{
+    spdx_t *sp;
+
+    if (GD_drawing(g) && (sp = GD_drawing(g)->spdx)) {
+	RTreeClose(sp->rtp);
+	free(sp);
+	GD_drawing(g)->spdx = NULL;
+    }
+}
+
+static int seqcmp(const void *x, const void *y)
+{
+    node_t *n0 = *(node_t * const *)x;
+    node_t *n1 = *(node_t * const *)y;
+
+    if (AGSEQ(n0) < AGSEQ(n1))
+	return -1;
+    if (AGSEQ(n0) > AGSEQ(n1))
+	return 1;
+    return 0;
+}
+
+static void addviewnode(nlist_t *vn, int *sz, node_t *n)
+{
+    if (vn->size == *sz) {
+	*sz *= 2;
+	vn->list = RALLOC(*sz, vn->list, node_t *);
+    }
+    vn->list[vn->size++] = n;
+}
+
+/* view_nodes:
+ * Collect in vn, in graph order, every node whose own turn in emit_view
+ * could draw something in the current clip: nodes in the clip, tails of
+ * edges in the clip, and tails of edges into nodes in the clip (which
+ * emit their heads first in the default order).  Leave vn->list NULL if
+ * the clip covers the whole graph, or emit_graph did not index it, and
+ * every node should be visited.
+ */
+static void view_nodes(GVJ_t * job, graph_t * g, nlist_t * vn)
+{
+    layout_t *ld = GD_drawing(g);
+    spdx_t *sp;
+    LeafList_t *llp, *lp;
+    Agobj_t *obj;
+    edge_t *e;
+    Rect_t r;
+    int i, j, sz;
+
+    vn->list = NULL;
+    vn->size = 0;
+    if (!ld || !(sp = ld->spdx) || boxf_contains(job->clip, GD_bb(g)))
+	return;
+
+    sz = 1024;
+    vn->list = N_GNEW(sz, node_t *);
+    spdx_rect(sp, job->clip, &r);
+    llp = RTreeSearch(sp->rtp, sp->rtp->root, &r);
+    for (lp = llp; lp; lp = lp->next) {
+	obj = lp->leaf->data;
+	if (AGTYPE(obj) == AGNODE) {
+	    addviewnode(vn, &sz, (node_t *)obj);
+	    for (e = agfstin(g, (node_t *)obj); e; e = agnxtin(g, e))
+		addviewnode(vn, &sz, agtail(e));
+	}
+	else
+	    addviewnode(vn, &sz, agtail((edge_t *)obj));
+    }
+    if (llp)
+	RTreeLeafListFree(llp);
+
+    qsort(vn->list, (size_t)vn->size, sizeof(node_t *), seqcmp);
+    for (i = j = 0; i < vn->size; i++)
+	if (j == 0 || vn->list[j - 1] != vn->list[i])
+	    vn->list[j++] = vn->list[i];
+    vn->size = j;
+}
+
+static node_t *fstviewnode(graph_t * g, nlist_t * vn, int *i)
+{
+    *i = 0;
+    if (!vn->list)
+	return agfstnode(g);
+    return (vn->size > 0) ? vn->list[0] : NULL;
+}
+
+static node_t *nxtviewnode(graph_t * g, nlist_t * vn, int *i, node_t * n)
+{
+    if (!vn->list)
+	return agnxtnode(g, n);
+    return (++(*i) < vn->size) ? vn->list[*i] : NULL;
+}
+
 static void emit_view(GVJ_t * job, graph_t * g, int flags)
 {
     GVC_t * gvc = job->gvc;
     node_t *n;
     edge_t *e;
+    nlist_t vn;
+    int i;
 
     gvc->common.viewNum++;
+    view_nodes(job, g, &vn);
     /* when drawing, lay clusters down before nodes and edges */
     if (!(flags & EMIT_CLUSTERS_LAST))
 	emit_clusters(job, g, flags);
     if (flags & EMIT_SORTED) {
 	/* output all nodes, then all edges */
 	gvrender_begin_nodes(job);
-	for (n = agfstnode(g); n; n = agnxtnode(g, n))
+	for (n = fstviewnode(g, &vn, &i); n; n = nxtviewnode(g, &vn, &i, n))
 	    emit_node(job, n);
 	gvrender_end_nodes(job);
 	gvrender_begin_edges(job);
-	for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	for (n = fstviewnode(g, &vn, &i); n; n = nxtviewnode(g, &vn, &i, n)) {
 	    for (e = agfstout(g, n); e; e = agnxtout(g, e))
 		emit_edge(job, e);
 	}
@@ -3409,23 +3644,23 @@ static void emit_view(GVJ_t * job, graph_t * g, int flags)
     } else if (flags & EMIT_EDGE_SORTED) {
 	/* output all edges, then all nodes */
 	gvrender_begin_edges(job);
-	for (n = agfstnode(g); n; n = agnxtnode(g, n))
+	for (n = fstviewnode(g, &vn, &i); n; n = nxtviewnode(g, &vn, &i, n))
 	    for (e = agfstout(g, n); e; e = agnxtout(g, e))
 		emit_edge(job, e);
 	gvrender_end_edges(job);
 	gvrender_begin_nodes(job);
-	for (n = agfstnode(g); n; n = agnxtnode(g, n))
+	for (n = fstviewnode(g, &vn, &i); n; n = nxtviewnode(g, &vn, &i, n))
 	    emit_node(job, n);
 	gvrender_end_nodes(job);
     } else if (flags & EMIT_PREORDER) {
 	gvrender_begin_nodes(job);
-	for (n = agfstnode(g); n; n = agnxtnode(g, n))
+	for (n = fstviewnode(g, &vn, &i); n; n = nxtviewnode(g, &vn, &i, n))
 	    if (write_node_test(g, n))
 		emit_node(job, n);
 	gvrender_end_nodes(job);
 	gvrender_begin_edges(job);
 
-	for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	for (n = fstviewnode(g, &vn, &i); n; n = nxtviewnode(g, &vn, &i, n)) {
 	    for (e = agfstout(g, n); e; e = agnxtout(g, e)) {
 		if (write_edge_test(g, e))
 		    emit_edge(job, e);
@@ -3434,7 +3669,7 @@ static void emit_view(GVJ_t * job, graph_t * g, int flags)
 	gvrender_end_edges(job);
     } else {
 	/* output in breadth first graph walk order */
-	for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	for (n = fstviewnode(g, &vn, &i); n; n = nxtviewnode(g, &vn, &i, n)) {
 	    emit_node(job, n);
 	    for (e = agfstout(g, n); e; e = agnxtout(g, e)) {
 		emit_node(job, aghead(e));
@@ -3445,6 +3680,7 @@ static void emit_view(GVJ_t * job, graph_t * g, int flags)
     /* when mapping, detect events on clusters after nodes and edges */
     if (flags & EMIT_CLUSTERS_LAST)
 	emit_clusters(job, g, flags);
+    free(vn.list);
 }
 
 static void emit_begin_graph(GVJ_t * job, graph_t * g)
@@ -3577,6 +3813,13 @@ fprintf(stderr,"focus=%g,%g view=%g,%g\n",
     s = late_string(g, agattr(g, AGRAPH, "comment", 0), "");
     gvrender_comment(job, s);
 
+    /* index the nodes and edges if a view will show only part of them */
+    if (GD_drawing(g) && !GD_drawing(g)->spdx
+	&& ((job->numPages > 1)
+	    || (job->view.x < GD_bb(g).UR.x - GD_bb(g).LL.x)
+	    || (job->view.y < GD_bb(g).UR.y - GD_bb(g).LL.y)))
+	GD_drawing(g)->spdx = spdx_build(g);
+
     job->layerNum = 0;
     emit_begin_graph(job, g);
 
@@ -4052,6 +4295,7 @@ static void init_bb(graph_t *g)
 {
     node_t *n;
 
+    emit_free_spdx(g);
     for (n = agfstnode(g); n; n = agnxtnode(g, n))
         init_bb_node(g, n);
 }
@@ -4091,12 +4335,155 @@ void gv_fixLocale (int set)
 }
 
 
+#if defined(HAVE_FORK) && defined(HAVE_SYS_WAIT_H) && !defined(WIN32)
+#define DETACH_JOBS 1
+#endif
+
+#ifdef DETACH_JOBS
+/* Once laid out, the graph is only read while rendering, so a job
+ * writing to a file of its own can be rendered in a child process
+ * concurrently with the remaining jobs.  The emitter and the render
+ * plugins keep state in globals and in the graph (ND_state, color
+ * schemes, plugin statics), which a process gives each job for free.
+ *
+ * Forking is only safe for a single threaded process that owns all of
+ * its children, so it is never done inside an embedding application:
+ * it must be requested through gvc->common.detach_jobs, which only
+ * the dot command sets (-j).  Only jobs with automatic output file
+ * names (-O) are detached: their file is used by no other job.  Paged
+ * devices, which may collect later graphs into the same file, and
+ * renderers that attach attributes to the graph for the jobs after
+ * them (dot, xdot, json) stay in this process.
+ */
+typedef struct {
+    pid_t *pids;	/* running children, oldest first */
+    int n, max;
+    boolean failed;	/* some child did not render its job */
+} detached_t;
+
+static void init_detached(GVC_t * gvc, detached_t * dp)
+{
+    int max = gvc->common.detach_jobs;
+
+#ifdef _SC_NPROCESSORS_ONLN
+    if (max < 0)
+	max = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    dp->max = MAX(max, 0);
+    dp->n = 0;
+    dp->failed = FALSE;
+    dp->pids = (dp->max ? N_NEW(dp->max, pid_t) : NULL);
+}
+
+static boolean detachable(GVC_t * gvc, GVJ_t * job)
+{
+    return (gvc->common.auto_outfile_names
+	&& !gvc->write_fn
+	&& !job->output_file
+	&& !job->output_data
+	&& !job->external_context
+	&& !(job->flags & (GVDEVICE_EVENTS | GVDEVICE_DOES_PAGES
+			   | GVRENDER_MODIFIES_GRAPH)));
+}
+
+/* wait_detached:
+ * Wait for the oldest child, noting whether it failed.
+ */
+static void wait_detached(detached_t * dp)
+{
+    int status;
+    pid_t pid = dp->pids[0];
+
+    dp->n--;
+    memmove(dp->pids, dp->pids + 1, dp->n * sizeof(pid_t));
+    while (waitpid(pid, &status, 0) < 0) {
+	if (errno != EINTR) {
+	    agerr(AGERR, "lost rendering process %d\n", (int)pid);
+	    dp->failed = TRUE;
+	    return;
+	}
+    }
+    if (WIFSIGNALED(status)) {
+	agerr(AGERR, "rendering process terminated by signal %d\n", WTERMSIG(status));
+	dp->failed = TRUE;
+    }
+    else if (WEXITSTATUS(status)) {
+	agerr(AGERR, "rendering process %d failed\n", (int)pid);
+	dp->failed = TRUE;
+    }
+}
+
+/* finish_detached:
+ * Wait for all children.  Return -1 if any of them failed.
+ */
+static int finish_detached(detached_t * dp)
+{
+    while (dp->n > 0)
+	wait_detached(dp);
+    free(dp->pids);
+    dp->pids = NULL;
+    dp->max = 0;
+    return (dp->failed ? -1 : 0);
+}
+
+/* render_detached:
+ * Render job in a child process if it qualifies, waiting for an earlier
+ * one to finish if max of them are running.  Return FALSE if the job
+ * must be rendered here.  The child exits with a non-zero status if
+ * the job raised an error.
+ */
+static boolean render_detached(GVC_t * gvc, GVJ_t * job, graph_t * g, detached_t * dp)
+{
+    pid_t pid;
+
+    if (dp->max == 0 || !detachable(gvc, job))
+	return FALSE;
+    if (dp->n >= dp->max)
+	wait_detached(dp);
+
+    /* output the child inherits would otherwise be written twice
+     * if it exits through exit() on an error */
+    fflush(NULL);
+    if ((pid = fork()) < 0)
+	return FALSE;
+    if (pid > 0) {
+	dp->pids[dp->n++] = pid;
+	return TRUE;
+    }
+
+    /* the OpenMP runtime of the parent does not survive fork once it
+     * has started threads, so the child renders on this thread alone */
+#ifdef _OPENMP
+    omp_set_num_threads(1);
+#endif
+    gvc->common.single_thread = TRUE;
+    agreseterrors();
+    gvc->active_jobs = job;
+    job->next_active = NULL;
+    job->callbacks = &gvdevice_callbacks;
+    if (gvrender_begin_job(job))
+	_exit(1);
+    init_job_pad(job);
+    init_job_margin(job);
+    init_job_dpi(job, g);
+    init_job_viewport(job, g);
+    init_job_pagination(job, g);
+    emit_graph(job, g);
+    gvrender_end_job(job);
+    _exit(agerrors() >= AGERR ? 1 : 0);
+    return TRUE;
+}
+#endif
+
 #define FINISH() if (Verbose) fprintf(stderr,"gvRenderJobs %s: %.2f secs.\n", agnameof(g), elapsed_sec())
 
 int gvRenderJobs (GVC_t * gvc, graph_t * g)
 {
     static GVJ_t *prevjob;
     GVJ_t *job, *firstjob;
+#ifdef DETACH_JOBS
+    detached_t detached;
+#endif
 
     if (Verbose)
 	start_timer();
@@ -4110,6 +4497,9 @@ int gvRenderJobs (GVC_t * gvc, graph_t * g)
     init_bb(g);
     init_gvc(gvc, g);
     init_layering(gvc, g);
+#ifdef DETACH_JOBS
+    init_detached(gvc, &detached);
+#endif
 
     gv_fixLocale (1);
     for (job = gvjobs_first(gvc); job; job = gvjobs_next(gvc)) {
@@ -4127,6 +4517,9 @@ int gvRenderJobs (GVC_t * gvc, graph_t * g)
 	job->numkeys = gvevent_key_binding_size;
 	if (!GD_drawing(g)) {
 	    agerr (AGERR, "layout was not done\n");
+#ifdef DETACH_JOBS
+	    finish_detached(&detached);
+#endif
 	    gv_fixLocale (0);
 	    FINISH();
 	    return -1;
@@ -4135,6 +4528,9 @@ int gvRenderJobs (GVC_t * gvc, graph_t * g)
         job->output_lang = gvrender_select(job, job->output_langname);
         if (job->output_lang == NO_SUPPORT) {
             agerr (AGERR, "renderer for %s is unavailable\n", job->output_langname);
+#ifdef DETACH_JOBS
+	    finish_detached(&detached);
+#endif
 	    gv_fixLocale (0);
 	    FINISH();
             return -1;
@@ -4172,6 +4568,13 @@ int gvRenderJobs (GVC_t * gvc, graph_t * g)
 	    prevjob = NULL;
         }
 
+#ifdef DETACH_JOBS
+	if (render_detached(gvc, job, g, &detached)) {
+	    prevjob = NULL;	/* already ended in the child */
+	    continue;
+	}
+#endif
+
 	if (prevjob) {
             prevjob->next_active = job;  /* insert job in active list */
 	    job->output_file = prevjob->output_file;  /* FIXME - this is dumb ! */
@@ -4206,6 +4609,12 @@ int gvRenderJobs (GVC_t * gvc, graph_t * g)
 	prevjob = job;
     }
     gv_fixLocale (0);
+#ifdef DETACH_JOBS
+    if (finish_detached(&detached)) {
+	FINISH();
+	return -1;
+    }
+#endif
     FINISH();
     return 0;
 }
@@ -32,6 +32,7 @@ static char *genericItems = "\n\
  -lv         - Use external library 'v'\n\
  -ofile      - Write output to 'file'\n\
  -O          - Automatically generate an output filename based on the input filename with a .'format' appended. (Causes all -ofile options to be ignored.) \n\
+ -j[n]       - With -O, render independent formats in up to 'n' processes (=#processors)\n\
  -P          - Internally generate a graph of the current plugins. \n\
  -q[l]       - Set level of message suppression (=1)\n\
  -s[v]       - Scale input by 'v' (=72)\n\
@@ -849,6 +850,7 @@ void graph_cleanup(graph_t *g)
 	freeXDot ((xdot*)GD_drawing(g)->xdots);
     if (GD_drawing(g) && GD_drawing(g)->id)
 	free (GD_drawing(g)->id);
+    emit_free_spdx(g);
     free(GD_drawing(g));
     GD_drawing(g) = NULL;
     free_label(GD_label(g));
@@ -18,8 +18,9 @@
 
 #include "render.h"
 #include <setjmp.h>
+#include <time.h>
 
-static int init_graph(graph_t *);
+static int init_graph(ns_context_t * C, graph_t *, node_t *);
 static void dfs_cutval(node_t * v, edge_t * par);
 static int dfs_range(node_t * v, edge_t * par, int low);
 static int x_val(edge_t * e, node_t * v, int dir);
@@ -32,36 +33,266 @@ static void check_cycles(graph_t * g);
 #define SEQ(a,b,c)		(((a) <= (b)) && ((b) <= (c)))
 #define TREE_EDGE(e)	(ED_tree_index(e) >= 0)
 
-static jmp_buf jbuf;
-static graph_t *G;
-static int N_nodes, N_edges;
-static int Minrank, Maxrank;
-static int S_i;			/* search index for enter_edge */
-static int Search_size;
 #define SEARCHSIZE 30
-static nlist_t Tree_node;
-static elist Tree_edge;
 
-static void add_tree_edge(edge_t * e)
+/* All of the solver state lives in the context rather than in file
+ * statics, so independent graphs (or disjoint node lists of the same
+ * graph) can be ranked concurrently, one context per thread.
+ */
+struct ns_context_s {
+    jmp_buf jbuf;
+    graph_t *G;
+    node_t *Nlist;		/* first node of the list being ranked */
+    int N_nodes, N_edges;
+    int Minrank, Maxrank;
+    int S_i;			/* search index for enter_edge */
+    int Search_size;
+    nlist_t Tree_node;
+    elist Tree_edge;
+    edge_t *Enter;		/* state of the enter_edge search */
+    int Low, Lim, Slack;
+    ns_pivot_t Pivot;		/* leaving edge selection strategy */
+    unsigned int *Negset;	/* bit i set iff Tree_edge.list[i] has cutvalue < 0 */
+    unsigned int *Negsum;	/* bit w set iff word w of Negset is non-zero */
+    int Negwords, Sumwords;
+    int *Heap;			/* min-heap of negative tree edge indices (best) */
+    int *Heappos;		/* position of a tree edge index in Heap, or -1 */
+    int Heapsize;
+    clock_t Start;		/* when ns_rank started, for Verbose */
+};
+
+/* ns_context_new:
+ * Allocate an empty solver context. The tree arrays are grown on
+ * demand and kept across calls to ns_rank, so a context can be reused
+ * for many graphs.
+ */
+ns_context_t *ns_context_new(void)
+{
+    return NEW(ns_context_t);
+}
+
+void ns_context_free(ns_context_t * C)
+{
+    if (!C)
+	return;
+    free(C->Tree_node.list);
+    free(C->Tree_edge.list);
+    free(C->Negset);
+    free(C->Negsum);
+    free(C->Heap);
+    free(C->Heappos);
+    free(C);
+}
+
+void ns_context_set_pivot(ns_context_t * C, ns_pivot_t pivot)
+{
+    C->Pivot = pivot;
+}
+
+/* ns_pivot:
+ * Return the leaving edge strategy requested by the nspivot attribute
+ * of g; block search if unset or unknown.
+ */
+ns_pivot_t ns_pivot(graph_t * g)
+{
+    char *s = agget(g, "nspivot");
+
+    if (!s || !*s || !strcasecmp(s, "block"))
+	return NS_PIVOT_BLOCK;
+    if (!strcasecmp(s, "first"))
+	return NS_PIVOT_FIRST;
+    if (!strcasecmp(s, "best"))
+	return NS_PIVOT_BEST;
+    agerr(AGWARN, "unknown value \"%s\" for nspivot - using block\n", s);
+    return NS_PIVOT_BLOCK;
+}
+
+/* Index of the tree edges with negative cut values.
+ * Each tree edge has a bit in Negset; Negsum has a bit per word of
+ * Negset, so the next negative edge after a given tree index is found
+ * skipping 32 words at a time. For the best (Dantzig) strategy, the
+ * negative edges are also kept in a heap ordered by cut value, then by
+ * tree index.
+ */
+#define WBITS		32
+#define NEGBIT(a,i)	((a)[(i)/WBITS] & (1u << ((i)%WBITS)))
+
+static void neg_alloc(ns_context_t * C)
+{
+    int i;
+
+    C->Negwords = (C->N_nodes + WBITS - 1) / WBITS;
+    C->Sumwords = (C->Negwords + WBITS - 1) / WBITS;
+    C->Negset = ALLOC(C->Negwords + 1, C->Negset, unsigned int);
+    C->Negsum = ALLOC(C->Sumwords + 1, C->Negsum, unsigned int);
+    memset(C->Negset, 0, (C->Negwords + 1) * sizeof(unsigned int));
+    memset(C->Negsum, 0, (C->Sumwords + 1) * sizeof(unsigned int));
+    if (C->Pivot == NS_PIVOT_BEST) {
+	C->Heap = ALLOC(C->N_nodes + 1, C->Heap, int);
+	C->Heappos = ALLOC(C->N_nodes + 1, C->Heappos, int);
+	for (i = 0; i <= C->N_nodes; i++)
+	    C->Heappos[i] = -1;
+    }
+    C->Heapsize = 0;
+}
+
+/* heap_less:
+ * Order of tree edges i and j in the heap.
+ */
+static int heap_less(ns_context_t * C, int i, int j)
+{
+    int ci = ED_cutvalue(C->Tree_edge.list[i]);
+    int cj = ED_cutvalue(C->Tree_edge.list[j]);
+
+    return (ci < cj) || ((ci == cj) && (i < j));
+}
+
+static void heap_swap(ns_context_t * C, int a, int b)
+{
+    int t = C->Heap[a];
+
+    C->Heap[a] = C->Heap[b];
+    C->Heap[b] = t;
+    C->Heappos[C->Heap[a]] = a;
+    C->Heappos[C->Heap[b]] = b;
+}
+
+static void heap_up(ns_context_t * C, int k)
+{
+    while (k > 0 && heap_less(C, C->Heap[k], C->Heap[(k - 1) / 2])) {
+	heap_swap(C, k, (k - 1) / 2);
+	k = (k - 1) / 2;
+    }
+}
+
+static void heap_down(ns_context_t * C, int k)
+{
+    int c;
+
+    while ((c = 2 * k + 1) < C->Heapsize) {
+	if ((c + 1 < C->Heapsize) && heap_less(C, C->Heap[c + 1], C->Heap[c]))
+	    c++;
+	if (!heap_less(C, C->Heap[c], C->Heap[k]))
+	    break;
+	heap_swap(C, k, c);
+	k = c;
+    }
+}
+
+static void heap_remove(ns_context_t * C, int i)
+{
+    int k = C->Heappos[i];
+
+    C->Heappos[i] = -1;
+    if (k != --C->Heapsize) {
+	C->Heap[k] = C->Heap[C->Heapsize];
+	C->Heappos[C->Heap[k]] = k;
+	heap_up(C, k);
+	heap_down(C, C->Heappos[C->Heap[k]]);
+    }
+}
+
+/* neg_update:
+ * Record the sign of the cut value of tree edge i, which has just
+ * changed, or whose slot now holds a different edge.
+ */
+static void neg_update(ns_context_t * C, int i)
+{
+    int w = i / WBITS;
+    int neg = (ED_cutvalue(C->Tree_edge.list[i]) < 0);
+
+    if (neg)
+	C->Negset[w] |= (1u << (i % WBITS));
+    else
+	C->Negset[w] &= ~(1u << (i % WBITS));
+    if (C->Negset[w])
+	C->Negsum[w / WBITS] |= (1u << (w % WBITS));
+    else
+	C->Negsum[w / WBITS] &= ~(1u << (w % WBITS));
+
+    if (C->Pivot == NS_PIVOT_BEST) {
+	if (C->Heappos[i] >= 0)
+	    heap_remove(C, i);
+	if (neg) {
+	    C->Heap[C->Heapsize] = i;
+	    C->Heappos[i] = C->Heapsize++;
+	    heap_up(C, C->Heapsize - 1);
+	}
+    }
+}
+
+static void neg_init(ns_context_t * C)
+{
+    int i;
+
+    neg_alloc(C);
+    for (i = 0; i < C->Tree_edge.size; i++)
+	neg_update(C, i);
+}
+
+/* next_bit:
+ * Return the smallest index >= i of a bit set in a[0..nwords), or -1.
+ */
+static int next_bit(unsigned int *a, int nwords, int i)
+{
+    int w = i / WBITS;
+    unsigned int bits;
+
+    if (w >= nwords)
+	return -1;
+    bits = a[w] & (~0u << (i % WBITS));
+    while (!bits) {
+	if (++w >= nwords)
+	    return -1;
+	bits = a[w];
+    }
+    for (i = 0; !(bits & 1u); i++)
+	bits >>= 1;
+    return w * WBITS + i;
+}
+
+/* next_neg:
+ * Return the smallest tree index >= i with a negative cut value, or -1.
+ */
+static int next_neg(ns_context_t * C, int i)
+{
+    int w, j;
+
+    if (i >= C->Tree_edge.size)
+	return -1;
+    w = i / WBITS;
+    if ((C->Negset[w] & (~0u << (i % WBITS))) == 0) {
+	/* nothing left in this word; use the summary to find the next one */
+	if ((w = next_bit(C->Negsum, C->Sumwords, w + 1)) < 0)
+	    return -1;
+	i = w * WBITS;
+    }
+    j = next_bit(C->Negset, C->Negwords, i);
+    if (j >= C->Tree_edge.size)
+	return -1;
+    return j;
+}
+
+static void add_tree_edge(ns_context_t * C, edge_t * e)
 {
     node_t *n;
     if (TREE_EDGE(e)) {
 	agerr(AGERR, "add_tree_edge: missing tree edge\n");
-	longjmp (jbuf, 1);
+	longjmp (C->jbuf, 1);
     }
-    ED_tree_index(e) = Tree_edge.size;
-    Tree_edge.list[Tree_edge.size++] = e;
+    ED_tree_index(e) = C->Tree_edge.size;
+    C->Tree_edge.list[C->Tree_edge.size++] = e;
     if (ND_mark(agtail(e)) == FALSE)
-	Tree_node.list[Tree_node.size++] = agtail(e);
+	C->Tree_node.list[C->Tree_node.size++] = agtail(e);
     if (ND_mark(aghead(e)) == FALSE)
-	Tree_node.list[Tree_node.size++] = aghead(e);
+	C->Tree_node.list[C->Tree_node.size++] = aghead(e);
     n = agtail(e);
     ND_mark(n) = TRUE;
     ND_tree_out(n).list[ND_tree_out(n).size++] = e;
     ND_tree_out(n).list[ND_tree_out(n).size] = NULL;
     if (ND_out(n).list[ND_tree_out(n).size - 1] == 0) {
 	agerr(AGERR, "add_tree_edge: empty outedge list\n");
-	longjmp (jbuf, 1);
+	longjmp (C->jbuf, 1);
     }
     n = aghead(e);
     ND_mark(n) = TRUE;
@@ -69,17 +300,17 @@ static void add_tree_edge(edge_t * e)
     ND_tree_in(n).list[ND_tree_in(n).size] = NULL;
     if (ND_in(n).list[ND_tree_in(n).size - 1] == 0) {
 	agerr(AGERR, "add_tree_edge: empty inedge list\n");
-	longjmp (jbuf, 1);
+	longjmp (C->jbuf, 1);
     }
 }
 
-static void exchange_tree_edges(edge_t * e, edge_t * f)
+static void exchange_tree_edges(ns_context_t * C, edge_t * e, edge_t * f)
 {
     int i, j;
     node_t *n;
 
     ED_tree_index(f) = ED_tree_index(e);
-    Tree_edge.list[ED_tree_index(e)] = f;
+    C->Tree_edge.list[ED_tree_index(e)] = f;
     ED_tree_index(e) = -1;
 
     n = agtail(e);
@@ -106,17 +337,17 @@ static void exchange_tree_edges(edge_t * e, edge_t * f)
 }
 
 static
-void init_rank(void)
+void init_rank(ns_context_t * C)
 {
     int i, ctr;
     nodequeue *Q;
     node_t *v;
     edge_t *e;
 
-    Q = new_queue(N_nodes);
+    Q = new_queue(C->N_nodes);
     ctr = 0;
 
-    for (v = GD_nlist(G); v; v = ND_next(v)) {
+    for (v = C->Nlist; v; v = ND_next(v)) {
 	if (ND_priority(v) == 0)
 	    enqueue(Q, v);
     }
@@ -131,9 +362,9 @@ void init_rank(void)
 		enqueue(Q, aghead(e));
 	}
     }
-    if (ctr != N_nodes) {
+    if (ctr != C->N_nodes) {
 	agerr(AGERR, "trouble in init_rank\n");
-	for (v = GD_nlist(G); v; v = ND_next(v))
+	for (v = C->Nlist; v; v = ND_next(v))
 	    if (ND_priority(v))
 		agerr(AGPREV, "\t%s %d\n", agnameof(v), ND_priority(v));
     }
@@ -152,90 +383,95 @@ static node_t *incident(edge_t * e)
     return NULL;
 }
 
-static edge_t *leave_edge(void)
+/* leave_edge:
+ * Choose the tree edge to leave the tree, or NULL if no tree edge has
+ * a negative cut value. The block search scans the tree edges
+ * cyclically from S_i and picks the most negative of the first
+ * Search_size negative edges found; the first eligible strategy is the
+ * same with a block of one. The index of negative edges means only
+ * those edges are visited. The best strategy (Dantzig's rule) takes the
+ * most negative over the whole tree.
+ */
+static edge_t *leave_edge(ns_context_t * C)
 {
     edge_t *f, *rv = NULL;
-    int j, cnt = 0;
-
-    j = S_i;
-    while (S_i < Tree_edge.size) {
-	if (ED_cutvalue(f = Tree_edge.list[S_i]) < 0) {
-	    if (rv) {
-		if (ED_cutvalue(rv) > ED_cutvalue(f))
-		    rv = f;
-	    } else
-		rv = Tree_edge.list[S_i];
-	    if (++cnt >= Search_size)
-		return rv;
+    int j, k, cnt = 0, limit;
+
+    if (C->Pivot == NS_PIVOT_BEST)
+	return (C->Heapsize ? C->Tree_edge.list[C->Heap[0]] : NULL);
+    limit = (C->Pivot == NS_PIVOT_FIRST ? 1 : C->Search_size);
+
+    j = C->S_i;
+    for (k = next_neg(C, j); k >= 0; k = next_neg(C, k + 1)) {
+	f = C->Tree_edge.list[k];
+	if (!rv || (ED_cutvalue(rv) > ED_cutvalue(f)))
+	    rv = f;
+	if (++cnt >= limit) {
+	    C->S_i = k;
+	    return rv;
 	}
-	S_i++;
     }
+    C->S_i = C->Tree_edge.size;
     if (j > 0) {
-	S_i = 0;
-	while (S_i < j) {
-	    if (ED_cutvalue(f = Tree_edge.list[S_i]) < 0) {
-		if (rv) {
-		    if (ED_cutvalue(rv) > ED_cutvalue(f))
-			rv = f;
-		} else
-		    rv = Tree_edge.list[S_i];
-		if (++cnt >= Search_size)
-		    return rv;
+	for (k = next_neg(C, 0); (k >= 0) && (k < j); k = next_neg(C, k + 1)) {
+	    f = C->Tree_edge.list[k];
+	    if (!rv || (ED_cutvalue(rv) > ED_cutvalue(f)))
+		rv = f;
+	    if (++cnt >= limit) {
+		C->S_i = k;
+		return rv;
 	    }
-	    S_i++;
 	}
+	C->S_i = j;
     }
     return rv;
 }
 
-static edge_t *Enter;
-static int Low, Lim, Slack;
-
-static void dfs_enter_outedge(node_t * v)
+static void dfs_enter_outedge(ns_context_t * C, node_t * v)
 {
     int i, slack;
     edge_t *e;
 
     for (i = 0; (e = ND_out(v).list[i]); i++) {
 	if (TREE_EDGE(e) == FALSE) {
-	    if (!SEQ(Low, ND_lim(aghead(e)), Lim)) {
+	    if (!SEQ(C->Low, ND_lim(aghead(e)), C->Lim)) {
 		slack = SLACK(e);
-		if ((slack < Slack) || (Enter == NULL)) {
-		    Enter = e;
-		    Slack = slack;
+		if ((slack < C->Slack) || (C->Enter == NULL)) {
+		    C->Enter = e;
+		    C->Slack = slack;
 		}
 	    }
 	} else if (ND_lim(aghead(e)) < ND_lim(v))
-	    dfs_enter_outedge(aghead(e));
+	    dfs_enter_outedge(C, aghead(e));
     }
-    for (i = 0; (e = ND_tree_in(v).list[i]) && (Slack > 0); i++)
+    for (i = 0; (e = ND_tree_in(v).list[i]) && (C->Slack > 0); i++)
 	if (ND_lim(agtail(e)) < ND_lim(v))
-	    dfs_enter_outedge(agtail(e));
+	    dfs_enter_outedge(C, agtail(e));
 }
 
-static void dfs_enter_inedge(node_t * v)
+static void dfs_enter_inedge(ns_context_t * C, node_t * v)
 {
     int i, slack;
     edge_t *e;
 
     for (i = 0; (e = ND_in(v).list[i]); i++) {
 	if (TREE_EDGE(e) == FALSE) {
-	    if (!SEQ(Low, ND_lim(agtail(e)), Lim)) {
+	    if (!SEQ(C->Low, ND_lim(agtail(e)), C->Lim)) {
 		slack = SLACK(e);
-		if ((slack < Slack) || (Enter == NULL)) {
-		    Enter = e;
-		    Slack = slack;
+		if ((slack < C->Slack) || (C->Enter == NULL)) {
+		    C->Enter = e;
+		    C->Slack = slack;
 		}
 	    }
 	} else if (ND_lim(agtail(e)) < ND_lim(v))
-	    dfs_enter_inedge(agtail(e));
+	    dfs_enter_inedge(C, agtail(e));
     }
-    for (i = 0; (e = ND_tree_out(v).list[i]) && (Slack > 0); i++)
+    for (i = 0; (e = ND_tree_out(v).list[i]) && (C->Slack > 0); i++)
 	if (ND_lim(aghead(e)) < ND_lim(v))
-	    dfs_enter_inedge(aghead(e));
+	    dfs_enter_inedge(C, aghead(e));
 }
 
-static edge_t *enter_edge(edge_t * e)
+static edge_t *enter_edge(ns_context_t * C, edge_t * e)
 {
     node_t *v;
     int outsearch;
@@ -248,75 +484,78 @@ static edge_t *enter_edge(edge_t * e)
 	v = aghead(e);
 	outsearch = TRUE;
     }
-    Enter = NULL;
-    Slack = INT_MAX;
-    Low = ND_low(v);
-    Lim = ND_lim(v);
+    C->Enter = NULL;
+    C->Slack = INT_MAX;
+    C->Low = ND_low(v);
+    C->Lim = ND_lim(v);
     if (outsearch)
-	dfs_enter_outedge(v);
+	dfs_enter_outedge(C, v);
     else
-	dfs_enter_inedge(v);
-    return Enter;
+	dfs_enter_inedge(C, v);
+    return C->Enter;
 }
 
-static int treesearch(node_t * v)
+static int treesearch(ns_context_t * C, node_t * v)
 {
     int i;
     edge_t *e;
 
     for (i = 0; (e = ND_out(v).list[i]); i++) {
 	if ((ND_mark(aghead(e)) == FALSE) && (SLACK(e) == 0)) {
-	    add_tree_edge(e);
-	    if ((Tree_edge.size == N_nodes - 1) || treesearch(aghead(e)))
+	    add_tree_edge(C, e);
+	    if ((C->Tree_edge.size == C->N_nodes - 1)
+		|| treesearch(C, aghead(e)))
 		return TRUE;
 	}
     }
     for (i = 0; (e = ND_in(v).list[i]); i++) {
 	if ((ND_mark(agtail(e)) == FALSE) && (SLACK(e) == 0)) {
-	    add_tree_edge(e);
-	    if ((Tree_edge.size == N_nodes - 1) || treesearch(agtail(e)))
+	    add_tree_edge(C, e);
+	    if ((C->Tree_edge.size == C->N_nodes - 1)
+		|| treesearch(C, agtail(e)))
 		return TRUE;
 	}
     }
     return FALSE;
 }
 
-static int tight_tree(void)
+static int tight_tree(ns_context_t * C)
 {
     int i;
     node_t *n;
 
-    for (n = GD_nlist(G); n; n = ND_next(n)) {
+    for (n = C->Nlist; n; n = ND_next(n)) {
 	ND_mark(n) = FALSE;
 	ND_tree_in(n).list[0] = ND_tree_out(n).list[0] = NULL;
 	ND_tree_in(n).size = ND_tree_out(n).size = 0;
     }
-    for (i = 0; i < Tree_edge.size; i++)
-	ED_tree_index(Tree_edge.list[i]) = -1;
+    for (i = 0; i < C->Tree_edge.size; i++)
+	ED_tree_index(C->Tree_edge.list[i]) = -1;
 
-    Tree_node.size = Tree_edge.size = 0;
-    for (n = GD_nlist(G); n && (Tree_edge.size == 0); n = ND_next(n))
-	treesearch(n);
-    return Tree_node.size;
+    C->Tree_node.size = C->Tree_edge.size = 0;
+    for (n = C->Nlist; n && (C->Tree_edge.size == 0); n = ND_next(n))
+	treesearch(C, n);
+    return C->Tree_node.size;
 }
 
-static void init_cutvalues(void)
+static void init_cutvalues(ns_context_t * C)
 {
-    dfs_range(GD_nlist(G), NULL, 1);
-    dfs_cutval(GD_nlist(G), NULL);
+    dfs_range(C->Nlist, NULL, 1);
+    dfs_cutval(C->Nlist, NULL);
+    neg_init(C);
 }
 
-static int feasible_tree(void)
+static int feasible_tree(ns_context_t * C)
 {
     int i, delta;
     node_t *n;
     edge_t *e, *f;
 
-    if (N_nodes <= 1)
+    if (C->N_nodes <= 1)
 	return 0;
-    while (tight_tree() < N_nodes) {
+    while (tight_tree(C) < C->N_nodes) {
 	e = NULL;
-	for (n = GD_nlist(G); n; n = ND_next(n)) {
+	for (n = C->Nlist; n; n = ND_next(n)) {
 	    for (i = 0; (f = ND_out(n).list[i]); i++) {
 		if ((TREE_EDGE(f) == FALSE) && incident(f) && ((e == NULL)
 							       || (SLACK(f)
@@ -331,29 +570,30 @@ static int feasible_tree(void)
 	    if (delta) {
 		if (incident(e) == aghead(e))
 		    delta = -delta;
-		for (i = 0; i < Tree_node.size; i++)
-		    ND_rank(Tree_node.list[i]) += delta;
+		for (i = 0; i < C->Tree_node.size; i++)
+		    ND_rank(C->Tree_node.list[i]) += delta;
 	    }
 	} else {
 #ifdef DEBUG
 	    fprintf(stderr, "not in tight tree:\n");
-	    for (n = GD_nlist(G); n; n = ND_next(n)) {
-		for (i = 0; i < Tree_node.size; i++)
-		    if (Tree_node.list[i] == n)
+	    for (n = C->Nlist; n; n = ND_next(n)) {
+		for (i = 0; i < C->Tree_node.size; i++)
+		    if (C->Tree_node.list[i] == n)
 			break;
-		if (i >= Tree_node.size)
+		if (i >= C->Tree_node.size)
 		    fprintf(stderr, "\t%s\n", agnameof(n));
 	    }
 #endif
 	    return 1;
 	}
     }
-    init_cutvalues();
+    init_cutvalues(C);
     return 0;
 }
 
 /* walk up from v to LCA(v,w), setting new cutvalues. */
-static node_t *treeupdate(node_t * v, node_t * w, int cutvalue, int dir)
+static node_t *treeupdate(ns_context_t * C, node_t * v, node_t * w,
+			  int cutvalue, int dir)
 {
     edge_t *e;
     int d;
@@ -368,6 +608,7 @@ static node_t *treeupdate(node_t * v, node_t * w, int cutvalue, int dir)
 	    ED_cutvalue(e) += cutvalue;
 	else
 	    ED_cutvalue(e) -= cutvalue;
+	neg_update(C, ED_tree_index(e));
 	if (ND_lim(agtail(e)) > ND_lim(aghead(e)))
 	    v = agtail(e);
 	else
@@ -394,7 +635,7 @@ static void rerank(node_t * v, int delta)
  * is entering.  compute new cut values, ranks, and exchange e and f.
  */
 static void 
-update(edge_t * e, edge_t * f)
+update(ns_context_t * C, edge_t * e, edge_t * f)
 {
     int cutvalue, delta;
     node_t *lca;
@@ -420,57 +661,58 @@ update(edge_t * e, edge_t * f)
     }
 
     cutvalue = ED_cutvalue(e);
-    lca = treeupdate(agtail(f), aghead(f), cutvalue, 1);
-    if (treeupdate(aghead(f), agtail(f), cutvalue, 0) != lca) {
+    lca = treeupdate(C, agtail(f), aghead(f), cutvalue, 1);
+    if (treeupdate(C, aghead(f), agtail(f), cutvalue, 0) != lca) {
 	agerr(AGERR, "update: mismatched lca in treeupdates\n");
-	longjmp (jbuf, 1);
+	longjmp (C->jbuf, 1);
     }
     ED_cutvalue(f) = -cutvalue;
     ED_cutvalue(e) = 0;
-    exchange_tree_edges(e, f);
+    exchange_tree_edges(C, e, f);
+    neg_update(C, ED_tree_index(f));
     dfs_range(lca, ND_par(lca), ND_low(lca));
 }
 
-static void scan_and_normalize(void)
+static void scan_and_normalize(ns_context_t * C)
 {
     node_t *n;
 
-    Minrank = INT_MAX;
-    Maxrank = -INT_MAX;
-    for (n = GD_nlist(G); n; n = ND_next(n)) {
+    C->Minrank = INT_MAX;
+    C->Maxrank = -INT_MAX;
+    for (n = C->Nlist; n; n = ND_next(n)) {
 	if (ND_node_type(n) == NORMAL) {
-	    Minrank = MIN(Minrank, ND_rank(n));
-	    Maxrank = MAX(Maxrank, ND_rank(n));
+	    C->Minrank = MIN(C->Minrank, ND_rank(n));
+	    C->Maxrank = MAX(C->Maxrank, ND_rank(n));
 	}
     }
-    if (Minrank != 0) {
-	for (n = GD_nlist(G); n; n = ND_next(n))
-	    ND_rank(n) -= Minrank;
-	Maxrank -= Minrank;
-	Minrank = 0;
+    if (C->Minrank != 0) {
+	for (n = C->Nlist; n; n = ND_next(n))
+	    ND_rank(n) -= C->Minrank;
+	C->Maxrank -= C->Minrank;
+	C->Minrank = 0;
     }
 }
 
 static void
-freeTreeList (graph_t* g)
+freeTreeList (ns_context_t * C)
 {
     node_t *n;
-    for (n = GD_nlist(G); n; n = ND_next(n)) {
+    for (n = C->Nlist; n; n = ND_next(n)) {
 	free_list(ND_tree_in(n));
 	free_list(ND_tree_out(n));
 	ND_mark(n) = FALSE;
     }
 }
 
-static void LR_balance(void)
+static void LR_balance(ns_context_t * C)
 {
     int i, delta;
     edge_t *e, *f;
 
-    for (i = 0; i < Tree_edge.size; i++) {
-	e = Tree_edge.list[i];
+    for (i = 0; i < C->Tree_edge.size; i++) {
+	e = C->Tree_edge.list[i];
 	if (ED_cutvalue(e) == 0) {
-	    f = enter_edge(e);
+	    f = enter_edge(C, e);
 	    if (f == NULL)
 		continue;
 	    delta = SLACK(f);
@@ -482,31 +724,31 @@ static void LR_balance(void)
 		rerank(aghead(e), -delta / 2);
 	}
     }
-    freeTreeList (G);
+    freeTreeList (C);
 }
 
-static void TB_balance(void)
+static void TB_balance(ns_context_t * C)
 {
     node_t *n;
     edge_t *e;
     int i, low, high, choice, *nrank;
     int inweight, outweight;
 
-    scan_and_normalize();
+    scan_and_normalize(C);
 
     /* find nodes that are not tight and move to less populated ranks */
-    nrank = N_NEW(Maxrank + 1, int);
-    for (i = 0; i <= Maxrank; i++)
+    nrank = N_NEW(C->Maxrank + 1, int);
+    for (i = 0; i <= C->Maxrank; i++)
 	nrank[i] = 0;
-    for (n = GD_nlist(G); n; n = ND_next(n))
+    for (n = C->Nlist; n; n = ND_next(n))
 	if (ND_node_type(n) == NORMAL)
 	    nrank[ND_rank(n)]++;
-    for (n = GD_nlist(G); n; n = ND_next(n)) {
+    for (n = C->Nlist; n; n = ND_next(n)) {
 	if (ND_node_type(n) != NORMAL)
 	    continue;
 	inweight = outweight = 0;
 	low = 0;
-	high = Maxrank;
+	high = C->Maxrank;
 	for (i = 0; (e = ND_in(n).list[i]); i++) {
 	    inweight += ED_weight(e);
 	    low = MAX(low, ND_rank(agtail(e)) + ED_minlen(e));
@@ -533,28 +775,29 @@ static void TB_balance(void)
     free(nrank);
 }
 
-static int init_graph(graph_t * g)
+static int init_graph(ns_context_t * C, graph_t * g, node_t * nlist)
 {
     int i, feasible;
     node_t *n;
     edge_t *e;
 
-    G = g;
-    N_nodes = N_edges = S_i = 0;
-    for (n = GD_nlist(g); n; n = ND_next(n)) {
+    C->G = g;
+    C->Nlist = nlist;
+    C->N_nodes = C->N_edges = C->S_i = 0;
+    for (n = nlist; n; n = ND_next(n)) {
 	ND_mark(n) = FALSE;
-	N_nodes++;
+	C->N_nodes++;
 	for (i = 0; (e = ND_out(n).list[i]); i++)
-	    N_edges++;
+	    C->N_edges++;
     }
 
-    Tree_node.list = ALLOC(N_nodes, Tree_node.list, node_t *);
-    Tree_node.size = 0;
-    Tree_edge.list = ALLOC(N_nodes, Tree_edge.list, edge_t *);
-    Tree_edge.size = 0;
+    C->Tree_node.list = ALLOC(C->N_nodes, C->Tree_node.list, node_t *);
+    C->Tree_node.size = 0;
+    C->Tree_edge.list = ALLOC(C->N_nodes, C->Tree_edge.list, edge_t *);
+    C->Tree_edge.size = 0;
 
     feasible = TRUE;
-    for (n = GD_nlist(g); n; n = ND_next(n)) {
+    for (n = nlist; n; n = ND_next(n)) {
 	ND_priority(n) = 0;
 	for (i = 0; (e = ND_in(n).list[i]); i++) {
 	    ND_priority(n)++;
@@ -574,17 +817,17 @@ static int init_graph(graph_t * g)
 }
 
 /* graphSize:
- * Compute no. of nodes and edges in the graph
+ * Compute no. of nodes and edges in the node list
  */
 static void
-graphSize (graph_t * g, int* nn, int* ne)
+graphSize (node_t * nlist, int* nn, int* ne)
 {
     int i, nnodes, nedges;
     node_t *n;
     edge_t *e;
    
     nnodes = nedges = 0;
-    for (n = GD_nlist(g); n; n = ND_next(n)) {
+    for (n = nlist; n; n = ND_next(n)) {
 	nnodes++;
 	for (i = 0; (e = ND_out(n).list[i]); i++) {
 	    nedges++;
@@ -594,21 +837,27 @@ graphSize (graph_t * g, int* nn, int* ne)
     *ne = nedges;
 }
 
-/* rank:
- * Apply network simplex to rank the nodes in a graph.
+/* ns_rank:
+ * Apply network simplex to rank the nodes in the list starting at nlist
+ * and linked using ND_next. The list is normally GD_nlist(g), but may be
+ * any set of nodes closed under ND_out and ND_in, e.g., one entry of
+ * GD_comp(g). All working state is kept in C, so calls using distinct
+ * contexts on disjoint node lists may run concurrently.
  * Uses ED_minlen as the internode constraint: if a->b with minlen=ml,
  * rank b - rank a >= ml.
  * Assumes the graph has the following additional structure:
- *   A list of all nodes, starting at GD_nlist, and linked using ND_next.
  *   Out and in edges lists stored in ND_out and ND_in, even if the node
  *  doesn't have any out or in edges.
  * The node rank values are stored in ND_rank.
- * Returns 0 if successful; returns 1 if `he graph was not connected;
+ * If search_size < 0, the default SEARCHSIZE is used.
+ * Returns 0 if successful; returns 1 if the graph was not connected;
  * returns 2 if something seriously wrong;
  */
-int rank2(graph_t * g, int balance, int maxiter, int search_size)
+int ns_rank(ns_context_t * C, graph_t * g, node_t * nlist, int balance,
+	    int maxiter, int search_size)
 {
-    int iter = 0, feasible;
+    volatile int iter = 0;	/* updated between setjmp and longjmp */
+    int feasible;
     char *ns = "network simplex: ";
     edge_t *e, *f;
 
@@ -617,35 +866,35 @@ int rank2(graph_t * g, int balance, int maxiter, int search_size)
 #endif
     if (Verbose) {
 	int nn, ne;
-	graphSize (g, &nn, &ne);
+	graphSize (nlist, &nn, &ne);
 	fprintf(stderr, "%s %d nodes %d edges maxiter=%d balance=%d\n", ns,
 	    nn, ne, maxiter, balance);
-	start_timer();
+	C->Start = clock();
     }
-    feasible = init_graph(g);
+    feasible = init_graph(C, g, nlist);
     if (!feasible)
-	init_rank();
+	init_rank(C);
     if (maxiter <= 0) {
-	freeTreeList (g);
+	freeTreeList (C);
 	return 0;
     }
 
     if (search_size >= 0)
-	Search_size = search_size;
+	C->Search_size = search_size;
     else
-	Search_size = SEARCHSIZE;
+	C->Search_size = SEARCHSIZE;
 
-    if (setjmp (jbuf)) {
+    if (setjmp (C->jbuf)) {
 	return 2;
     }
 
-    if (feasible_tree()) {
-	freeTreeList (g);
+    if (feasible_tree(C)) {
+	freeTreeList (C);
 	return 1;
     }
-    while ((e = leave_edge())) {
-	f = enter_edge(e);
-	update(e, f);
+    while ((e = leave_edge(C))) {
+	f = enter_edge(C, e);
+	update(C, e, f);
 	iter++;
 	if (Verbose && (iter % 100 == 0)) {
 	    if (iter % 1000 == 100)
@@ -659,36 +908,56 @@ int rank2(graph_t * g, int balance, int maxiter, int search_size)
     }
     switch (balance) {
     case 1:
-	TB_balance();
+	TB_balance(C);
 	break;
     case 2:
-	LR_balance();
+	LR_balance(C);
 	break;
     default:
-	scan_and_normalize();
-	freeTreeList (G);
+	scan_and_normalize(C);
+	freeTreeList (C);
 	break;
     }
     if (Verbose) {
 	if (iter >= 100)
 	    fputc('\n', stderr);
 	fprintf(stderr, "%s%d nodes %d edges %d iter %.2f sec\n",
-		ns, N_nodes, N_edges, iter, elapsed_sec());
+		ns, C->N_nodes, C->N_edges, iter,
+		(double) (clock() - C->Start) / CLOCKS_PER_SEC);
     }
     return 0;
 }
 
+/* rank2:
+ * Rank the nodes of GD_nlist(g) using a private context.
+ * See ns_rank for the details.
+ */
+int rank2(graph_t * g, int balance, int maxiter, int search_size)
+{
+    ns_context_t *C = ns_context_new();
+    int rv;
+
+    rv = ns_rank(C, g, GD_nlist(g), balance, maxiter, search_size);
+    ns_context_free(C);
+    return rv;
+}
+
 int rank(graph_t * g, int balance, int maxiter)
 {
     char *s;
-    int search_size;
+    int search_size, rv;
+    ns_context_t *C;
 
     if ((s = agget(g, "searchsize")))
 	search_size = atoi(s);
     else
 	search_size = SEARCHSIZE;
 
-    return rank2 (g, balance, maxiter, search_size);
+    C = ns_context_new();
+    ns_context_set_pivot(C, ns_pivot(g));
+    rv = ns_rank(C, g, GD_nlist(g), balance, maxiter, search_size);
+    ns_context_free(C);
+    return rv;
 }
 
 /* set cut value of f, assuming values of edges on one side were already set */
@@ -787,7 +1056,7 @@ static int dfs_range(node_t * v, edge_t * par, int low)
 }
 
 #ifdef DEBUG
-void tchk(void)
+void tchk(ns_context_t * C)
 {
     int i, n_cnt, e_cnt;
     node_t *n;
@@ -795,7 +1064,7 @@ void tchk(void)
 
     n_cnt = 0;
     e_cnt = 0;
-    for (n = agfstnode(G); n; n = agnxtnode(G, n)) {
+    for (n = agfstnode(C->G); n; n = agnxtnode(C->G, n)) {
 	n_cnt++;
 	for (i = 0; (e = ND_tree_out(n).list[i]); i++) {
 	    e_cnt++;
@@ -803,17 +1072,17 @@ void tchk(void)
 		fprintf(stderr, "not a tight tree %p", e);
 	}
     }
-    if ((n_cnt != Tree_node.size) || (e_cnt != Tree_edge.size))
+    if ((n_cnt != C->Tree_node.size) || (e_cnt != C->Tree_edge.size))
 	fprintf(stderr, "something missing\n");
 }
 
-void check_cutvalues(void)
+void check_cutvalues(ns_context_t * C)
 {
     node_t *v;
     edge_t *e;
     int i, save;
 
-    for (v = agfstnode(G); v; v = agnxtnode(G, v)) {
+    for (v = agfstnode(C->G); v; v = agnxtnode(C->G, v)) {
 	for (i = 0; (e = ND_tree_out(v).list[i]); i++) {
 	    save = ED_cutvalue(e);
 	    x_cutval(e);
@@ -823,14 +1092,14 @@ void check_cutvalues(void)
     }
 }
 
-int check_ranks(void)
+int check_ranks(ns_context_t * C)
 {
     int cost = 0;
     node_t *n;
     edge_t *e;
 
-    for (n = agfstnode(G); n; n = agnxtnode(G, n)) {
-	for (e = agfstout(G, n); e; e = agnxtout(G, e)) {
+    for (n = agfstnode(C->G); n; n = agnxtnode(C->G, n)) {
+	for (e = agfstout(C->G, n); e; e = agnxtout(C->G, e)) {
 	    cost += (ED_weight(e)) * abs(LENGTH(e));
 	    if (ND_rank(aghead(e)) - ND_rank(agtail(e)) - ED_minlen(e) < 0)
 		abort();
@@ -840,13 +1109,13 @@ int check_ranks(void)
     return cost;
 }
 
-void checktree(void)
+void checktree(ns_context_t * C)
 {
     int i, n = 0, m = 0;
     node_t *v;
     edge_t *e;
 
-    for (v = agfstnode(G); v; v = agnxtnode(G, v)) {
+    for (v = agfstnode(C->G); v; v = agnxtnode(C->G, v)) {
 	for (i = 0; (e = ND_tree_out(v).list[i]); i++)
 	    n++;
 	if (i != ND_tree_out(v).size)
@@ -856,7 +1125,7 @@ void checktree(void)
 	if (i != ND_tree_in(v).size)
 	    abort();
     }
-    fprintf(stderr, "%d %d %d\n", Tree_edge.size, n, m);
+    fprintf(stderr, "%d %d %d\n", C->Tree_edge.size, n, m);
 }
 
 void check_fast_node(node_t * n)
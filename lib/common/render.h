@@ -64,6 +64,15 @@ extern "C" {
 
     typedef void (*nodesizefn_t) (Agnode_t *, boolean);
 
+    typedef struct ns_context_s ns_context_t;
+
+    /* leaving edge selection in network simplex */
+    typedef enum {
+	NS_PIVOT_BLOCK,		/* best of the next searchsize candidates */
+	NS_PIVOT_FIRST,		/* first eligible candidate */
+	NS_PIVOT_BEST		/* best over all candidates (Dantzig) */
+    } ns_pivot_t;
+
 /*visual studio*/
 #ifdef WIN32
 #ifndef GVC_EXPORTS
@@ -109,6 +118,7 @@ extern "C" {
     /* extern void emit_begin_edge(GVJ_t * job, edge_t * e, char**); */
     /* extern void emit_end_edge(GVJ_t * job); */
     extern void emit_graph(GVJ_t * job, graph_t * g);
+    extern void emit_free_spdx(graph_t * g);
     extern void emit_label(GVJ_t * job, emit_state_t emit_state, textlabel_t *);
     extern int emit_once(char *message);
     extern void emit_jobs_eof(GVC_t * gvc);
@@ -138,6 +148,11 @@ extern "C" {
     extern void place_graph_label(Agraph_t *);
     extern int place_portlabel(edge_t * e, boolean head_p);
     extern void makePortLabels(edge_t * e);
+    extern ns_context_t *ns_context_new(void);
+    extern void ns_context_free(ns_context_t *);
+    extern void ns_context_set_pivot(ns_context_t *, ns_pivot_t);
+    extern ns_pivot_t ns_pivot(graph_t *);
+    extern int ns_rank(ns_context_t *, graph_t *, node_t *, int, int, int);
     extern pointf edgeMidpoint(graph_t* g, edge_t * e);
     extern void addEdgeLabels(graph_t* g, edge_t * e, pointf rp, pointf rq);
     extern void pop_obj_state(GVJ_t *job);
@@ -35,7 +35,7 @@ static void flat_reorder(graph_t * g);
 static void flat_search(graph_t * g, node_t * v);
 static void init_mincross(graph_t * g);
 static void merge2(graph_t * g);
-static void init_mccomp(graph_t * g, int c);
+static int mincross_comps(graph_t * g, int doBalance);
 static void cleanup2(graph_t * g, int nc);
 static int mincross_clust(graph_t * par, graph_t * g, int);
 static int mincross(graph_t * g, int startpass, int endpass, int);
@@ -70,6 +70,33 @@ static edge_t **TE_list;
 static int *TI_list;
 static boolean ReMincross;
 
+	/* component being ordered by this thread (see mincross_comps) */
+static rank_t *Comprank;
+static node_t *Compnlist;
+
+	/* rcross scratch */
+static int *Count, C;
+
+	/* endpoint of an edge on the adjacent rank, for sort_cross */
+typedef struct {
+    int order;
+    double x;		/* port offset */
+    int wt;
+} xend_t;
+static xend_t *Xend;
+static int Xsize;
+
+#pragma omp threadprivate(Root, TI_list, Comprank, Compnlist, Count, C, Xend, Xsize)
+
+	/* product of degrees above which in_cross and out_cross sort */
+#define SORT_CROSS	64
+
+/* While the components of the root are ordered, each one works on
+ * a private copy of the root's rank array and its own node list.
+ */
+#define RANK(g)		((Comprank && (g) == Root) ? Comprank : GD_rank(g))
+#define NLIST(g)	((Comprank && (g) == Root) ? Compnlist : GD_nlist(g))
+
 #if DEBUG > 1
 static void indent(graph_t* g)
 {
@@ -336,10 +363,7 @@ void dot_mincross(graph_t * g, int doBalance)
 
     init_mincross(g);
 
-    for (nc = c = 0; c < GD_comp(g).size; c++) {
-	init_mccomp(g, c);
-	nc += mincross(g, 0, 2, doBalance);
-    }
+    nc = mincross_comps(g, doBalance);
 
     merge2(g);
 
@@ -384,17 +408,107 @@ static void free_matrix(adjmatrix_t * p)
 
 #define ELT(M,i,j)		(M->data[((i)*M->ncols)+(j)])
 
-static void init_mccomp(graph_t * g, int c)
+/* mincross_comps:
+ * Run mincross on each connected component of the root.
+ * The components share no nodes or edges, and each is installed in
+ * its own slice of the root's rank arrays, so they are ordered
+ * concurrently when OpenMP is available. The slices are laid out from
+ * the node counts of the components; afterwards they are packed and
+ * the root's rank array is left as ordering the components one after
+ * another would leave it, including the flat matrices remincross sees.
+ * Restarts of one component are not run concurrently: its order and
+ * best order live in the node records, which the trials would share.
+ */
+static int mincross_comps(graph_t * g, int doBalance)
 {
-    int r;
+    int c, r, k, nc, ncomp, nranks, size;
+    int *base;
+    rank_t **ranks, *rk;
+    node_t *n, **v;
 
-    GD_nlist(g) = GD_comp(g).list[c];
-    if (c > 0) {
-	for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	    GD_rank(g)[r].v = GD_rank(g)[r].v + GD_rank(g)[r].n;
-	    GD_rank(g)[r].n = 0;
+    ncomp = GD_comp(g).size;
+    if (ncomp == 0)
+	return 0;
+    nranks = GD_maxrank(g) + 2;
+    size = agnedges(dot_root(g)) + 1;
+
+    /* base[c*nranks+r] is the start of the slice of component c in rank r */
+    base = N_NEW(ncomp * nranks, int);
+    for (c = 0; c < ncomp; c++)
+	for (n = GD_comp(g).list[c]; n; n = ND_next(n))
+	    base[c * nranks + ND_rank(n)]++;
+    for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+	for (k = c = 0; c < ncomp; c++) {
+	    int cnt = base[c * nranks + r];
+	    base[c * nranks + r] = k;
+	    k += cnt;
+	}
+    }
+
+    ranks = N_NEW(ncomp, rank_t *);
+    nc = 0;
+#pragma omp parallel if (ncomp > 1) private(c, r, rk)
+    {
+	int worker = (TI_list == NULL);
+
+	if (worker) {
+	    Root = g;
+	    TI_list = N_NEW(size, int);
+	}
+#pragma omp for schedule(dynamic) reduction(+:nc)
+	for (c = 0; c < ncomp; c++) {
+	    rk = ranks[c] = N_NEW(nranks, rank_t);
+	    for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+		rk[r].an = GD_rank(g)[r].an;
+		rk[r].av = GD_rank(g)[r].av;
+		rk[r].v = rk[r].av + base[c * nranks + r];
+	    }
+	    Comprank = rk;
+	    Compnlist = GD_comp(g).list[c];
+	    nc += mincross(g, 0, 2, doBalance);
+	    Comprank = NULL;
+	    Compnlist = NULL;
+	}
+	if (worker) {
+	    free(TI_list);
+	    TI_list = NULL;
+	    free(Count);
+	    Count = NULL;
+	    C = 0;
+	    free(Xend);
+	    Xend = NULL;
+	    Xsize = 0;
 	}
     }
+
+    /* pack the slices, keeping the state of the last component */
+    for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+	v = GD_rank(g)[r].av;
+	for (k = c = 0; c < ncomp; c++) {
+	    rk = ranks[c];
+	    if (rk[r].v != v + k)
+		memmove(v + k, rk[r].v, rk[r].n * sizeof(node_t *));
+	    if (rk[r].flat) {
+		free_matrix(GD_rank(g)[r].flat);
+		GD_rank(g)[r].flat = rk[r].flat;
+	    }
+	    GD_rank(g)[r].v = v + k;
+	    k += rk[r].n;
+	}
+	if (k < GD_rank(g)[r].an)
+	    memset(v + k, 0, (GD_rank(g)[r].an - k) * sizeof(node_t *));
+	rk = ranks[ncomp - 1];
+	GD_rank(g)[r].n = rk[r].n;
+	GD_rank(g)[r].candidate = rk[r].candidate;
+	GD_rank(g)[r].valid = rk[r].valid;
+	GD_rank(g)[r].cache_nc = rk[r].cache_nc;
+    }
+    for (c = 0; c < ncomp; c++)
+	free(ranks[c]);
+    free(ranks);
+    free(base);
+    GD_nlist(g) = GD_comp(g).list[ncomp - 1];
+    return nc;
 }
 
 static int betweenclust(edge_t * e)
@@ -546,7 +660,7 @@ static int left2right(graph_t * g, node_t * v, node_t * w)
 	if ((ND_clust(v)) != (ND_clust(w)))
 	    return TRUE;
     }
-    M = GD_rank(g)[ND_rank(v)].flat;
+    M = RANK(g)[ND_rank(v)].flat;
     if (M == NULL)
 	rv = FALSE;
     else {
@@ -560,10 +674,83 @@ static int left2right(graph_t * g, node_t * v, node_t * w)
     return rv;
 }
 
-static int in_cross(node_t * v, node_t * w)
+static int xendcmpf(xend_t * x0, xend_t * x1)
+{
+    if (x0->order != x1->order)
+	return x0->order - x1->order;
+    if (x0->x < x1->x)
+	return -1;
+    if (x0->x > x1->x)
+	return 1;
+    return 0;
+}
+
+/* sort_cross:
+ * Weighted number of pairs (e1,e2), e1 in l1 and e2 in l2, whose
+ * endpoints on the adjacent rank are in the opposite order, i.e.
+ * e1's endpoint lies to the right of e2's, with port offsets breaking
+ * ties. This is what in_cross and out_cross count; here l1 is sorted
+ * by endpoint so each edge of l2 costs one binary search rather than
+ * a scan of l1.
+ */
+static int sort_cross(edge_t ** l1, int n1, edge_t ** l2, int out)
+{
+    int i, lo, hi, cross = 0;
+    node_t *u;
+    double x;
+    edge_t *e;
+
+    if (Xsize < n1) {
+	Xsize = n1;
+	Xend = ALLOC(Xsize, Xend, xend_t);
+    }
+    for (i = 0; i < n1; i++) {
+	e = l1[i];
+	Xend[i].order = ND_order(out ? aghead(e) : agtail(e));
+	Xend[i].x = (out ? ED_head_port(e) : ED_tail_port(e)).p.x;
+	Xend[i].wt = ED_xpenalty(e);
+    }
+    qsort(Xend, n1, sizeof(xend_t), (qsort_cmpf) xendcmpf);
+    /* suffix sums, so Xend[i].wt weighs all endpoints from i on */
+    for (i = n1 - 2; i >= 0; i--)
+	Xend[i].wt += Xend[i + 1].wt;
+
+    for (; (e = *l2); l2++) {
+	u = out ? aghead(e) : agtail(e);
+	x = (out ? ED_head_port(e) : ED_tail_port(e)).p.x;
+	/* find the first endpoint strictly to the right of e's */
+	lo = 0;
+	hi = n1;
+	while (lo < hi) {
+	    i = (lo + hi) / 2;
+	    if ((Xend[i].order < ND_order(u))
+		|| ((Xend[i].order == ND_order(u)) && (Xend[i].x <= x)))
+		lo = i + 1;
+	    else
+		hi = i;
+	}
+	if (lo < n1)
+	    cross += Xend[lo].wt * ED_xpenalty(e);
+    }
+    return cross;
+}
+
+/* in_cross:
+ * Add to *c0 the crossings among the in-edges of v and w when v is
+ * left of w, and to *c1 those when w is left of v. Both orders are
+ * counted in one pass over the pairs of edges.
+ */
+static void in_cross(node_t * v, node_t * w, int *c0, int *c1)
 {
     register edge_t **e1, **e2;
-    register int inv, cross = 0, t;
+    register int inv, t;
+    int cross0 = 0, cross1 = 0;
+
+    if (ND_in(v).size * ND_in(w).size > SORT_CROSS) {
+	*c0 += sort_cross(ND_in(v).list, ND_in(v).size, ND_in(w).list, FALSE);
+	*c1 += sort_cross(ND_in(w).list, ND_in(w).size, ND_in(v).list, FALSE);
+	return;
+    }
 
     for (e2 = ND_in(w).list; *e2; e2++) {
 	register int cnt = ED_xpenalty(*e2);		
@@ -575,16 +762,31 @@ static int in_cross(node_t * v, node_t * w)
 	    if ((t > 0)
 		|| ((t == 0)
 		    && (  ED_tail_port(*e1).p.x > ED_tail_port(*e2).p.x)))
-		cross += ED_xpenalty(*e1) * cnt;
+		cross0 += ED_xpenalty(*e1) * cnt;
+	    else if ((t < 0)
+		|| ((t == 0)
+		    && (  ED_tail_port(*e1).p.x < ED_tail_port(*e2).p.x)))
+		cross1 += ED_xpenalty(*e1) * cnt;
 	}
     }
-    return cross;
+    *c0 += cross0;
+    *c1 += cross1;
 }
 
-static int out_cross(node_t * v, node_t * w)
+/* out_cross:
+ * As in_cross, for the out-edges of v and w.
+ */
+static void out_cross(node_t * v, node_t * w, int *c0, int *c1)
 {
     register edge_t **e1, **e2;
-    register int inv, cross = 0, t;
+    register int inv, t;
+    int cross0 = 0, cross1 = 0;
+
+    if (ND_out(v).size * ND_out(w).size > SORT_CROSS) {
+	*c0 += sort_cross(ND_out(v).list, ND_out(v).size, ND_out(w).list, TRUE);
+	*c1 += sort_cross(ND_out(w).list, ND_out(w).size, ND_out(v).list, TRUE);
+	return;
+    }
 
     for (e2 = ND_out(w).list; *e2; e2++) {
 	register int cnt = ED_xpenalty(*e2);
@@ -595,11 +797,15 @@ static int out_cross(node_t * v, node_t * w)
 	    if ((t > 0)
 		|| ((t == 0)
 		    && ((ED_head_port(*e1)).p.x > (ED_head_port(*e2)).p.x)))
-		cross += ((ED_xpenalty(*e1)) * cnt);
+		cross0 += ((ED_xpenalty(*e1)) * cnt);
+	    else if ((t < 0)
+		|| ((t == 0)
+		    && ((ED_head_port(*e1)).p.x < (ED_head_port(*e2)).p.x)))
+		cross1 += ((ED_xpenalty(*e1)) * cnt);
 	}
     }
-    return cross;
-
+    *c0 += cross0;
+    *c1 += cross1;
 }
 
 static void exchange(node_t * v, node_t * w)
@@ -610,9 +816,9 @@ static void exchange(node_t * v, node_t * w)
     vi = ND_order(v);
     wi = ND_order(w);
     ND_order(v) = wi;
-    GD_rank(Root)[r].v[wi] = v;
+    RANK(Root)[r].v[wi] = v;
     ND_order(w) = vi;
-    GD_rank(Root)[r].v[vi] = w;
+    RANK(Root)[r].v[vi] = w;
 }
 
 static void balanceNodes(graph_t * g, int r, node_t * v, node_t * w)
@@ -628,8 +834,8 @@ static void balanceNodes(graph_t * g, int r, node_t * v, node_t * w)
 	return;
 
     /* count the number of dummy and original nodes */
-    for (i = 0; i < GD_rank(g)[r].n; i++) {
-	if (ND_node_type(GD_rank(g)[r].v[i]) == NORMAL)
+    for (i = 0; i < RANK(g)[r].n; i++) {
+	if (ND_node_type(RANK(g)[r].v[i]) == NORMAL)
 	    cntOri++;
 	else
 	    cntDummy++;
@@ -648,8 +854,8 @@ static void balanceNodes(graph_t * g, int r, node_t * v, node_t * w)
     }
 
     /* get the separator node index */
-    for (i = 0; i < GD_rank(g)[r].n; i++) {
-	if (GD_rank(g)[r].v[i] == s)
+    for (i = 0; i < RANK(g)[r].n; i++) {
+	if (RANK(g)[r].v[i] == s)
 	    sepIndex = i;
     }
 
@@ -659,14 +865,14 @@ static void balanceNodes(graph_t * g, int r, node_t * v, node_t * w)
      * right of the separator node 
      */
     for (i = sepIndex - 1; i >= 0; i--) {
-	if (ND_node_type(GD_rank(g)[r].v[i]) == nullType)
+	if (ND_node_type(RANK(g)[r].v[i]) == nullType)
 	    k++;
 	else
 	    break;
     }
 
-    for (i = sepIndex + 1; i < GD_rank(g)[r].n; i++) {
-	if (ND_node_type(GD_rank(g)[r].v[i]) == nullType)
+    for (i = sepIndex + 1; i < RANK(g)[r].n; i++) {
+	if (ND_node_type(RANK(g)[r].v[i]) == nullType)
 	    m++;
 	else
 	    break;
@@ -677,8 +883,8 @@ static void balanceNodes(graph_t * g, int r, node_t * v, node_t * w)
     exchange(v, w);
 
     /* get the separator node index */
-    for (i = 0; i < GD_rank(g)[r].n; i++) {
-	if (GD_rank(g)[r].v[i] == s)
+    for (i = 0; i < RANK(g)[r].n; i++) {
+	if (RANK(g)[r].v[i] == s)
 	    sepIndex = i;
     }
 
@@ -686,14 +892,14 @@ static void balanceNodes(graph_t * g, int r, node_t * v, node_t * w)
      * right of the separator node 
      */
     for (i = sepIndex - 1; i >= 0; i--) {
-	if (ND_node_type(GD_rank(g)[r].v[i]) == nullType)
+	if (ND_node_type(RANK(g)[r].v[i]) == nullType)
 	    k1++;
 	else
 	    break;
     }
 
-    for (i = sepIndex + 1; i < GD_rank(g)[r].n; i++) {
-	if (ND_node_type(GD_rank(g)[r].v[i]) == nullType)
+    for (i = sepIndex + 1; i < RANK(g)[r].n; i++) {
+	if (ND_node_type(RANK(g)[r].v[i]) == nullType)
 	    m1++;
 	else
 	    break;
@@ -714,37 +920,33 @@ static int balance(graph_t * g)
 
     for (r = GD_maxrank(g); r >= GD_minrank(g); r--) {
 
-	GD_rank(g)[r].candidate = FALSE;
-	for (i = 0; i < GD_rank(g)[r].n - 1; i++) {
-	    v = GD_rank(g)[r].v[i];
-	    w = GD_rank(g)[r].v[i + 1];
+	RANK(g)[r].candidate = FALSE;
+	for (i = 0; i < RANK(g)[r].n - 1; i++) {
+	    v = RANK(g)[r].v[i];
+	    w = RANK(g)[r].v[i + 1];
 	    assert(ND_order(v) < ND_order(w));
 	    if (left2right(g, v, w))
 		continue;
 	    c0 = c1 = 0;
-	    if (r > 0) {
-		c0 += in_cross(v, w);
-		c1 += in_cross(w, v);
-	    }
+	    if (r > 0)
+		in_cross(v, w, &c0, &c1);
 
-	    if (GD_rank(g)[r + 1].n > 0) {
-		c0 += out_cross(v, w);
-		c1 += out_cross(w, v);
-	    }
+	    if (RANK(g)[r + 1].n > 0)
+		out_cross(v, w, &c0, &c1);
 #if 0
 	    if ((c1 < c0) || ((c0 > 0) && reverse && (c1 == c0))) {
 		exchange(v, w);
 		rv += (c0 - c1);
-		GD_rank(Root)[r].valid = FALSE;
-		GD_rank(g)[r].candidate = TRUE;
+		RANK(Root)[r].valid = FALSE;
+		RANK(g)[r].candidate = TRUE;
 
 		if (r > GD_minrank(g)) {
-		    GD_rank(Root)[r - 1].valid = FALSE;
-		    GD_rank(g)[r - 1].candidate = TRUE;
+		    RANK(Root)[r - 1].valid = FALSE;
+		    RANK(g)[r - 1].candidate = TRUE;
 		}
 		if (r < GD_maxrank(g)) {
-		    GD_rank(Root)[r + 1].valid = FALSE;
-		    GD_rank(g)[r + 1].candidate = TRUE;
+		    RANK(Root)[r + 1].valid = FALSE;
+		    RANK(g)[r + 1].candidate = TRUE;
 		}
 	    }
 #endif
@@ -763,36 +965,32 @@ static int transpose_step(graph_t * g, int r, int reverse)
     node_t *v, *w;
 
     rv = 0;
-    GD_rank(g)[r].candidate = FALSE;
-    for (i = 0; i < GD_rank(g)[r].n - 1; i++) {
-	v = GD_rank(g)[r].v[i];
-	w = GD_rank(g)[r].v[i + 1];
+    RANK(g)[r].candidate = FALSE;
+    for (i = 0; i < RANK(g)[r].n - 1; i++) {
+	v = RANK(g)[r].v[i];
+	w = RANK(g)[r].v[i + 1];
 	assert(ND_order(v) < ND_order(w));
 	if (left2right(g, v, w))
 	    continue;
 	c0 = c1 = 0;
-	if (r > 0) {
-	    c0 += in_cross(v, w);
-	    c1 += in_cross(w, v);
-	}
-	if (GD_rank(g)[r + 1].n > 0) {
-	    c0 += out_cross(v, w);
-	    c1 += out_cross(w, v);
-	}
+	if (r > 0)
+	    in_cross(v, w, &c0, &c1);
+	if (RANK(g)[r + 1].n > 0)
+	    out_cross(v, w, &c0, &c1);
 	if ((c1 < c0) || ((c0 > 0) && reverse && (c1 == c0))) {
 	    exchange(v, w);
 	    rv += (c0 - c1);
-	    GD_rank(Root)[r].valid = FALSE;
-	    GD_rank(g)[r].candidate = TRUE;
+	    RANK(Root)[r].valid = FALSE;
+	    RANK(g)[r].candidate = TRUE;
 
 	    if (r > GD_minrank(g)) {
-		GD_rank(Root)[r - 1].valid = FALSE;
-		GD_rank(g)[r - 1].candidate = TRUE;
-	    }
-	    if (r < GD_maxrank(g)) {
-		GD_rank(Root)[r + 1].valid = FALSE;
-		GD_rank(g)[r + 1].candidate = TRUE;
+		RANK(Root)[r - 1].valid = FALSE;
+		RANK(g)[r - 1].candidate = TRUE;
 	    }
+	    /* the count cached for rank r+1 is between r+1 and r+2,
+	     * which this exchange does not change */
+	    if (r < GD_maxrank(g))
+		RANK(g)[r + 1].candidate = TRUE;
 	}
     }
     return rv;
@@ -803,7 +1001,7 @@ static void transpose(graph_t * g, int reverse)
     int r, delta;
 
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++)
-	GD_rank(g)[r].candidate = TRUE;
+	RANK(g)[r].candidate = TRUE;
     do {
 	delta = 0;
 #ifdef NOTDEF
@@ -811,11 +1009,11 @@ static void transpose(graph_t * g, int reverse)
 	   i tried making it depend on whether an odd or even pass, 
 	   but that didn't help. */
 	for (r = GD_maxrank(g); r >= GD_minrank(g); r--)
-	    if (GD_rank(g)[r].candidate)
+	    if (RANK(g)[r].candidate)
 		delta += transpose_step(g, r, reverse);
 #endif
 	for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	    if (GD_rank(g)[r].candidate) {
+	    if (RANK(g)[r].candidate) {
 		delta += transpose_step(g, r, reverse);
 	    }
 	}
@@ -896,14 +1094,14 @@ static void restore_best(graph_t * g)
     /* for (n = GD_nlist(g); n; n = ND_next(n)) */
 	/* ND_order(n) = saveorder(n); */
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	for (i = 0; i < GD_rank(g)[r].n; i++) {
-	    n = GD_rank(g)[r].v[i];
+	for (i = 0; i < RANK(g)[r].n; i++) {
+	    n = RANK(g)[r].v[i];
 	    ND_order(n) = saveorder(n);
 	}
     }
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	GD_rank(Root)[r].valid = FALSE;
-	qsort(GD_rank(g)[r].v, GD_rank(g)[r].n, sizeof(GD_rank(g)[0].v[0]),
+	RANK(Root)[r].valid = FALSE;
+	qsort(RANK(g)[r].v, RANK(g)[r].n, sizeof(RANK(g)[0].v[0]),
 	      (qsort_cmpf) nodeposcmpf);
     }
 }
@@ -915,8 +1113,8 @@ static void save_best(graph_t * g)
 	/* saveorder(n) = ND_order(n); */
     int i, r;
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	for (i = 0; i < GD_rank(g)[r].n; i++) {
-	    n = GD_rank(g)[r].v[i];
+	for (i = 0; i < RANK(g)[r].n; i++) {
+	    n = RANK(g)[r].v[i];
 	    saveorder(n) = ND_order(n);
 	}
     }
@@ -989,6 +1187,11 @@ static void cleanup2(graph_t * g, int nc)
 	free(TE_list);
 	TE_list = NULL;
     }
+    if (Xend) {
+	free(Xend);
+	Xend = NULL;
+	Xsize = 0;
+    }
     /* fix vlists of clusters */
     for (c = 1; c <= GD_n_cluster(g); c++)
 	rec_reset_vlists(GD_clust(g)[c]);
@@ -1023,16 +1226,29 @@ static node_t *neighbor(node_t * v, int dir)
 assert(v);
     if (dir < 0) {
 	if (ND_order(v) > 0)
-	    rv = GD_rank(Root)[ND_rank(v)].v[ND_order(v) - 1];
+	    rv = RANK(Root)[ND_rank(v)].v[ND_order(v) - 1];
     } else
-	rv = GD_rank(Root)[ND_rank(v)].v[ND_order(v) + 1];
+	rv = RANK(Root)[ND_rank(v)].v[ND_order(v) + 1];
 assert((rv == 0) || (ND_order(rv)-ND_order(v))*dir > 0);
     return rv;
 }
 
+/* contains:
+ * agcontains reorganizes the dictionaries it searches, so calls made
+ * while components are ordered concurrently are serialized.
+ */
+static int contains(graph_t * g, void *obj)
+{
+    int rv;
+
+#pragma omp critical (mincross_contains)
+    rv = agcontains(g, obj);
+    return rv;
+}
+
 static int is_a_normal_node_of(graph_t * g, node_t * v)
 {
-    return ((ND_node_type(v) == NORMAL) && agcontains(g, v));
+    return ((ND_node_type(v) == NORMAL) && contains(g, v));
 }
 
 static int is_a_vnode_of_an_edge_of(graph_t * g, node_t * v)
@@ -1042,7 +1258,7 @@ static int is_a_vnode_of_an_edge_of(graph_t * g, node_t * v)
 	edge_t *e = ND_out(v).list[0];
 	while (ED_edge_type(e) != NORMAL)
 	    e = ED_to_orig(e);
-	if (agcontains(g, e))
+	if (contains(g, e))
 	    return TRUE;
     }
     return FALSE;
@@ -1235,7 +1451,7 @@ static void flat_search(graph_t * g, node_t * v)
     int i;
     boolean hascl;
     edge_t *e;
-    adjmatrix_t *M = GD_rank(g)[ND_rank(v)].flat;
+    adjmatrix_t *M = RANK(g)[ND_rank(v)].flat;
 
     ND_mark(v) = TRUE;
     ND_onstack(v) = TRUE;
@@ -1243,7 +1459,7 @@ static void flat_search(graph_t * g, node_t * v)
     if (ND_flat_out(v).list)
 	for (i = 0; (e = ND_flat_out(v).list[i]); i++) {
 	    if (hascl
-		&& NOT(agcontains(g, agtail(e)) && agcontains(g, aghead(e))))
+		&& NOT(contains(g, agtail(e)) && contains(g, aghead(e))))
 		continue;
 	    if (ED_weight(e) == 0)
 		continue;
@@ -1274,19 +1490,19 @@ static void flat_breakcycles(graph_t * g)
 
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
 	flat = 0;
-	for (i = 0; i < GD_rank(g)[r].n; i++) {
-	    v = GD_rank(g)[r].v[i];
+	for (i = 0; i < RANK(g)[r].n; i++) {
+	    v = RANK(g)[r].v[i];
 	    ND_mark(v) = ND_onstack(v) = FALSE;
 	    flatindex(v) = i;
 	    if ((ND_flat_out(v).size > 0) && (flat == 0)) {
-		GD_rank(g)[r].flat =
-		    new_matrix(GD_rank(g)[r].n, GD_rank(g)[r].n);
+		RANK(g)[r].flat =
+		    new_matrix(RANK(g)[r].n, RANK(g)[r].n);
 		flat = 1;
 	    }
 	}
 	if (flat) {
-	    for (i = 0; i < GD_rank(g)[r].n; i++) {
-		v = GD_rank(g)[r].v[i];
+	    for (i = 0; i < RANK(g)[r].n; i++) {
+		v = RANK(g)[r].v[i];
 		if (ND_mark(v) == FALSE)
 		    flat_search(g, v);
 	    }
@@ -1333,30 +1549,30 @@ void install_in_rank(graph_t * g, node_t * n)
     int i, r;
 
     r = ND_rank(n);
-    i = GD_rank(g)[r].n;
-    if (GD_rank(g)[r].an <= 0) {
+    i = RANK(g)[r].n;
+    if (RANK(g)[r].an <= 0) {
 	agerr(AGERR, "install_in_rank, line %d: %s %s rank %d i = %d an = 0\n",
 	      __LINE__, agnameof(g), agnameof(n), r, i);
 	return;
     }
 
-    GD_rank(g)[r].v[i] = n;
+    RANK(g)[r].v[i] = n;
     ND_order(n) = i;
-    GD_rank(g)[r].n++;
-    assert(GD_rank(g)[r].n <= GD_rank(g)[r].an);
+    RANK(g)[r].n++;
+    assert(RANK(g)[r].n <= RANK(g)[r].an);
 #ifdef DEBUG
     {
 	node_t *v;
 
-	for (v = GD_nlist(g); v; v = ND_next(v))
+	for (v = NLIST(g); v; v = ND_next(v))
 	    if (v == n)
 		break;
 	assert(v != NULL);
     }
 #endif
-    if (ND_order(n) > GD_rank(Root)[r].an) {
+    if (ND_order(n) > RANK(Root)[r].an) {
 	agerr(AGERR, "install_in_rank, line %d: ND_order(%s) [%d] > GD_rank(Root)[%d].an [%d]\n",
-	      __LINE__, agnameof(n), ND_order(n), r, GD_rank(Root)[r].an);
+	      __LINE__, agnameof(n), ND_order(n), r, RANK(Root)[r].an);
 	return;
     }
     if ((r < GD_minrank(g)) || (r > GD_maxrank(g))) {
@@ -1364,10 +1580,10 @@ void install_in_rank(graph_t * g, node_t * n)
 	      __LINE__, r, GD_minrank(g), GD_maxrank(g));
 	return;
     }
-    if (GD_rank(g)[r].v + ND_order(n) >
-	GD_rank(g)[r].av + GD_rank(Root)[r].an) {
+    if (RANK(g)[r].v + ND_order(n) >
+	RANK(g)[r].av + RANK(Root)[r].an) {
 	agerr(AGERR, "install_in_rank, line %d: GD_rank(g)[%d].v + ND_order(%s) [%d] > GD_rank(g)[%d].av + GD_rank(Root)[%d].an [%d]\n",
-	      __LINE__, r, agnameof(n),GD_rank(g)[r].v + ND_order(n), r, r, GD_rank(g)[r].av+GD_rank(Root)[r].an);
+	      __LINE__, r, agnameof(n),RANK(g)[r].v + ND_order(n), r, r, RANK(g)[r].av+RANK(Root)[r].an);
 	return;
     }
 }
@@ -1384,13 +1600,13 @@ void build_ranks(graph_t * g, int pass)
     nodequeue *q;
 
     q = new_queue(GD_n_nodes(g));
-    for (n = GD_nlist(g); n; n = ND_next(n))
+    for (n = NLIST(g); n; n = ND_next(n))
 	MARK(n) = FALSE;
 
 #ifdef DEBUG
     {
 	edge_t *e;
-	for (n = GD_nlist(g); n; n = ND_next(n)) {
+	for (n = NLIST(g); n; n = ND_next(n)) {
 	    for (i = 0; (e = ND_out(n).list[i]); i++)
 		assert(MARK(aghead(e)) == FALSE);
 	    for (i = 0; (e = ND_in(n).list[i]); i++)
@@ -1400,9 +1616,9 @@ void build_ranks(graph_t * g, int pass)
 #endif
 
     for (i = GD_minrank(g); i <= GD_maxrank(g); i++)
-	GD_rank(g)[i].n = 0;
+	RANK(g)[i].n = 0;
 
-    for (n = GD_nlist(g); n; n = ND_next(n)) {
+    for (n = NLIST(g); n; n = ND_next(n)) {
 	otheredges = ((pass == 0) ? ND_in(n).list : ND_out(n).list);
 	if (otheredges[0] != NULL)
 	    continue;
@@ -1422,11 +1638,11 @@ void build_ranks(graph_t * g, int pass)
     if (dequeue(q))
 	agerr(AGERR, "surprise\n");
     for (i = GD_minrank(g); i <= GD_maxrank(g); i++) {
-	GD_rank(Root)[i].valid = FALSE;
-	if (GD_flip(g) && (GD_rank(g)[i].n > 0)) {
+	RANK(Root)[i].valid = FALSE;
+	if (GD_flip(g) && (RANK(g)[i].n > 0)) {
 	    int n, ndiv2;
-	    node_t **vlist = GD_rank(g)[i].v;
-	    n = GD_rank(g)[i].n - 1;
+	    node_t **vlist = RANK(g)[i].v;
+	    n = RANK(g)[i].n - 1;
 	    ndiv2 = n / 2;
 	    for (j = 0; j <= ndiv2; j++)
 		exchange(vlist[j], vlist[n - j]);
@@ -1502,17 +1718,17 @@ static void flat_reorder(graph_t * g)
     if (GD_has_flat_edges(g) == FALSE)
 	return;
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	if (GD_rank(g)[r].n == 0) continue;
-	base_order = ND_order(GD_rank(g)[r].v[0]);
-	for (i = 0; i < GD_rank(g)[r].n; i++)
-	    MARK(GD_rank(g)[r].v[i]) = FALSE;
+	if (RANK(g)[r].n == 0) continue;
+	base_order = ND_order(RANK(g)[r].v[0]);
+	for (i = 0; i < RANK(g)[r].n; i++)
+	    MARK(RANK(g)[r].v[i]) = FALSE;
 	temprank = ALLOC(i + 1, temprank, node_t *);
 	pos = 0;
 
 	/* construct reverse topological sort order in temprank */
-	for (i = 0; i < GD_rank(g)[r].n; i++) {
-	    if (GD_flip(g)) v = GD_rank(g)[r].v[i];
-	    else v = GD_rank(g)[r].v[GD_rank(g)[r].n - i - 1];
+	for (i = 0; i < RANK(g)[r].n; i++) {
+	    if (GD_flip(g)) v = RANK(g)[r].v[i];
+	    else v = RANK(g)[r].v[RANK(g)[r].n - i - 1];
 
 	    local_in_cnt = local_out_cnt = 0;
 	    for (j = 0; j < ND_flat_in(v).size; j++) {
@@ -1546,14 +1762,14 @@ static void flat_reorder(graph_t * g)
 		    right--;
 		}
 	    }
-	    for (i = 0; i < GD_rank(g)[r].n; i++) {
-		v = GD_rank(g)[r].v[i] = temprank[i];
+	    for (i = 0; i < RANK(g)[r].n; i++) {
+		v = RANK(g)[r].v[i] = temprank[i];
 		ND_order(v) = i + base_order;
 	    }
 
 	    /* nonconstraint flat edges must be made LR */
-	    for (i = 0; i < GD_rank(g)[r].n; i++) {
-		v = GD_rank(g)[r].v[i];
+	    for (i = 0; i < RANK(g)[r].n; i++) {
+		v = RANK(g)[r].v[i];
 		if (ND_flat_out(v).list) {
 		    for (j = 0; (e = ND_flat_out(v).list[j]); j++) {
 			if ( ((GD_flip(g) == FALSE) && (ND_order(aghead(e)) < ND_order(agtail(e)))) ||
@@ -1569,7 +1785,7 @@ static void flat_reorder(graph_t * g)
 	    /* postprocess to restore intended order */
 	}
 	/* else do no harm! */
-	GD_rank(Root)[r].valid = FALSE;
+	RANK(Root)[r].valid = FALSE;
     }
     if (temprank)
 	free(temprank);
@@ -1579,10 +1795,10 @@ static void reorder(graph_t * g, int r, int reverse, int hasfixed)
 {
     int changed = 0, nelt;
     boolean muststay, sawclust;
-    node_t **vlist = GD_rank(g)[r].v;
-    node_t **lp, **rp, **ep = vlist + GD_rank(g)[r].n;
+    node_t **vlist = RANK(g)[r].v;
+    node_t **lp, **rp, **ep = vlist + RANK(g)[r].n;
 
-    for (nelt = GD_rank(g)[r].n - 1; nelt >= 0; nelt--) {
+    for (nelt = RANK(g)[r].n - 1; nelt >= 0; nelt--) {
 	lp = vlist;
 	while (lp < ep) {
 	    /* find leftmost node that can be compared */
@@ -1621,9 +1837,9 @@ static void reorder(graph_t * g, int r, int reverse, int hasfixed)
     }
 
     if (changed) {
-	GD_rank(Root)[r].valid = FALSE;
+	RANK(Root)[r].valid = FALSE;
 	if (r > 0)
-	    GD_rank(Root)[r - 1].valid = FALSE;
+	    RANK(Root)[r - 1].valid = FALSE;
     }
 }
 
@@ -1692,46 +1908,56 @@ static int local_cross(elist l, int dir)
     return cross;
 }
 
+/* rcross:
+ * Count the crossings between ranks r and r+1.
+ * The tails on rank r are visited from left to right, and an edge
+ * crosses every edge seen before it whose head is further right.
+ * Count holds the penalties of the edges seen so far as a Fenwick
+ * tree indexed by head order, so each edge costs O(log n) instead of
+ * a scan of the rank (Barth, Juenger and Mutzel).
+ */
 static int rcross(graph_t * g, int r)
 {
-    static int *Count, C;
-    int top, bot, cross, max, i, k;
+    int top, bot, cross, total, n, i, k, sum;
     node_t **rtop, *v;
 
     cross = 0;
-    max = 0;
-    rtop = GD_rank(g)[r].v;
+    total = 0;
+    rtop = RANK(g)[r].v;
+    n = RANK(g)[r + 1].n;
 
-    if (C <= GD_rank(Root)[r + 1].n) {
-	C = GD_rank(Root)[r + 1].n + 1;
+    if (C <= RANK(Root)[r + 1].n) {
+	C = RANK(Root)[r + 1].n + 1;
 	Count = ALLOC(C, Count, int);
     }
 
-    for (i = 0; i < GD_rank(g)[r + 1].n; i++)
+    for (i = 0; i <= n; i++)
 	Count[i] = 0;
 
-    for (top = 0; top < GD_rank(g)[r].n; top++) {
+    for (top = 0; top < RANK(g)[r].n; top++) {
 	register edge_t *e;
-	if (max > 0) {
+	if (total > 0) {
 	    for (i = 0; (e = ND_out(rtop[top]).list[i]); i++) {
-		for (k = ND_order(aghead(e)) + 1; k <= max; k++)
-		    cross += Count[k] * ED_xpenalty(e);
+		/* penalty of the edges with head order <= this head */
+		sum = 0;
+		for (k = ND_order(aghead(e)) + 1; k > 0; k -= k & -k)
+		    sum += Count[k];
+		cross += (total - sum) * ED_xpenalty(e);
 	    }
 	}
 	for (i = 0; (e = ND_out(rtop[top]).list[i]); i++) {
-	    register int inv = ND_order(aghead(e));
-	    if (inv > max)
-		max = inv;
-	    Count[inv] += ED_xpenalty(e);
+	    for (k = ND_order(aghead(e)) + 1; k <= n; k += k & -k)
+		Count[k] += ED_xpenalty(e);
+	    total += ED_xpenalty(e);
 	}
     }
-    for (top = 0; top < GD_rank(g)[r].n; top++) {
-	v = GD_rank(g)[r].v[top];
+    for (top = 0; top < RANK(g)[r].n; top++) {
+	v = RANK(g)[r].v[top];
 	if (ND_has_port(v))
 	    cross += local_cross(ND_out(v), 1);
     }
-    for (bot = 0; bot < GD_rank(g)[r + 1].n; bot++) {
-	v = GD_rank(g)[r + 1].v[bot];
+    for (bot = 0; bot < RANK(g)[r + 1].n; bot++) {
+	v = RANK(g)[r + 1].v[bot];
 	if (ND_has_port(v))
 	    cross += local_cross(ND_in(v), -1);
     }
@@ -1745,12 +1971,12 @@ int ncross(graph_t * g)
     g = Root;
     count = 0;
     for (r = GD_minrank(g); r < GD_maxrank(g); r++) {
-	if (GD_rank(g)[r].valid)
-	    count += GD_rank(g)[r].cache_nc;
+	if (RANK(g)[r].valid)
+	    count += RANK(g)[r].cache_nc;
 	else {
-	    nc = GD_rank(g)[r].cache_nc = rcross(g, r);
+	    nc = RANK(g)[r].cache_nc = rcross(g, r);
 	    count += nc;
-	    GD_rank(g)[r].valid = TRUE;
+	    RANK(g)[r].valid = TRUE;
 	}
     }
     return count;
@@ -1811,8 +2037,8 @@ static boolean medians(graph_t * g, int r0, int r1)
     boolean hasfixed = FALSE;
 
     list = TI_list;
-    v = GD_rank(g)[r0].v;
-    for (i = 0; i < GD_rank(g)[r0].n; i++) {
+    v = RANK(g)[r0].v;
+    for (i = 0; i < RANK(g)[r0].n; i++) {
 	n = v[i];
 	j = 0;
 	if (r1 > r0)
@@ -1853,7 +2079,7 @@ static boolean medians(graph_t * g, int r0, int r1)
 	    }
 	}
     }
-    for (i = 0; i < GD_rank(g)[r0].n; i++) {
+    for (i = 0; i < RANK(g)[r0].n; i++) {
 	n = v[i];
 	if ((ND_out(n).size == 0) && (ND_in(n).size == 0))
 	    hasfixed |= flat_mval(n);
@@ -382,19 +382,41 @@ minmax_edges2(graph_t * g, point slen)
     return (e != 0);
 }
 
-/* Run the network simplex algorithm on each component. */
+/* Run the network simplex algorithm on each component.
+ * The components are disjoint, so each is ranked with its own
+ * solver context, in parallel when OpenMP is available.
+ * All attribute lookups are done up front, as cgraph is not
+ * safe for concurrent access.
+ */
 void rank1(graph_t * g)
 {
     int maxiter = INT_MAX;
-    int c;
+    int c, ncomp, balance, search_size;
+    ns_pivot_t pivot;
     char *s;
 
     if ((s = agget(g, "nslimit1")))
 	maxiter = atof(s) * agnnodes(g);
-    for (c = 0; c < GD_comp(g).size; c++) {
-	GD_nlist(g) = GD_comp(g).list[c];
-	rank(g, (GD_n_cluster(g) == 0 ? 1 : 0), maxiter);	/* TB balance */
+    if ((s = agget(g, "searchsize")))
+	search_size = atoi(s);
+    else
+	search_size = -1;
+    pivot = ns_pivot(g);
+    balance = (GD_n_cluster(g) == 0 ? 1 : 0);	/* TB balance */
+    ncomp = GD_comp(g).size;
+
+#pragma omp parallel if (ncomp > 1) private(c)
+    {
+	ns_context_t *ctx = ns_context_new();
+
+	ns_context_set_pivot(ctx, pivot);
+#pragma omp for schedule(dynamic)
+	for (c = 0; c < ncomp; c++)
+	    ns_rank(ctx, g, GD_comp(g).list[c], balance, maxiter, search_size);
+	ns_context_free(ctx);
     }
+    if (ncomp > 0)
+	GD_nlist(g) = GD_comp(g).list[ncomp - 1];
 }
 
 /* 
@@ -666,8 +688,6 @@ collapse_leaves(graph_t * g)
  */
 #define ND_comp(n)  ND_hops(n)   
 
-extern int rank2(Agraph_t *, int, int, int);
-
 static void set_parent(graph_t* g, graph_t* p) 
 {
     GD_parent(g) = p;
@@ -1072,7 +1092,7 @@ static void setMinMax (graph_t* g, int doRoot)
  * Set rank bounds in graph and clusters
  * Free added data structures.
  *
- * rank2 is called with balance=1, which ensures that minrank=0
+ * ns_rank is called with balance=1, which ensures that minrank=0
  */
 static void readout_levels(graph_t * g, graph_t * Xg, int ncc)
 {
@@ -1198,6 +1218,7 @@ void dot2_rank(graph_t * g, aspect_t* asp)
     int ncc, maxiter = INT_MAX;
     char *s;
     graph_t *Xg;
+    ns_context_t *C;
 
     Last_node = NULL;
     Xg = agopen("level assignment constraints", Agstrictdirected, 0);
@@ -1228,7 +1249,11 @@ void dot2_rank(graph_t * g, aspect_t* asp)
 	ssize = atoi(s);
     else
 	ssize = -1;
-    rank2(Xg, 1, maxiter, ssize);
+    /* the leaving edge strategy is set on the user's graph, not on Xg */
+    C = ns_context_new();
+    ns_context_set_pivot(C, ns_pivot(g));
+    ns_rank(C, Xg, GD_nlist(Xg), 1, maxiter, ssize);
+    ns_context_free(C);
 /* fastgr(Xg); */
     readout_levels(g, Xg, ncc);
 #ifdef DEBUG
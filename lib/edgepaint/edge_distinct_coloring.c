@@ -15,146 +15,275 @@
 #include "intersection.h"
 #include "QuadTree.h"
 
-static int splines_intersect(int dim, int u1, int v1, int u2, int v2, 
-			     real cos_critical, int check_edges_with_same_endpoint, 
-			     real *x, char *xsplines1, char *xsplines2){
-  /* u1, v2 an u2, v2: the node index of the two edn points of two edges.
-     cos_critical: cos of critical angle
-     check_edges_with_same_endpoint: whether need to treat two splines from
-     .     the same end point specially in ignoring splines that exit/enter the same end pont at around 180
-     x: the coordinates of nodes
-     xsplines1,xsplines2: the first and second splines corresponding to two edges
+/* an edge drawn as a polyline, with a bounding box that is enlarged so
+   that edges which intersection_angle may find crossing have overlapping boxes */
+typedef struct {
+  int n;/* number of points */
+  real *x;/* x[2*i], x[2*i+1]: point i */
+  real margin;/* INTERSECTION_CLOSE times the longest segment */
+  real bb[4];/* xmin, ymin, xmax, ymax, enlarged by margin */
+} edge_poly;
 
-  */
-  int itmp;
-  int len1 = 100, len2 = 100;
-  real *x1, *x2;
-  int ns1 = 0, ns2 = 0;
-  int i, j, iter1 = 0, iter2 = 0;
-  real cos_a, tmp[2];
-  int endp1 = 0, endp2 = 0;
-
-  tmp[0] = tmp[1] = 0;
-  x1 = MALLOC(sizeof(real)*len1);
-  x2 = MALLOC(sizeof(real)*len2);
-
-  assert(dim <= 3);
-  /* if two end points are the same, make sure they are the first in each edge */
-  if (u1 == v2){/* switch u2 and v2 */
-    itmp = u2; u2 = v2; v2 = itmp;
-  } else if (v1 == u2){/* switch u1 and v1 */
-    itmp = u1; u1 = v1; v1 = itmp;
-  } else if (v1 == v2){/* switch both */
-    itmp = u2; u2 = v2; v2 = itmp;
-    itmp = u1; u1 = v1; v1 = itmp;
-  }
-
-  /* origonally I though the two end points has to be included. But now I think it does not need to since
-     the splie might start from the border of the label box
-  MEMCPY(x1, &(x[dim*u1]), sizeof(real)*dim);
-  MEMCPY(x2, &(x[dim*u2]), sizeof(real)*dim);
-  ns1++; ns2++;
-  */
-
-  /* splines could be a list of 
+static int spline_points(int dim, char *xsplines, real **xx){
+  /* parse the points of a spline into *xx, returning the number of points.
+     splines could be a list of 
      1. 3n points
      2. of the form "e,x,y" followed by 3n points, where x,y is really padded to the end of the 3n points
      3. of the form "s,x,y" followed by 3n points, where x,y is padded to the start of the 3n points
   */
-  if (xsplines1){
-    if(strstr(xsplines1, "e,")){
-      endp1 = 1;
-      xsplines1 = strstr(xsplines1, "e,") + 2;
-    } else if (strstr(xsplines2, "s,")){
-      xsplines1 = strstr(xsplines1, "s,") + 2;
+  int len = 100, ns = 0, iter = 0, endp = 0;
+  real *x, tmp[2];
+
+  tmp[0] = tmp[1] = 0;
+  x = MALLOC(sizeof(real)*((size_t) len));
+  if (xsplines){
+    if(strstr(xsplines, "e,")){
+      endp = 1;
+      xsplines = strstr(xsplines, "e,") + 2;
+    } else if (strstr(xsplines, "s,")){
+      xsplines = strstr(xsplines, "s,") + 2;
     }
   }
-  while (xsplines1 && sscanf(xsplines1,"%lf,%lf", &(x1[ns1*dim]), &x1[ns1*dim + 1]) == 2){
-    if (endp1 && iter1 == 0){
-      tmp[0] = x1[ns1*dim]; tmp[1] = x1[ns1*dim + 1];
+  while (xsplines && sscanf(xsplines,"%lf,%lf", &(x[ns*dim]), &x[ns*dim + 1]) == 2){
+    if (endp && iter == 0){
+      tmp[0] = x[ns*dim]; tmp[1] = x[ns*dim + 1];
     } else {
-      ns1++;
+      ns++;
     }
-    iter1++;
-    xsplines1 = strstr(xsplines1, " ");
-    if (!xsplines1) break;
-    xsplines1++;
-    if (ns1*dim >= len1){
-      len1 = ns1*dim + (int)MAX(10, 0.2*ns1*dim);
-      x1 = REALLOC(x1, sizeof(real)*len1);
+    iter++;
+    xsplines = strstr(xsplines, " ");
+    if (!xsplines) break;
+    xsplines++;
+    if (ns*dim >= len){
+      len = ns*dim + (int)MAX(10, 0.2*ns*dim);
+      x = REALLOC(x, sizeof(real)*((size_t) len));
     }
   }
-  if (endp1){/* pad the end point at the last position */
-    ns1++;
-    if (ns1*dim >= len1){
-      len1 = ns1*dim + (int)MAX(10, 0.2*ns1*dim);
-      x1 = REALLOC(x1, sizeof(real)*len1);
+  if (endp){/* pad the end point at the last position */
+    ns++;
+    if (ns*dim >= len){
+      len = ns*dim + (int)MAX(10, 0.2*ns*dim);
+      x = REALLOC(x, sizeof(real)*((size_t) len));
     }
-    x1[(ns1-1)*dim] = tmp[0];  x1[(ns1-1)*dim + 1] = tmp[1]; 
+    x[(ns-1)*dim] = tmp[0];  x[(ns-1)*dim + 1] = tmp[1]; 
   }
+  *xx = x;
+  return ns;
+}
 
+static void edge_poly_init(int dim, edge_poly *e){
+  /* set the margin and enlarged bounding box of e */
+  int i;
+  real len, *x = e->x;
 
-  /* splines could be a list of 
-     1. 3n points
-     2. of the form "e,x,y" followed by 3n points, where x,y is really padded to the end of the 3n points
-     3. of the form "s,x,y" followed by 3n points, where x,y is padded to the start of the 3n points
+  e->margin = 0;
+  for (i = 0; i < e->n - 1; i++){
+    len = distance(x, dim, i, i + 1);
+    e->margin = MAX(e->margin, INTERSECTION_CLOSE*len);
+  }
+  if (e->n == 0){
+    e->bb[0] = e->bb[1] = 1;
+    e->bb[2] = e->bb[3] = -1;/* empty */
+    return;
+  }
+  e->bb[0] = e->bb[2] = x[0];
+  e->bb[1] = e->bb[3] = x[1];
+  for (i = 1; i < e->n; i++){
+    e->bb[0] = MIN(e->bb[0], x[i*dim]);
+    e->bb[1] = MIN(e->bb[1], x[i*dim+1]);
+    e->bb[2] = MAX(e->bb[2], x[i*dim]);
+    e->bb[3] = MAX(e->bb[3], x[i*dim+1]);
+  }
+  e->bb[0] -= e->margin; e->bb[1] -= e->margin;
+  e->bb[2] += e->margin; e->bb[3] += e->margin;
+}
+
+#define BOXES_OVERLAP(a, b) ((a)[0] <= (b)[2] && (b)[0] <= (a)[2] && (a)[1] <= (b)[3] && (b)[1] <= (a)[3])
+
+static int splines_intersect(int dim, edge_poly *e1, edge_poly *e2, real cos_critical, int check_edges_with_same_endpoint){
+  /* whether some pair of segments of the two splines cross at an angle with cos above cos_critical.
+     Pairs of segments further apart than INTERSECTION_CLOSE times the longer one cannot cross, and are skipped.
   */
-  if (xsplines2){
-    if(strstr(xsplines2, "e,")){
-      endp2 = 1;
-      xsplines2 = strstr(xsplines2, "e,") + 2;
-    } else if (strstr(xsplines2, "s,")){
-      xsplines2 = strstr(xsplines2, "s,") + 2;
+  int i, j;
+  real cos_a, len1, len2, m, *x1 = e1->x, *x2 = e2->x;
+
+  for (i = 0; i < e1->n - 1; i++){
+    len1 = distance(x1, dim, i, i + 1);
+    for (j = 0; j < e2->n - 1; j++){
+      len2 = distance(x2, dim, j, j + 1);
+      m = INTERSECTION_CLOSE*MAX(len1, len2);
+      if (MIN(x1[dim*i], x1[dim*(i+1)]) - m > MAX(x2[dim*j], x2[dim*(j+1)])
+	  || MIN(x2[dim*j], x2[dim*(j+1)]) - m > MAX(x1[dim*i], x1[dim*(i+1)])
+	  || MIN(x1[dim*i+1], x1[dim*(i+1)+1]) - m > MAX(x2[dim*j+1], x2[dim*(j+1)+1])
+	  || MIN(x2[dim*j+1], x2[dim*(j+1)+1]) - m > MAX(x1[dim*i+1], x1[dim*(i+1)+1])) continue;
+      cos_a = intersection_angle(&(x1[dim*i]), &(x1[dim*(i + 1)]), &(x2[dim*j]), &(x2[dim*(j+1)]));
+      if (!check_edges_with_same_endpoint && cos_a >= -1) cos_a = ABS(cos_a);
+      if (cos_a > cos_critical) return 1;
     }
   }
-  while (xsplines2 && sscanf(xsplines2,"%lf,%lf", &(x2[ns2*dim]), &x2[ns2*dim + 1]) == 2){
-    if (endp2 && iter2 == 0){
-      tmp[0] = x2[ns2*dim]; tmp[1] = x2[ns2*dim + 1];
-    } else {
-      ns2++;
-    }
-    iter2++;
-    xsplines2 = strstr(xsplines2, " ");
-    if (!xsplines2) break;
-    xsplines2++;
-    if (ns2*dim >= len2){
-      len2 = ns2*dim + (int)MAX(10, 0.2*ns2*dim);
-      x2 = REALLOC(x2, sizeof(real)*len2);
+  return 0;
+}
+
+/* edges are handled in blocks of this size, each giving its conflicts in order */
+#define CONFLICT_BLOCK 256
+
+typedef struct {
+  int n, len;
+  int *irn, *jcn;
+  real *val;
+} conflict_list;
+
+static SparseMatrix edge_conflict_graph(int dim, int ne, edge_poly *edges, int splines, real cos_critical, int check_edges_with_same_endpoint){
+  /* the conflict graph of the edges: edges i and j are adjacent if they cross at a small angle. 
+     The broad phase puts the enlarged bounding box of each edge in the cells of a uniform grid that it
+     covers; only pairs of edges that share a cell and whose boxes overlap go to the exact test.
+     Blocks of edges are tested in parallel, and their conflicts added in order, so the graph is 
+     the same as testing all pairs in turn.
+  */
+  SparseMatrix B;
+  real bb[4], h, avg = 0;
+  int i, k, nx = 1, ny = 1, ncells, nblocks, ngrid = 0, ncand = 0;
+  int *cell_start, *cell_edges;
+  conflict_list *blocks;
+  clock_t start = clock();
+
+  /* the grid: cells about the size of an average edge, and not many more than edges */
+  bb[0] = bb[1] = 0;
+  bb[2] = bb[3] = 0;
+  for (i = 0; i < ne; i++){
+    if (edges[i].n == 0) continue;
+    if (ngrid == 0) MEMCPY(bb, edges[i].bb, sizeof(real)*4);
+    for (k = 0; k < 2; k++){
+      bb[k] = MIN(bb[k], edges[i].bb[k]);
+      bb[k+2] = MAX(bb[k+2], edges[i].bb[k+2]);
     }
+    avg += MAX(edges[i].bb[2] - edges[i].bb[0], edges[i].bb[3] - edges[i].bb[1]);
+    ngrid++;
   }
-  if (endp2){/* pad the end point at the last position */
-    ns2++;
-    if (ns2*dim >= len2){
-      len2 = ns2*dim + (int)MAX(10, 0.2*ns2*dim);
-      x2 = REALLOC(x2, sizeof(real)*len2);
+  if (ngrid > 0) {
+    avg /= ngrid;
+    h = MAX(avg, sqrt((bb[2] - bb[0])*(bb[3] - bb[1])/(4.*ngrid)));
+    if (h > 0){
+      nx = MIN((int) ((bb[2] - bb[0])/h) + 1, 4*ngrid);
+      ny = MIN((int) ((bb[3] - bb[1])/h) + 1, 4*ngrid/nx + 1);
     }
-    x2[(ns2-1)*dim] = tmp[0];  x2[(ns2-1)*dim + 1] = tmp[1]; 
   }
+  ncells = nx*ny;
 
-  /* origonally I though the two end points has to be included. But now I think it does not need to since
-     the splie might start from the border of the label box
-  MEMCPY(&(x2[dim*ns2]), &(x[dim*v2]), sizeof(real)*dim);
-  ns2++;
-  MEMCPY(&(x1[dim*ns1]), &(x[dim*v1]), sizeof(real)*dim);
-  ns1++;
-  */
+#define GRID_RANGE(e, x0, y0, x1, y1) {\
+    x0 = (int) ((nx*((e)->bb[0] - bb[0]))/(bb[2] - bb[0] + MACHINEACC)); x0 = MAX(0, MIN(nx - 1, x0)); \
+    x1 = (int) ((nx*((e)->bb[2] - bb[0]))/(bb[2] - bb[0] + MACHINEACC)); x1 = MAX(0, MIN(nx - 1, x1)); \
+    y0 = (int) ((ny*((e)->bb[1] - bb[1]))/(bb[3] - bb[1] + MACHINEACC)); y0 = MAX(0, MIN(ny - 1, y0)); \
+    y1 = (int) ((ny*((e)->bb[3] - bb[1]))/(bb[3] - bb[1] + MACHINEACC)); y1 = MAX(0, MIN(ny - 1, y1)); \
+  }
 
-for (i = 0; i < ns1 - 1; i++){
-    for (j = 0; j < ns2 - 1; j++){
-      cos_a = intersection_angle(&(x1[dim*i]), &(x1[dim*(i + 1)]), &(x2[dim*j]), &(x2[dim*(j+1)]));
-      if (!check_edges_with_same_endpoint && cos_a >= -1) cos_a = ABS(cos_a);
-      if (cos_a > cos_critical) {
-	return 1;
-      }
+  /* edges in each cell, in increasing order */
+  cell_start = MALLOC(sizeof(int)*((size_t) ncells + 1));
+  for (k = 0; k <= ncells; k++) cell_start[k] = 0;
+  for (i = 0; i < ne; i++){
+    int x0, y0, x1, y1, ix, iy;
+    if (edges[i].n == 0) continue;
+    GRID_RANGE(&edges[i], x0, y0, x1, y1);
+    for (ix = x0; ix <= x1; ix++)
+      for (iy = y0; iy <= y1; iy++) cell_start[ix*ny + iy + 1]++;
+  }
+  for (k = 0; k < ncells; k++) cell_start[k+1] += cell_start[k];
+  cell_edges = MALLOC(sizeof(int)*((size_t) MAX(1, cell_start[ncells])));
+  for (i = 0; i < ne; i++){
+    int x0, y0, x1, y1, ix, iy;
+    if (edges[i].n == 0) continue;
+    GRID_RANGE(&edges[i], x0, y0, x1, y1);
+    for (ix = x0; ix <= x1; ix++)
+      for (iy = y0; iy <= y1; iy++) cell_edges[cell_start[ix*ny + iy]++] = i;
+  }
+  for (k = ncells; k > 0; k--) cell_start[k] = cell_start[k-1];
+  cell_start[0] = 0;
+
+  if (Verbose)
+    fprintf(stderr, "conflict grid %d x %d, %d entries: cpu %.3f\n", nx, ny, cell_start[ncells],
+	    ((real) (clock() - start))/CLOCKS_PER_SEC);
+  start = clock();
+
+  nblocks = (ne + CONFLICT_BLOCK - 1)/CONFLICT_BLOCK;
+  blocks = MALLOC(sizeof(conflict_list)*((size_t) MAX(1, nblocks)));
+  for (k = 0; k < nblocks; k++){
+    blocks[k].n = blocks[k].len = 0;
+    blocks[k].irn = blocks[k].jcn = NULL;
+    blocks[k].val = NULL;
+  }
+#pragma omp parallel reduction(+:ncand)
+  {
+    int b, j, c, kk, nc, x0, y0, x1, y1, ix, iy;
+    int *stamp = MALLOC(sizeof(int)*((size_t) MAX(1, ne)));
+    int *cand = MALLOC(sizeof(int)*((size_t) MAX(1, ne)));
+    real cos_a;
+    conflict_list *cl;
 
+    for (j = 0; j < ne; j++) stamp[j] = -1;
+#pragma omp for schedule(dynamic)
+    for (b = 0; b < nblocks; b++){
+      int ii;
+      cl = &blocks[b];
+      for (ii = b*CONFLICT_BLOCK; ii < MIN(ne, (b+1)*CONFLICT_BLOCK); ii++){
+	if (edges[ii].n == 0) continue;
+	nc = 0;
+	GRID_RANGE(&edges[ii], x0, y0, x1, y1);
+	for (ix = x0; ix <= x1; ix++){
+	  for (iy = y0; iy <= y1; iy++){
+	    c = ix*ny + iy;
+	    for (kk = cell_start[c]; kk < cell_start[c+1]; kk++){
+	      j = cell_edges[kk];
+	      if (j <= ii || stamp[j] == ii) continue;
+	      stamp[j] = ii;
+	      if (BOXES_OVERLAP(edges[ii].bb, edges[j].bb)) cand[nc++] = j;
+	    }
+	  }
+	}
+	ncand += nc;
+	vector_sort_int(nc, cand, TRUE);
+	for (kk = 0; kk < nc; kk++){
+	  j = cand[kk];
+	  if (splines){
+	    /* for splines we exit conflict check as soon as we find an conflict, so the angle may not be representitive, hence set to constant */
+	    if (!splines_intersect(dim, &edges[ii], &edges[j], cos_critical, check_edges_with_same_endpoint)) continue;
+	    cos_a = 1.;
+	  } else {
+	    cos_a = intersection_angle(edges[ii].x, &(edges[ii].x[dim]), edges[j].x, &(edges[j].x[dim]));
+	    if (!check_edges_with_same_endpoint && cos_a >= -1) cos_a = ABS(cos_a);
+	    if (cos_a <= cos_critical) continue;
+	  }
+	  if (cl->n >= cl->len){
+	    cl->len = cl->n + MAX(10, cl->n/2);
+	    cl->irn = REALLOC(cl->irn, sizeof(int)*((size_t) cl->len));
+	    cl->jcn = REALLOC(cl->jcn, sizeof(int)*((size_t) cl->len));
+	    cl->val = REALLOC(cl->val, sizeof(real)*((size_t) cl->len));
+	  }
+	  cl->irn[cl->n] = ii;
+	  cl->jcn[cl->n] = j;
+	  cl->val[cl->n++] = cos_a;
+	}
+      }
     }
+    FREE(stamp);
+    FREE(cand);
   }
 
-  FREE(x1);
-  FREE(x2);
-  return 0;
-}
+  B = SparseMatrix_new(ne, ne, 1, MATRIX_TYPE_REAL, FORMAT_COORD);
+  for (k = 0; k < nblocks; k++){
+    if (blocks[k].n > 0) B = SparseMatrix_coordinate_form_add_entries(B, blocks[k].n, blocks[k].irn, blocks[k].jcn, blocks[k].val);
+    FREE(blocks[k].irn);
+    FREE(blocks[k].jcn);
+    FREE(blocks[k].val);
+  }
+  if (Verbose)
+    fprintf(stderr, "%d candidate pairs of %.0f, %d conflicts: cpu %.3f\n", ncand, ((real) ne)*(ne - 1)/2, B->nz,
+	    ((real) (clock() - start))/CLOCKS_PER_SEC);
 
+  FREE(blocks);
+  FREE(cell_start);
+  FREE(cell_edges);
+  return B;
+}
 
 Agraph_t* edge_distinct_coloring(char *color_scheme, char *lightness, Agraph_t* g, real angle, real accuracy, int check_edges_with_same_endpoint, int seed){
   /* color the edges of a graph so that conflicting edges are as dinstrinct in color as possibl.
@@ -173,12 +302,14 @@ Agraph_t* edge_distinct_coloring(char *color_scheme, char *lightness, Agraph_t*
   int dim = 2;
   SparseMatrix A, B, C;
   int *irn, *jcn, nz, nz2 = 0;
-  real cos_critical = cos(angle/180*3.14159), cos_a;
-  int u1, v1, u2, v2, i, j;
+  real cos_critical = cos(angle/180*3.14159);
+  int i;
   real *colors = NULL, color_diff, color_diff_sum;
   int flag, ne;
   char **xsplines = NULL;
   int cdim;
+  int splines = FALSE;
+  edge_poly *edges;
 
   A = SparseMatrix_import_dot(g, dim, NULL, &x, NULL, NULL, FORMAT_COORD, NULL);
   if (!x){
@@ -201,64 +332,38 @@ Agraph_t* edge_distinct_coloring(char *color_scheme, char *lightness, Agraph_t*
   if (Verbose)
     fprintf(stderr,"cos = %f, nz2 = %d\n", cos_critical, nz2);
   /* now find edge collision */
-  nz = 0;
-  B = SparseMatrix_new(nz2, nz2, 1, MATRIX_TYPE_REAL, FORMAT_COORD);
-
+  edges = MALLOC(sizeof(edge_poly)*((size_t) MAX(1, nz2)));
   if (Import_dot_splines(g, &ne, &xsplines)){
-#ifdef TIME
-    clock_t start = clock();
-#endif
     assert(ne == nz2);
-    cos_a = 1.;/* for splines we exit conflict check as soon as we find an conflict, so the anle may not be representitive, hence set to constant */
+    splines = TRUE;
     for (i = 0; i < nz2; i++){
-      u1 = irn[i]; v1 = jcn[i];
-      for (j = i+1; j < nz2; j++){
-	u2 = irn[j]; v2 = jcn[j];
-	if (splines_intersect(dim, u1, v1, u2, v2, cos_critical, check_edges_with_same_endpoint, x, xsplines[i], xsplines[j])){
-	  B = SparseMatrix_coordinate_form_add_entries(B, 1, &i, &j, &cos_a);
-	}
-      }
+      edges[i].n = spline_points(dim, xsplines[i], &(edges[i].x));
+      edge_poly_init(dim, &edges[i]);
     }
-#ifdef TIME
-    fprintf(stderr, "cpu for dual graph =%10.3f", ((real) (clock() - start))/CLOCKS_PER_SEC);
-#endif
-    
   } else {
     /* no splines, justsimple edges */
-#ifdef TIME
-    clock_t start = clock();
-#endif
-    
-    
     for (i = 0; i < nz2; i++){
-      u1 = irn[i]; v1 = jcn[i];
-      for (j = i+1; j < nz2; j++){
-	u2 = irn[j]; v2 = jcn[j];
-	cos_a = intersection_angle(&(x[dim*u1]), &(x[dim*v1]), &(x[dim*u2]), &(x[dim*v2]));
-	if (!check_edges_with_same_endpoint && cos_a >= -1) cos_a = ABS(cos_a);
-	if (cos_a > cos_critical) {
-	  B = SparseMatrix_coordinate_form_add_entries(B, 1, &i, &j, &cos_a);
-	}
-      }
+      edges[i].n = 2;
+      edges[i].x = MALLOC(sizeof(real)*2*((size_t) dim));
+      MEMCPY(edges[i].x, &(x[dim*irn[i]]), sizeof(real)*((size_t) dim));
+      MEMCPY(&(edges[i].x[dim]), &(x[dim*jcn[i]]), sizeof(real)*((size_t) dim));
+      edge_poly_init(dim, &edges[i]);
     }
-#ifdef TIME
-    fprintf(stderr, "cpu for dual graph (splines) =%10.3f\n", ((real) (clock() - start))/CLOCKS_PER_SEC);
-#endif
   } 
+  B = edge_conflict_graph(dim, nz2, edges, splines, cos_critical, check_edges_with_same_endpoint);
+  for (i = 0; i < nz2; i++) FREE(edges[i].x);
+  FREE(edges);
   C = SparseMatrix_from_coordinate_format(B);
   if (B != C) SparseMatrix_delete(B);
   
   {
-#ifdef TIME
     clock_t start = clock();
-#endif
     int weightedQ = FALSE;
     int iter_max = 100;
     node_distinct_coloring(color_scheme, lightness, weightedQ, C, accuracy, iter_max, seed, &cdim, &colors, &color_diff, &color_diff_sum, &flag);
     if (flag) goto RETURN;
-#ifdef TIME
-    fprintf(stderr, "cpu for color assignmment =%10.3f\n", ((real) (clock() - start))/CLOCKS_PER_SEC);
-#endif
+    if (Verbose)
+      fprintf(stderr, "color assignment: cpu %.3f\n", ((real) (clock() - start))/CLOCKS_PER_SEC);
   }
 
   /* for printing dual*/
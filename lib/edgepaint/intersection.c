@@ -8,6 +8,7 @@
  * Contributors: See CVS logs. Details at http://www.graphviz.org/
  *************************************************************************/
 #include "general.h"
+#include "intersection.h"
 
 static real cross(real *u, real *v){
   return u[0]*v[1] - u[1]*v[0];
@@ -126,7 +127,7 @@ real intersection_angle(real *p1, real *p2, real *q1, real *q2){
   real rnorm = 0, snorm = 0, b, t, u;
   // real epsilon = sqrt(MACHINEACC), close = 0.01;
   //this may be better. Apply to ngk10_4 and look at double edge between 28 and 43.  real epsilon = sin(10/180.), close = 0.1;
-  real epsilon = sin(1/180.), close = 0.01;
+  real epsilon = sin(1/180.), close = INTERSECTION_CLOSE;
   int line_dist_close;
   int i;
   real res;
@@ -11,6 +11,9 @@
 #ifndef INTERSECTION_H
 #define INTERSECTION_H
 
+/* segments closer than this fraction of the longer one are treated as crossing */
+#define INTERSECTION_CLOSE 0.01
+
 real intersection_angle(real *p1, real *p2, real *q1, real *q2);
 
 #endif
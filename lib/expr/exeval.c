@@ -922,6 +922,728 @@ xPrint(Expr_t * ex, Exnode_t * expr, Extype_t v, Exnode_t * tmp)
 	tmp->type = STRING;
 }
 
+/*
+ * threaded evaluation
+ *
+ * The first time a node is evaluated, thread() selects a direct
+ * evaluator for it if its operator has a fixed meaning on the
+ * operand types: constants, scalar variables, assignments to them,
+ * the logical operators, the integer, floating and string operators
+ * that do not go through the discipline, and the if, for, while and
+ * sequence statements.  These evaluators call the evaluators of their
+ * operands directly, so loops and arithmetic run as a chain of small
+ * typed functions instead of recursing through the general switch in
+ * eval().  Everything else is left to eval().
+ */
+
+#define EVAL(ex,x,env)	((x)->fast ? (*(x)->fast)(ex, x, env) : eval(ex, x, env))
+#define EXEC(ex,x,env)	((x) && (x)->fast && !(ex)->loopcount ? (*(x)->fast)(ex, x, env) : eval(ex, x, env))
+#define SCALAR(x)	((x)->op == DYNAMIC && !(x)->data.variable.index)
+#define VALUE(x)	((x)->data.variable.symbol->value->data.constant.value)
+
+static Extype_t
+fast_constant(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	(void)ex;
+	(void)env;
+	return expr->data.constant.value;
+}
+
+static Extype_t
+fast_scalar(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	(void)ex;
+	(void)env;
+	return VALUE(expr);
+}
+
+static Extype_t
+fast_assign(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+
+	v = EVAL(ex, expr->data.operand.right, env);
+	VALUE(expr->data.operand.left) = v;
+	return v;
+}
+
+static Extype_t
+fast_iassign(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+	Extype_t	r;
+
+	r = EVAL(ex, expr->data.operand.right, env);
+	v = VALUE(expr->data.operand.left);
+	switch (expr->subop)
+	{
+	case '+':
+		v.integer += r.integer;
+		break;
+	case '-':
+		v.integer -= r.integer;
+		break;
+	case '*':
+		v.integer *= r.integer;
+		break;
+	case '/':
+		if (r.integer == 0)
+			exerror("integer divide by 0");
+		else
+			v.integer /= r.integer;
+		break;
+	case '%':
+		if (r.integer == 0)
+			exerror("integer 0 modulus");
+		else
+			v.integer %= r.integer;
+		break;
+	}
+	VALUE(expr->data.operand.left) = v;
+	return v;
+}
+
+static Extype_t
+fast_fassign(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+	Extype_t	r;
+
+	r = EVAL(ex, expr->data.operand.right, env);
+	v = VALUE(expr->data.operand.left);
+	switch (expr->subop)
+	{
+	case '+':
+		v.floating += r.floating;
+		break;
+	case '-':
+		v.floating -= r.floating;
+		break;
+	case '*':
+		v.floating *= r.floating;
+		break;
+	case '/':
+		if (r.floating == 0.0)
+			exerror("floating divide by 0");
+		else
+			v.floating /= r.floating;
+		break;
+	case '%':
+		if ((r.integer = r.floating) == 0)
+			exerror("floating 0 modulus");
+		else
+			v.floating = ((Sflong_t)v.floating) % r.integer;
+		break;
+	}
+	VALUE(expr->data.operand.left) = v;
+	return v;
+}
+
+static Extype_t
+fast_iinc(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+	Extype_t	r;
+
+	(void)ex;
+	(void)env;
+	r = v = VALUE(expr->data.operand.left);
+	v.integer += expr->op == INC ? 1 : -1;
+	VALUE(expr->data.operand.left) = v;
+	return expr->subop == PRE ? v : r;
+}
+
+static Extype_t
+fast_finc(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+	Extype_t	r;
+
+	(void)ex;
+	(void)env;
+	r = v = VALUE(expr->data.operand.left);
+	v.floating += expr->op == INC ? 1 : -1;
+	VALUE(expr->data.operand.left) = v;
+	return expr->subop == PRE ? v : r;
+}
+
+static Extype_t
+fast_and(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+
+	v = EVAL(ex, expr->data.operand.left, env);
+	return v.integer ? EVAL(ex, expr->data.operand.right, env) : v;
+}
+
+static Extype_t
+fast_or(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+
+	v = EVAL(ex, expr->data.operand.left, env);
+	return v.integer ? v : EVAL(ex, expr->data.operand.right, env);
+}
+
+static Extype_t
+fast_cond(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+	Exnode_t*	x = expr->data.operand.right;
+
+	v = EVAL(ex, expr->data.operand.left, env);
+	return v.integer ? EVAL(ex, x->data.operand.left, env) : EVAL(ex, x->data.operand.right, env);
+}
+
+/*
+ * statements are run with EXEC(), which leaves null statements and
+ * break, continue and return unwinding to eval()
+ */
+
+static Extype_t
+fast_if(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+	Exnode_t*	x = expr->data.operand.right;
+
+	v = EVAL(ex, expr->data.operand.left, env);
+	if (v.integer)
+		EXEC(ex, x->data.operand.left, env);
+	else
+		EXEC(ex, x->data.operand.right, env);
+	v.integer = 1;
+	return v;
+}
+
+static Extype_t
+fast_loop(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+	Exnode_t*	x = expr->data.operand.left;
+
+	expr = expr->data.operand.right;
+	for (;;)
+	{
+		v = EVAL(ex, x, env);
+		if (!v.integer)
+		{
+			v.integer = 1;
+			return v;
+		}
+		if (expr->data.operand.right)
+		{
+			EXEC(ex, expr->data.operand.right, env);
+			if (ex->loopcount > 0 && (--ex->loopcount > 0 || ex->loopop != CONTINUE))
+			{
+				v.integer = 0;
+				return v;
+			}
+		}
+		if (expr->data.operand.left)
+			EXEC(ex, expr->data.operand.left, env);
+	}
+}
+
+static Extype_t
+fast_seq(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+
+	v = EXEC(ex, expr->data.operand.left, env);
+	while ((expr = expr->data.operand.right) && (expr->op == ';' || expr->op == ','))
+	{
+		v = EXEC(ex, expr->data.operand.left, env);
+		if (ex->loopcount)
+			return v;
+	}
+	return expr ? EXEC(ex, expr, env) : v;
+}
+
+/*
+ * binary operator name on operands of member t giving member r
+ */
+
+#define FAST_BINARY(name,t,r,op) \
+static Extype_t \
+name(Expr_t* ex, Exnode_t* expr, void* env) \
+{ \
+	Extype_t	v; \
+	Extype_t	w; \
+	v = EVAL(ex, expr->data.operand.left, env); \
+	w = EVAL(ex, expr->data.operand.right, env); \
+	v.r = v.t op w.t; \
+	return v; \
+}
+
+FAST_BINARY(fast_iadd, integer, integer, +)
+FAST_BINARY(fast_isub, integer, integer, -)
+FAST_BINARY(fast_impy, integer, integer, *)
+FAST_BINARY(fast_iand, integer, integer, &)
+FAST_BINARY(fast_iior, integer, integer, |)
+FAST_BINARY(fast_ixor, integer, integer, ^)
+FAST_BINARY(fast_ilt, integer, integer, <)
+FAST_BINARY(fast_ile, integer, integer, <=)
+FAST_BINARY(fast_ieq, integer, integer, ==)
+FAST_BINARY(fast_ine, integer, integer, !=)
+FAST_BINARY(fast_ige, integer, integer, >=)
+FAST_BINARY(fast_igt, integer, integer, >)
+FAST_BINARY(fast_fadd, floating, floating, +)
+FAST_BINARY(fast_fsub, floating, floating, -)
+FAST_BINARY(fast_fmpy, floating, floating, *)
+FAST_BINARY(fast_flt, floating, integer, <)
+FAST_BINARY(fast_fle, floating, integer, <=)
+FAST_BINARY(fast_feq, floating, integer, ==)
+FAST_BINARY(fast_fne, floating, integer, !=)
+FAST_BINARY(fast_fge, floating, integer, >=)
+FAST_BINARY(fast_fgt, floating, integer, >)
+
+static Extype_t
+fast_idiv(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+	Extype_t	r;
+
+	v = EVAL(ex, expr->data.operand.left, env);
+	r = EVAL(ex, expr->data.operand.right, env);
+	if (r.integer == 0)
+		exerror("integer divide by 0");
+	else
+		v.integer /= r.integer;
+	return v;
+}
+
+static Extype_t
+fast_imod(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+	Extype_t	r;
+
+	v = EVAL(ex, expr->data.operand.left, env);
+	r = EVAL(ex, expr->data.operand.right, env);
+	if (r.integer == 0)
+		exerror("integer 0 modulus");
+	else
+		v.integer %= r.integer;
+	return v;
+}
+
+static Extype_t
+fast_fdiv(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+	Extype_t	r;
+
+	v = EVAL(ex, expr->data.operand.left, env);
+	r = EVAL(ex, expr->data.operand.right, env);
+	if (r.floating == 0.0)
+		exerror("floating divide by 0");
+	else
+		v.floating /= r.floating;
+	return v;
+}
+
+static Extype_t
+fast_fmod(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+	Extype_t	r;
+
+	v = EVAL(ex, expr->data.operand.left, env);
+	r = EVAL(ex, expr->data.operand.right, env);
+	if ((r.integer = r.floating) == 0)
+		exerror("floating 0 modulus");
+	else
+		v.floating = (Sflong_t)v.floating % r.integer;
+	return v;
+}
+
+static Extype_t
+fast_ineg(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+
+	v = EVAL(ex, expr->data.operand.left, env);
+	v.integer = -v.integer;
+	return v;
+}
+
+static Extype_t
+fast_inot(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+
+	v = EVAL(ex, expr->data.operand.left, env);
+	v.integer = !v.integer;
+	return v;
+}
+
+static Extype_t
+fast_icom(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+
+	v = EVAL(ex, expr->data.operand.left, env);
+	v.integer = ~v.integer;
+	return v;
+}
+
+static Extype_t
+fast_fneg(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+
+	v = EVAL(ex, expr->data.operand.left, env);
+	v.floating = -v.floating;
+	return v;
+}
+
+static Extype_t
+fast_fnot(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+
+	v = EVAL(ex, expr->data.operand.left, env);
+	v.floating = !((Sflong_t)v.floating);
+	return v;
+}
+
+/*
+ * casts also evaluate their optional reference operand, as eval() does
+ */
+
+static Extype_t
+fast_i2f(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+
+	v = EVAL(ex, expr->data.operand.left, env);
+	if (expr->data.operand.right)
+		EVAL(ex, expr->data.operand.right, env);
+	v.floating = v.integer;
+	return v;
+}
+
+static Extype_t
+fast_f2i(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+
+	v = EVAL(ex, expr->data.operand.left, env);
+	if (expr->data.operand.right)
+		EVAL(ex, expr->data.operand.right, env);
+	v.integer = v.floating;
+	return v;
+}
+
+static Extype_t
+fast_s2b(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+
+	v = EVAL(ex, expr->data.operand.left, env);
+	if (expr->data.operand.right)
+		EVAL(ex, expr->data.operand.right, env);
+	v.integer = *v.string != 0;
+	return v;
+}
+
+static Extype_t
+fast_scat(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+	Extype_t	r;
+
+	v = EVAL(ex, expr->data.operand.left, env);
+	r = EVAL(ex, expr->data.operand.right, env);
+	v.string = str_add(ex, v.string, r.string);
+	return v;
+}
+
+static Extype_t
+fast_smatch(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+	Extype_t	r;
+
+	v = EVAL(ex, expr->data.operand.left, env);
+	r = EVAL(ex, expr->data.operand.right, env);
+	v.integer = ((v.string && r.string) ? ((ex->disc->version >= 19981111L && ex->disc->matchf) ? (*ex->disc->matchf)(ex, expr->data.operand.left, v.string, expr->data.operand.right, r.string, env, ex->disc) : strmatch(v.string, r.string)) : (v.string == r.string)) == (expr->op == EQ);
+	return v;
+}
+
+static Extype_t
+fast_scmp(Expr_t* ex, Exnode_t* expr, void* env)
+{
+	Extype_t	v;
+	Extype_t	r;
+
+	v = EVAL(ex, expr->data.operand.left, env);
+	r = EVAL(ex, expr->data.operand.right, env);
+	v.integer = strcoll(v.string, r.string);
+	switch (expr->op)
+	{
+	case '<':
+		v.integer = v.integer < 0;
+		break;
+	case LE:
+		v.integer = v.integer <= 0;
+		break;
+	case GE:
+		v.integer = v.integer >= 0;
+		break;
+	case '>':
+		v.integer = v.integer > 0;
+		break;
+	}
+	return v;
+}
+
+#define THREAD(x)	do { if ((x) && (x)->fastop != (x)->op) thread(x); } while (0)
+
+/*
+ * select the threaded evaluator for expr and its operands
+ * the selection is redone if the parser folds expr into a constant
+ */
+
+static void
+thread(Exnode_t* expr)
+{
+	Exnode_t*	x = expr->data.operand.left;
+	Exnode_t*	y = expr->data.operand.right;
+	Extype_t	(*f)(Expr_t*, Exnode_t*, void*) = 0;
+
+	expr->fastop = expr->op;
+	expr->fast = 0;
+	switch (expr->op)
+	{
+	case CONSTANT:
+		expr->fast = fast_constant;
+		return;
+	case DYNAMIC:
+		if (!expr->data.variable.index)
+			expr->fast = fast_scalar;
+		return;
+	case AND:
+		f = fast_and;
+		break;
+	case OR:
+		f = fast_or;
+		break;
+	case IF:
+	case FOR:
+	case WHILE:
+		THREAD(x);
+		THREAD(y->data.operand.left);
+		THREAD(y->data.operand.right);
+		expr->fast = expr->op == IF ? fast_if : fast_loop;
+		return;
+	case ';':
+	case ',':
+		expr->fast = fast_seq;
+		THREAD(x);
+		while ((y = expr->data.operand.right) && (y->op == ';' || y->op == ','))
+		{
+			THREAD(y->data.operand.left);
+			expr = y;
+		}
+		THREAD(y);
+		return;
+	case '?':
+		THREAD(x);
+		THREAD(y->data.operand.left);
+		THREAD(y->data.operand.right);
+		expr->fast = fast_cond;
+		return;
+	case '=':
+		if (!SCALAR(x) || x->type == STRING)
+			return;
+		if (expr->subop == '=')
+			f = fast_assign;
+		else if (expr->subop == '+' || expr->subop == '-' || expr->subop == '*' || expr->subop == '/' || expr->subop == '%')
+			switch (x->type)
+			{
+			case INTEGER:
+			case UNSIGNED:
+				f = fast_iassign;
+				break;
+			case FLOATING:
+				f = fast_fassign;
+				break;
+			}
+		x = 0;
+		break;
+	case INC:
+	case DEC:
+		if (!SCALAR(x))
+			return;
+		switch (x->type)
+		{
+		case INTEGER:
+		case UNSIGNED:
+			expr->fast = fast_iinc;
+			break;
+		case FLOATING:
+			expr->fast = fast_finc;
+			break;
+		}
+		return;
+	case '+':
+	case '-':
+	case '*':
+	case '/':
+	case '%':
+	case '&':
+	case '|':
+	case '^':
+	case '!':
+	case '~':
+	case '<':
+	case LE:
+	case EQ:
+	case NE:
+	case GE:
+	case '>':
+	case I2F:
+	case F2I:
+	case S2B:
+		if (y && !BUILTIN(y->type) && expr->binary)
+			return;
+		if (!y && expr->op != '-' && expr->op != '!' && expr->op != '~' && expr->op != I2F && expr->op != F2I && expr->op != S2B)
+			return;
+		switch (x->type)
+		{
+		case INTEGER:
+			switch (expr->op)
+			{
+			case '+':
+				f = fast_iadd;
+				break;
+			case '-':
+				f = y ? fast_isub : fast_ineg;
+				break;
+			case '*':
+				f = fast_impy;
+				break;
+			case '/':
+				f = fast_idiv;
+				break;
+			case '%':
+				f = fast_imod;
+				break;
+			case '&':
+				f = fast_iand;
+				break;
+			case '|':
+				f = fast_iior;
+				break;
+			case '^':
+				f = fast_ixor;
+				break;
+			case '!':
+				f = y ? 0 : fast_inot;
+				break;
+			case '~':
+				f = y ? 0 : fast_icom;
+				break;
+			case '<':
+				f = fast_ilt;
+				break;
+			case LE:
+				f = fast_ile;
+				break;
+			case EQ:
+				f = fast_ieq;
+				break;
+			case NE:
+				f = fast_ine;
+				break;
+			case GE:
+				f = fast_ige;
+				break;
+			case '>':
+				f = fast_igt;
+				break;
+			case I2F:
+				f = fast_i2f;
+				break;
+			}
+			break;
+		case FLOATING:
+			switch (expr->op)
+			{
+			case '+':
+				f = fast_fadd;
+				break;
+			case '-':
+				f = y ? fast_fsub : fast_fneg;
+				break;
+			case '*':
+				f = fast_fmpy;
+				break;
+			case '/':
+				f = fast_fdiv;
+				break;
+			case '%':
+				f = fast_fmod;
+				break;
+			case '!':
+				f = y ? 0 : fast_fnot;
+				break;
+			case '<':
+				f = fast_flt;
+				break;
+			case LE:
+				f = fast_fle;
+				break;
+			case EQ:
+				f = fast_feq;
+				break;
+			case NE:
+				f = fast_fne;
+				break;
+			case GE:
+				f = fast_fge;
+				break;
+			case '>':
+				f = fast_fgt;
+				break;
+			case F2I:
+				f = fast_f2i;
+				break;
+			}
+			break;
+		case STRING:
+			switch (expr->op)
+			{
+			case S2B:
+				f = fast_s2b;
+				break;
+			case '+':
+				f = fast_scat;
+				break;
+			case EQ:
+			case NE:
+				f = fast_smatch;
+				break;
+			case '<':
+			case LE:
+			case GE:
+			case '>':
+				f = fast_scmp;
+				break;
+			}
+			break;
+		}
+		break;
+	}
+	if (f)
+	{
+		THREAD(x);
+		THREAD(y);
+		expr->fast = f;
+	}
+}
+
 /*
  * internal exeval
  */
@@ -950,6 +1672,10 @@ eval(Expr_t* ex, register Exnode_t* expr, void* env)
 		v.integer = 1;
 		return v;
 	}
+	if (expr->fastop != expr->op)
+		thread(expr);
+	if (expr->fast)
+		return (*expr->fast)(ex, expr, env);
 	x = expr->data.operand.left;
 	switch (expr->op)
 	{
@@ -68,6 +68,8 @@ exnewnode(Expr_t* p, int op, int binary, int type, Exnode_t* left, Exnode_t* rig
 	x->local.pointer = 0;
 	x->data.operand.left = left;
 	x->data.operand.right = right;
+	x->fastop = 0;
+	x->fast = 0;
 	return x;
 }
 
@@ -346,6 +348,18 @@ static Exnode_t *exstringOf(Expr_t * p, register Exnode_t * x) {
 	return x;
 }
 
+/* exboolOf:
+ * Test STRING x for use as a condition.
+ * A constant string is folded to its INTEGER value.
+ */
+static Exnode_t *exboolOf(Expr_t * p, register Exnode_t * x) {
+	if (x->op != CONSTANT)
+	    return exnewnode(p, S2B, 1, INTEGER, x, NiL);
+	x->data.constant.value.integer = *x->data.constant.value.string != 0;
+	x->type = INTEGER;
+	return x;
+}
+
 /* exprint:
  * Generate argument list of strings.
  */
@@ -106,7 +106,8 @@ typedef struct Print_s			/* compiled printf arg node	*/
 
 #define _EX_NODE_PRIVATE_ \
 	Exshort_t	subop;		/* operator qualifier		*/ \
-	Exshort_t	pad_2;		/* padding			*/
+	Exshort_t	fastop;		/* op when fast was selected	*/ \
+	Extype_t	(*fast)(Expr_t*, Exnode_t*, void*); /* threaded eval */
 
 #define _EX_PROG_PRIVATE_ \
 	Vmalloc_t*	ve;		/* eval tmp region		*/ \
@@ -284,7 +284,7 @@ statement	:	'{' statement_list '}'
 			if (exisAssign ($3))
 				exwarn ("assignment used as boolean in if statement");
 			if ($3->type == STRING)
-				$3 = exnewnode(expr.program, S2B, 1, INTEGER, $3, NiL);
+				$3 = exboolOf(expr.program, $3);
 			else if (!INTEGRAL($3->type))
 				$3 = excast(expr.program, $3, INTEGER, NiL, 0);
 			$$ = exnewnode(expr.program, $1->index, 1, INTEGER, $3, exnewnode(expr.program, ':', 1, $5 ? $5->type : 0, $5, $6));
@@ -310,7 +310,7 @@ statement	:	'{' statement_list '}'
 				$5->data.constant.value.integer = 1;
 			}
 			else if ($5->type == STRING)
-				$5 = exnewnode(expr.program, S2B, 1, INTEGER, $5, NiL);
+				$5 = exboolOf(expr.program, $5);
 			else if (!INTEGRAL($5->type))
 				$5 = excast(expr.program, $5, INTEGER, NiL, 0);
 			$$ = exnewnode(expr.program, $1->index, 1, INTEGER, $5, exnewnode(expr.program, ';', 1, 0, $7, $9));
@@ -354,7 +354,7 @@ statement	:	'{' statement_list '}'
 			if (exisAssign ($3))
 				exwarn ("assignment used as boolean in while statement");
 			if ($3->type == STRING)
-				$3 = exnewnode(expr.program, S2B, 1, INTEGER, $3, NiL);
+				$3 = exboolOf(expr.program, $3);
 			else if (!INTEGRAL($3->type))
 				$3 = excast(expr.program, $3, INTEGER, NiL, 0);
 			$$ = exnewnode(expr.program, $1->index, 1, INTEGER, $3, exnewnode(expr.program, ';', 1, 0, NiL, $5));
@@ -722,14 +722,27 @@ expr		:	'(' expr ')'
 		{
 		logical:
 			if ($1->type == STRING)
-				$1 = exnewnode(expr.program, S2B, 1, INTEGER, $1, NiL);
+				$1 = exboolOf(expr.program, $1);
 			else if (!BUILTIN($1->type))
 				$1 = excast(expr.program, $1, INTEGER, NiL, 0);
 			if ($3->type == STRING)
-				$3 = exnewnode(expr.program, S2B, 1, INTEGER, $3, NiL);
+				$3 = exboolOf(expr.program, $3);
 			else if (!BUILTIN($3->type))
 				$3 = excast(expr.program, $3, INTEGER, NiL, 0);
-			goto binary;
+			if (!expr.program->errors && $1->op == CONSTANT && $3->op != CONSTANT && $1->type == INTEGER && $3->type == INTEGER)
+			{
+				/* a constant left operand decides which operand is the value;
+				 * $3 is not freed since that would close any array it names */
+				if (($1->data.constant.value.integer != 0) == ($2 == OR))
+					$$ = $1;
+				else
+				{
+					$$ = $3;
+					exfreenode(expr.program, $1);
+				}
+			}
+			else
+				goto binary;
 		}
 		|	expr OR expr
 		{
@@ -757,7 +770,7 @@ expr		:	'(' expr ')'
 			else if (!$7->type)
 				$7->type = $4->type;
 			if ($1->type == STRING)
-				$1 = exnewnode(expr.program, S2B, 1, INTEGER, $1, NiL);
+				$1 = exboolOf(expr.program, $1);
 			else if (!INTEGRAL($1->type))
 				$1 = excast(expr.program, $1, INTEGER, NiL, 0);
 			if ($4->type != $7->type)
@@ -790,7 +803,7 @@ expr		:	'(' expr ')'
 		{
 		iunary:
 			if ($2->type == STRING)
-				$2 = exnewnode(expr.program, S2B, 1, INTEGER, $2, NiL);
+				$2 = exboolOf(expr.program, $2);
 			else if (!INTEGRAL($2->type))
 				$2 = excast(expr.program, $2, INTEGER, NiL, 0);
 		unary:
@@ -109,6 +109,8 @@ extern "C" {
 #define GVRENDER_NO_WHITE_BG (1<<25)
 #define LAYOUT_NOT_REQUIRED (1<<26)
 #define OUTPUT_NOT_REQUIRED (1<<27)
+#define GVRENDER_MODIFIES_GRAPH (1<<28)
+#define OUTPUT_DRAW_OPS (1<<29)
 
     typedef struct {
 	int flags;
@@ -287,6 +289,7 @@ extern "C" {
 	char *output_data;
 	unsigned int output_data_allocated;
 	unsigned int output_data_position;
+	void *output_z;		/* compression state, private to gvdevice.c */
 
 	const char *output_langname;
 	int output_lang;
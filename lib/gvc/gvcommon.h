@@ -32,6 +32,10 @@ extern "C" {
 			    all pages in all layers */
 	const lt_symlist_t *builtins;
 	int demand_loading;
+	int detach_jobs; /* max jobs rendered in child processes: 0 none,
+			    < 0 one per processor; set by -j */
+	boolean single_thread; /* set in a detached child, which must not
+				  start threads after fork */
     } GVCOMMON_t;
 
 #ifdef __cplusplus
@@ -45,10 +45,27 @@
 static char z_file_header[] =
    {0x1f, 0x8b, /*magic*/ Z_DEFLATED, 0 /*flags*/, 0,0,0,0 /*time*/, 0 /*xflags*/, OS_CODE};
 
-static z_stream z_strm;
-static unsigned char *df;
-static unsigned int dfallocated;
-static unsigned long int crc;
+/* Compressed output is collected into groups of ZBLOCKS blocks of ZBLOCK
+ * bytes.  Each block is deflated as an independent raw stream, primed
+ * with the ZDICT bytes that precede it and ended with a sync flush so
+ * that the concatenation is a single valid deflate stream.  The blocks of
+ * a group are compressed concurrently when OpenMP is available.  The
+ * group size is fixed, so the output does not depend on the thread count.
+ */
+#define ZBLOCK (128*1024)
+#define ZBLOCKS 8
+#define ZDICT 32768
+
+typedef struct {
+    unsigned char *in;		/* ZDICT bytes of history, then the group */
+    size_t inlen;		/* bytes of the group collected so far */
+    size_t dictlen;		/* valid history bytes before the group */
+    unsigned char *out[ZBLOCKS];
+    size_t outlen[ZBLOCKS];
+    size_t outsize[ZBLOCKS];
+    unsigned long crc;
+    unsigned long total_in;
+} zstate_t;
 #endif /* HAVE_LIBZ */
 
 #include "const.h"
@@ -86,6 +103,119 @@ static size_t gvwrite_no_z (GVJ_t * job, const char *s, size_t len)
     return 0;
 }
 
+#ifdef HAVE_LIBZ
+/* zdeflate:
+ * Deflate block b of the current group into z->out[b].
+ * Return the zlib status.
+ */
+static int zdeflate(zstate_t *z, int b, int last)
+{
+    unsigned char *data = z->in + ZDICT;
+    unsigned char *start = data + (size_t)b * ZBLOCK;
+    size_t len = z->inlen - (size_t)b * ZBLOCK;
+    size_t hist = (size_t)b * ZBLOCK + z->dictlen;
+    size_t bound;
+    z_stream strm;
+    int ret;
+
+    if (len > ZBLOCK)
+	len = ZBLOCK;
+    if (hist > ZDICT)
+	hist = ZDICT;
+
+    memset(&strm, 0, sizeof(strm));
+    ret = deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+    if (ret != Z_OK)
+	return ret;
+    if (hist)
+	deflateSetDictionary(&strm, start - hist, hist);
+#ifdef HAVE_DEFLATEBOUND
+    bound = deflateBound(&strm, len);
+#else
+    bound = len + (len >> 8) + 64;
+#endif
+    bound += 16;	/* room for the sync flush marker */
+    if (z->outsize[b] < bound) {
+	z->outsize[b] = (bound + PAGE_ALIGN) & ~PAGE_ALIGN;
+	z->out[b] = realloc(z->out[b], z->outsize[b]);
+	if (!z->out[b]) {
+	    deflateEnd(&strm);
+	    return Z_MEM_ERROR;
+	}
+    }
+    strm.next_in = start;
+    strm.avail_in = len;
+    strm.next_out = z->out[b];
+    strm.avail_out = z->outsize[b];
+    ret = deflate(&strm, last ? Z_FINISH : Z_SYNC_FLUSH);
+    if (ret == (last ? Z_STREAM_END : Z_OK) && strm.avail_in == 0)
+	ret = Z_OK;
+    else if (ret == Z_OK || ret == Z_STREAM_END)
+	ret = Z_BUF_ERROR;
+    z->outlen[b] = strm.next_out - z->out[b];
+    deflateEnd(&strm);
+    return ret;
+}
+
+/* zgroup:
+ * Compress and write the collected group.  If last is set, the final
+ * block closes the deflate stream.
+ */
+static void zgroup(GVJ_t * job, zstate_t *z, int last)
+{
+    unsigned char *data = z->in + ZDICT;
+    int b, nb, rets[ZBLOCKS];
+    size_t hist, ret;
+
+    nb = (z->inlen + ZBLOCK - 1) / ZBLOCK;
+    if (nb == 0)
+	nb = 1;		/* the final block may be empty */
+
+    z->crc = crc32(z->crc, data, z->inlen);
+    z->total_in += z->inlen;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) if ((nb > 1) && !job->common->single_thread)
+#endif
+    for (b = 0; b < nb; b++)
+	rets[b] = zdeflate(z, b, last && (b == nb - 1));
+
+    for (b = 0; b < nb; b++) {
+	if (rets[b] != Z_OK) {
+            (job->common->errorfn) ("deflation problem %d\n", rets[b]);
+	    exit(1);
+	}
+	ret = gvwrite_no_z(job, (char*)z->out[b], z->outlen[b]);
+	if (ret != z->outlen[b]) {
+            (job->common->errorfn) ("gvwrite_no_z problem %d\n", ret);
+	    exit(1);
+	}
+    }
+
+    /* keep the tail of the group as history for the next one */
+    hist = z->inlen + z->dictlen;
+    if (hist > ZDICT)
+	hist = ZDICT;
+    memmove(z->in + ZDICT - hist, data + z->inlen - hist, hist);
+    z->dictlen = hist;
+    z->inlen = 0;
+}
+
+static void zfree(GVJ_t * job)
+{
+    zstate_t *z = job->output_z;
+    int b;
+
+    if (!z)
+	return;
+    for (b = 0; b < ZBLOCKS; b++)
+	free(z->out[b]);
+    free(z->in);
+    free(z);
+    job->output_z = NULL;
+}
+#endif /* HAVE_LIBZ */
+
 static void auto_output_filename(GVJ_t *job)
 {
     static char *buf;
@@ -167,21 +297,12 @@ int gvdevice_initialize(GVJ_t * job)
 
     if (job->flags & GVDEVICE_COMPRESSED_FORMAT) {
 #ifdef HAVE_LIBZ
-	z_stream *z = &z_strm;
-
-	z->zalloc = 0;
-	z->zfree = 0;
-	z->opaque = 0;
-	z->next_in = NULL;
-	z->next_out = NULL;
-	z->avail_in = 0;
-
-	crc = crc32(0L, Z_NULL, 0);
+	zstate_t *z;
 
-	if (deflateInit2(z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK) {
-	    (job->common->errorfn) ("Error initializing for deflation\n");
-	    return(1);
-	}
+	zfree(job);
+	z = job->output_z = zmalloc(sizeof(zstate_t));
+	z->in = gmalloc(ZDICT + ZBLOCKS * ZBLOCK);
+	z->crc = crc32(0L, Z_NULL, 0);
 	gvwrite_no_z(job, z_file_header, sizeof(z_file_header));
 #else
 	(job->common->errorfn) ("No libz support.\n");
@@ -193,53 +314,28 @@ int gvdevice_initialize(GVJ_t * job)
 
 size_t gvwrite (GVJ_t * job, const char *s, size_t len)
 {
-    size_t ret, olen;
+    size_t ret;
 
     if (!len || !s)
 	return 0;
 
     if (job->flags & GVDEVICE_COMPRESSED_FORMAT) {
 #ifdef HAVE_LIBZ
-	z_streamp z = &z_strm;
-	size_t dflen;
-
-#ifdef HAVE_DEFLATEBOUND
-	dflen = deflateBound(z, len);
-#else
-	/* deflateBound() is not available in older libz, e.g. from centos3 */
-	dflen = 2 * len  + dfallocated - z->avail_out;
-#endif
-	if (dfallocated < dflen) {
-	    dfallocated = (dflen + 1 + PAGE_ALIGN) & ~PAGE_ALIGN;
-	    df = realloc(df, dfallocated);
-	    if (! df) {
-                (job->common->errorfn) ("memory allocation failure\n");
-		exit(1);
-	    }
-	}
-
-	crc = crc32(crc, (unsigned char*)s, len);
-
-	z->next_in = (unsigned char*)s;
-	z->avail_in = len;
-	while (z->avail_in) {
-	    z->next_out = df;
-	    z->avail_out = dfallocated;
-	    ret=deflate (z, Z_NO_FLUSH);
-	    if (ret != Z_OK) {
-                (job->common->errorfn) ("deflation problem %d\n", ret);
-	        exit(1);
-	    }
-
-	    if ((olen = z->next_out - df)) {
-		ret = gvwrite_no_z (job, (char*)df, olen);
-	        if (ret != olen) {
-                    (job->common->errorfn) ("gvwrite_no_z problem %d\n", ret);
-	            exit(1);
-	        }
-	    }
+	zstate_t *z = job->output_z;
+	unsigned char *data = z->in + ZDICT;
+	size_t n, left = len;
+
+	while (left) {
+	    n = ZBLOCKS * ZBLOCK - z->inlen;
+	    if (n > left)
+		n = left;
+	    memcpy(data + z->inlen, s, n);
+	    z->inlen += n;
+	    s += n;
+	    left -= n;
+	    if (z->inlen == ZBLOCKS * ZBLOCK)
+		zgroup(job, z, 0);
 	}
-
 #else
 	(job->common->errorfn) ("No libz support.\n");
 	exit(1);
@@ -331,31 +427,12 @@ void gvdevice_finalize(GVJ_t * job)
 
     if (job->flags & GVDEVICE_COMPRESSED_FORMAT) {
 #ifdef HAVE_LIBZ
-	z_streamp z = &z_strm;
-	unsigned char out[8] = "";
-	int ret;
-	int cnt = 0;
-
-	z->next_in = out;
-	z->avail_in = 0;
-	z->next_out = df;
-	z->avail_out = dfallocated;
-	while ((ret = deflate (z, Z_FINISH)) == Z_OK && (cnt++ <= 100)) {
-	    gvwrite_no_z(job, (char*)df, z->next_out - df);
-	    z->next_out = df;
-	    z->avail_out = dfallocated;
-	}
-	if (ret != Z_STREAM_END) {
-            (job->common->errorfn) ("deflation finish problem %d cnt=%d\n", ret, cnt);
-	    exit(1);
-	}
-	gvwrite_no_z(job, (char*)df, z->next_out - df);
+	zstate_t *z = job->output_z;
+	unsigned char out[8];
+	unsigned long crc;
 
-	ret = deflateEnd(z);
-	if (ret != Z_OK) {
-	    (job->common->errorfn) ("deflation end problem %d\n", ret);
-	    exit(1);
-	}
+	zgroup(job, z, 1);
+	crc = z->crc;
 	out[0] = crc;
 	out[1] = crc >> 8;
 	out[2] = crc >> 16;
@@ -365,6 +442,7 @@ void gvdevice_finalize(GVJ_t * job)
 	out[6] = z->total_in >> 16;
 	out[7] = z->total_in >> 24;
 	gvwrite_no_z(job, (char*)out, sizeof(out));
+	zfree(job);
 #else
 	(job->common->errorfn) ("No libz support\n");
 	exit(1);
@@ -436,13 +514,13 @@ void gvprintf(GVJ_t * job, const char *format, ...)
 val_str(maxnegnum, -999999999999999.99)
 
 /* we use len and don't need the string to be terminated */
+#define NUMBUFSZ sizeof(maxnegnumstr)   /* buffer big enough for worst case */
 /* #define TERMINATED_NUMBER_STRING */
 
-/* Note.  Returned string is only good until the next call to gvprintnum */
-static char * gvprintnum (size_t *len, double number)
+/* Note.  Returned string is only good as long as the caller's tmpbuf */
+static char * gvprintnum (char *tmpbuf, size_t *len, double number)
 {
-    static char tmpbuf[sizeof(maxnegnumstr)];   /* buffer big enough for worst case */
-    char *result = tmpbuf+sizeof(maxnegnumstr); /* init result to end of tmpbuf */
+    char *result = tmpbuf+NUMBUFSZ; /* init result to end of tmpbuf */
     long int N;
     boolean showzeros, negative;
     int digit, i;
@@ -496,9 +574,9 @@ static char * gvprintnum (size_t *len, double number)
     if (negative)			/* print "-" if needed */
         *--result = '-';
 #ifdef TERMINATED_NUMBER_STRING
-    *len = tmpbuf+sizeof(maxnegnumstr)-1 - result;
+    *len = tmpbuf+NUMBUFSZ-1 - result;
 #else
-    *len = tmpbuf+sizeof(maxnegnumstr) - result;
+    *len = tmpbuf+NUMBUFSZ - result;
 #endif
     return result;				
 }
@@ -507,6 +585,7 @@ static char * gvprintnum (size_t *len, double number)
 #ifdef GVPRINTNUM_TEST
 int main (int argc, char *argv[])
 {
+    char tmpbuf[NUMBUFSZ];
     char *buf;
     size_t len;
 
@@ -522,7 +601,7 @@ int main (int argc, char *argv[])
     int i = sizeof(test) / sizeof(test[0]);
 
     while (i--) {
-	buf = gvprintnum(&len, test[i]);
+	buf = gvprintnum(tmpbuf, &len, test[i]);
         fprintf (stdout, "%g = %s %d\n", test[i], buf, len);
     }
 
@@ -532,22 +611,24 @@ int main (int argc, char *argv[])
 
 void gvprintdouble(GVJ_t * job, double num)
 {
+    char tmpbuf[NUMBUFSZ];
     char *buf;
     size_t len;
 
-    buf = gvprintnum(&len, num);
+    buf = gvprintnum(tmpbuf, &len, num);
     gvwrite(job, buf, len);
 } 
 
 void gvprintpointf(GVJ_t * job, pointf p)
 {
+    char tmpbuf[NUMBUFSZ];
     char *buf;
     size_t len;
 
-    buf = gvprintnum(&len, p.x);
+    buf = gvprintnum(tmpbuf, &len, p.x);
     gvwrite(job, buf, len);
     gvwrite(job, " ", 1);
-    buf = gvprintnum(&len, p.y);
+    buf = gvprintnum(tmpbuf, &len, p.y);
     gvwrite(job, buf, len);
 } 
 
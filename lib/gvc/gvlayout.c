@@ -26,6 +26,7 @@
 #include "cgraph.h"
 #include "gvcproc.h"
 #include "gvc.h"
+#include "gvxdot.h"
 
 extern void graph_init(Agraph_t *g, boolean use_rankdir);
 extern void graph_cleanup(Agraph_t *g);
@@ -113,6 +114,7 @@ int gvFreeLayout(GVC_t * gvc, Agraph_t * g)
     }
     
     if (GD_drawing(g)) {
+	gvFreeDrawOps(g);
 	graph_cleanup(g);
     }
     return 0;
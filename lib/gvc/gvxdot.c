@@ -0,0 +1,154 @@
+/* $Id$ $Revision$ */
+/* vim:set shiftwidth=4 ts=8: */
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: See CVS logs. Details at http://www.graphviz.org/
+ *************************************************************************/
+
+/*
+ * Structured access to the drawing operations of a layout.
+ *
+ * gvRenderOps runs the xdot renderer in a mode where it records each
+ * operation as an xdot_op, with the precision of the xdot attributes,
+ * instead of printing it. The operations of each object are kept in a
+ * record bound to it, one xdot per draw attribute, so that writers and
+ * applications can use them without a round trip through parseXDot.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gvxdot.h"
+#include "macros.h"
+#include "const.h"
+#include "gvcjob.h"
+#include "gvcint.h"
+#include "gvcproc.h"
+
+#define DRAWOPS "_drawops_"
+
+static char *opnames[] = {
+    "_draw_", "_ldraw_", "_hdraw_", "_tdraw_", "_hldraw_", "_tldraw_",
+};
+#define NUMOPS ((int)(sizeof(opnames)/sizeof(opnames[0])))
+
+typedef struct {
+    Agrec_t h;
+    xdot *ops[NUMOPS];
+} drawops_t;
+
+static int opindex(const char *name)
+{
+    int i;
+
+    for (i = 0; i < NUMOPS; i++)
+	if (streq(name, opnames[i]))
+	    return i;
+    return -1;
+}
+
+int gvRenderOps(GVC_t *gvc, graph_t *g)
+{
+    int rc;
+    GVJ_t *job;
+
+    g = g->root;
+
+    /* create a job for the xdot renderer */
+    rc = gvjobs_output_langname(gvc, "xdot");
+    job = gvc->job;
+    if (rc == NO_SUPPORT) {
+	agerr (AGERR, "Format: \"xdot\" not recognized. Use one of:%s\n",
+		gvplugin_list(gvc, API_device, "xdot"));
+	return -1;
+    }
+
+    job->output_lang = gvrender_select(job, job->output_langname);
+    if (!LAYOUT_DONE(g) && !(job->flags & LAYOUT_NOT_REQUIRED)) {
+	agerrorf( "Layout was not done\n");
+	return -1;
+    }
+    gvFreeDrawOps(g);
+    job->output_file = NULL;
+    job->flags |= OUTPUT_NOT_REQUIRED | OUTPUT_DRAW_OPS;
+    rc = gvRenderJobs(gvc, g);
+    gvrender_end_job(job);
+    gvjobs_delete(gvc);
+
+    return rc;
+}
+
+xdot *gvDrawOps(void *obj, const char *name)
+{
+    drawops_t *r = (drawops_t *) aggetrec(obj, DRAWOPS, FALSE);
+    int i;
+
+    if (!r || ((i = opindex(name)) < 0))
+	return NULL;
+    return r->ops[i];
+}
+
+void gvSetDrawOps(void *obj, const char *name, xdot *ops)
+{
+    drawops_t *r;
+    int i;
+
+    if ((i = opindex(name)) < 0) {
+	if (ops)
+	    freeXDot(ops);
+	return;
+    }
+    /* the root record marks a graph that has operations to free */
+    agbindrec(agroot(obj), DRAWOPS, sizeof(drawops_t), FALSE);
+    r = (drawops_t *) agbindrec(obj, DRAWOPS, sizeof(drawops_t), FALSE);
+    if (r->ops[i])
+	freeXDot(r->ops[i]);
+    r->ops[i] = ops;
+}
+
+static void freeops(void *obj)
+{
+    drawops_t *r = (drawops_t *) aggetrec(obj, DRAWOPS, FALSE);
+    int i;
+
+    if (!r)
+	return;
+    for (i = 0; i < NUMOPS; i++)
+	if (r->ops[i])
+	    freeXDot(r->ops[i]);
+    agdelrec(obj, DRAWOPS);
+}
+
+static void freesubgops(graph_t *g)
+{
+    graph_t *subg;
+
+    freeops(g);
+    for (subg = agfstsubg(g); subg; subg = agnxtsubg(subg))
+	freesubgops(subg);
+}
+
+void gvFreeDrawOps(graph_t *g)
+{
+    node_t *n;
+    edge_t *e;
+
+    g = g->root;
+    if (!aggetrec(g, DRAWOPS, FALSE))
+	return;
+    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	freeops(n);
+	for (e = agfstout(g, n); e; e = agnxtout(g, e))
+	    freeops(e);
+    }
+    freesubgops(g);
+}
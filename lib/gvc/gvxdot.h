@@ -0,0 +1,58 @@
+/* $Id$ $Revision$ */
+/* vim:set shiftwidth=4 ts=8: */
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: See CVS logs. Details at http://www.graphviz.org/
+ *************************************************************************/
+
+#ifndef			GVXDOT_H
+#define			GVXDOT_H
+
+#include "gvc.h"
+#include "xdot.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef GVDLL
+#define extern __declspec(dllexport)
+#else
+#define extern
+#endif
+
+/*visual studio*/
+#ifdef WIN32
+#ifndef GVC_EXPORTS
+#define extern __declspec(dllimport)
+#endif
+#endif
+/*end visual studio*/
+
+/* Render layout into xdot operations attached to the graph objects,
+ * without building the xdot string attributes */
+extern int gvRenderOps(GVC_t *gvc, graph_t *g);
+
+/* Return the operations of a graph, node or edge for an xdot attribute
+ * name such as "_draw_" or "_ldraw_", or NULL if there are none */
+extern xdot *gvDrawOps(void *obj, const char *name);
+
+/* Attach ops to obj under an xdot attribute name; obj takes ownership */
+extern void gvSetDrawOps(void *obj, const char *name, xdot *ops);
+
+/* Free the operations attached to a graph and all its objects */
+extern void gvFreeDrawOps(graph_t *g);
+
+#undef extern
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif			/* GVXDOT_H */
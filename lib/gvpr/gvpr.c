@@ -63,6 +63,7 @@ static const char *usage =
    -a <args>  - string arguments available as ARGV[0..]\n\
    -o <ofile> - write output to <ofile>; stdout by default\n\
    -n         - no read-ahead of input graphs\n\
+   -M         - read input graphs in place\n\
    -q         - turn off warning messages\n\
    -V         - print version info\n\
    -?         - print usage info\n\
@@ -75,6 +76,7 @@ typedef struct {
     int useFile;		/* true if program comes from a file */
     int compflags;
     int readAhead;
+    int fastRead;		/* read input with AGREAD_FAST */
     char **inFiles;
     int argc;
     char **argv;
@@ -341,6 +343,9 @@ doFlags(char* arg, int argi, int argc, char** argv, options* opts)
 	case 'n':
 	    opts->readAhead = 0;
 	    break;
+	case 'M':
+	    opts->fastRead = 1;
+	    break;
 	case 'a':
 	    if ((optarg = getOptarg(c, &arg, &argi, argc, argv))) {
 		opts->argc = parseArgs(optarg, opts->argc, &(opts->argv));
@@ -871,9 +876,19 @@ static void *ing_open(char *f)
     return sfopen(0, f, "r");
 }
 
+static agreader_t ingReader = AGREAD_YACC;
+
+/* ing_read:
+ * Only the input graphs are read with ingReader; graphs read by the
+ * program with readG and freadG keep the reader of the caller.
+ */
 static Agraph_t *ing_read(void *fp)
 {
-    return readG((Sfio_t *) fp);
+    agreader_t prev = agsetreader(ingReader);
+    Agraph_t *g = readG((Sfio_t *) fp);
+
+    agsetreader(prev);
+    return g;
 }
 
 static int ing_close(void *fp)
@@ -1024,6 +1039,7 @@ int gvpr (int argc, char *argv[], gvpropts * uopts)
 
     /* if program is not null */
     if (usesGraph(xprog)) {
+	ingReader = (opts->fastRead ? AGREAD_FAST : AGREAD_YACC);
 	if (uopts && uopts->ingraphs)
 	    ing = newIngGraphs(0, uopts->ingraphs, &ingDisc);
 	else
@@ -78,14 +78,110 @@ static void Agglomerative_Ink_Bundling_delete(Agglomerative_Ink_Bundling grid){
   FREE(grid);
 }
 
-static Agglomerative_Ink_Bundling Agglomerative_Ink_Bundling_establish(Agglomerative_Ink_Bundling grid, int *pick, real angle_param, real angle){
-  /* pick is a work array of dimension n, with n the total number of original edges */
+/* the candidate bundles of this many edges/bundles are evaluated together, in parallel */
+#define INK_BATCH 256
+
+static int group_pick(int i, int *ip, int *jp, int *pick){
+  /* put the original edges in edge/bundle i in pick, and return their number */
+  int ni;
+
+  if (ip){
+    ni = ip[i+1] - ip[i];
+    MEMCPY(pick, &(jp[ip[i]]), sizeof(int)*ni);
+    return ni;
+  }
+  pick[0] = i;
+  return 1;
+}
+
+static int merge_pick(int i, int jj, int *ip, int *jp, int *matching, Vector *cedges, int *pick){
+  /* put the original edges of the bundle formed by merging i with jj, or with the coarse edge jj
+     is already matched to, in pick, and return their number */
+  int npicks, jc = matching[jj], k, nj;
+
+  npicks = group_pick(i, ip, jp, pick);
+  if (jc == UNMATCHED) return npicks + group_pick(jj, ip, jp, pick + npicks);
+  nj = Vector_get_length(cedges[jc]);
+  for (k = 0; k < nj; k++) {
+    pick[npicks++] = *((int*) Vector_get(cedges[jc], k));
+  }
+  return npicks;
+}
+
+static ink_key merge_key(int i, int jj, int *matching, ink_key *gkeys, ink_key *ckeys){
+  /* the key of the bundle formed by merging i with jj, or with the coarse edge jj is already matched to */
+  int jc = matching[jj];
+
+  return ink_key_union(gkeys[i], (jc == UNMATCHED) ? gkeys[jj] : ckeys[jc]);
+}
+
+static void ink_prefetch(ink_memo memo, SparseMatrix A, int i0, int i1, int *ip, int *jp, int *matching, Vector *cedges,
+			 ink_key *gkeys, ink_key *ckeys, pedge *edges, real angle_param, real angle){
+  /* evaluate in parallel the ink of the candidate bundles of the unmatched edges/bundles i0, ..., i1 - 1,
+     as the matching stands now, and put them in the memo. Matches made while going through the batch
+     may still change some of the candidates; those are missing from the memo and evaluated there.
+     The ink of a bundle depends on the order of its edges in pick, so a memo hit may differ in the
+     last bits from evaluating the candidate in turn */
+  int *ia = A->ia, *ja = A->ja;
+  int i, j, c, ncand = 0, nkeys = 0;
+  int *cstart, *cpicks;
+  ink_key key, *cand;
+  real *cinks, inkv;
+
+  for (i = i0; i < i1; i++){
+    if (matching[i] != UNMATCHED) continue;
+    for (j = ia[i]; j < ia[i+1]; j++){
+      if (ja[j] == i) continue;
+      key = merge_key(i, ja[j], matching, gkeys, ckeys);
+      if (ink_memo_find(memo, key, &inkv)) continue;
+      ncand++;
+      nkeys += key.n;
+    }
+  }
+  if (ncand == 0) return;
+
+  cand = MALLOC(sizeof(ink_key)*ncand);
+  cstart = MALLOC(sizeof(int)*(ncand + 1));
+  cpicks = MALLOC(sizeof(int)*nkeys);
+  cinks = MALLOC(sizeof(real)*ncand);
+  cstart[0] = 0;
+  c = 0;
+  for (i = i0; i < i1; i++){
+    if (matching[i] != UNMATCHED) continue;
+    for (j = ia[i]; j < ia[i+1]; j++){
+      if (ja[j] == i) continue;
+      key = merge_key(i, ja[j], matching, gkeys, ckeys);
+      if (ink_memo_find(memo, key, &inkv)) continue;
+      cand[c] = key;
+      cstart[c + 1] = cstart[c] + merge_pick(i, ja[j], ip, jp, matching, cedges, &(cpicks[cstart[c]]));
+      c++;
+    }
+  }
+  assert(c == ncand);
+
+#pragma omp parallel for schedule(dynamic, 16) if (ncand > 64)
+  for (c = 0; c < ncand; c++){
+    real ink0;
+    point_t meet1, meet2;
+    cinks[c] = ink(edges, cstart[c + 1] - cstart[c], &(cpicks[cstart[c]]), &ink0, &meet1, &meet2, angle_param, angle);
+  }
+
+  for (c = 0; c < ncand; c++) ink_memo_add(memo, cand[c], cinks[c]);
+  FREE(cand);
+  FREE(cstart);
+  FREE(cpicks);
+  FREE(cinks);
+}
+
+static Agglomerative_Ink_Bundling Agglomerative_Ink_Bundling_establish(Agglomerative_Ink_Bundling grid, int *pick, ink_memo memo, real angle_param, real angle){
+  /* pick is a work array of dimension n, with n the total number of original edges.
+     memo holds the inks of the candidate bundles of the previous level, and receives those of this level */
   int *matching;
   SparseMatrix A = grid->A;
   int n = grid->n, level = grid->level, nc = 0;
   int *ia = A->ia, *ja = A->ja;
   // real *a;
-  int i, j, k, jj, jc, jmax, ni, nj, npicks;
+  int i, j, k, jj, jc, jmax, npicks;
   int *mask;
   pedge *edges = grid->edges;
   real *inks = grid->inks, *cinks, inki, inkj;
@@ -95,6 +191,7 @@ static Agglomerative_Ink_Bundling Agglomerative_Ink_Bundling_establish(Agglomera
 		    cedges[i] contain the list of origonal edges that make up the bundle i in the next level */
   real ink0, ink1, grand_total_ink = 0, grand_total_gain = 0;
   point_t meet1, meet2;
+  ink_key *gkeys, *ckeys, key;/* memo keys of the edges/bundles of this level, and of the coarse edges */
 
   if (Verbose > 1) fprintf(stderr,"level ===================== %d, n = %d\n",grid->level, n);
   cedges = MALLOC(sizeof(Vector)*n);
@@ -106,6 +203,17 @@ static Agglomerative_Ink_Bundling Agglomerative_Ink_Bundling_establish(Agglomera
     jp = grid->R0->ja;
   }
 
+  gkeys = MALLOC(sizeof(ink_key)*n);
+  ckeys = MALLOC(sizeof(ink_key)*n);
+  for (i = 0; i < n; i++){
+    if (ip){
+      gkeys[i] = ink_key_edge(jp[ip[i]]);
+      for (k = ip[i] + 1; k < ip[i+1]; k++) gkeys[i] = ink_key_union(gkeys[i], ink_key_edge(jp[k]));
+    } else {
+      gkeys[i] = ink_key_edge(i);
+    }
+  }
+
   matching = MALLOC(sizeof(int)*n);
   mask = MALLOC(sizeof(real)*n);
   for (i = 0; i < n; i++) mask[i] = -1;
@@ -115,6 +223,7 @@ static Agglomerative_Ink_Bundling Agglomerative_Ink_Bundling_establish(Agglomera
 
   //  a = (real*) A->a;
   for (i = 0; i < n; i++){
+    if (i % INK_BATCH == 0) ink_prefetch(memo, A, i, MIN(n, i + INK_BATCH), ip, jp, matching, cedges, gkeys, ckeys, edges, angle_param, angle);
     if (matching[i] != UNMATCHED) continue;
 
     /* find the best matching in ink saving */
@@ -129,36 +238,22 @@ static Agglomerative_Ink_Bundling Agglomerative_Ink_Bundling_establish(Agglomera
       if ((jc=matching[jj]) == UNMATCHED){
 	/* neither i nor jj are matched */
 	inki = inks[i]; inkj = inks[jj];
-	if (ip && jp){/* not the first level */
-	  ni = (ip[i+1] - ip[i]);/* number of edges represented by i */
-	  nj = (ip[jj+1] - ip[jj]);/* number of edges represented by jj */
-	  MEMCPY(pick, &(jp[ip[i]]), sizeof(int)*ni);
-	  MEMCPY(pick+ni, &(jp[ip[jj]]), sizeof(int)*nj);
-	} else {/* first level */
-	  pick[0] = i; pick[1] = jj;
-	  ni = nj = 1;
-	}
 	if (Verbose && DEBUG) fprintf(stderr, "ink(%d)=%f, ink(%d)=%f", i, inki, jj, inkj);
       } else {
 	/* j is already matched. Its content is on cedges[jc] */
 	inki = inks[i]; inkj = cinks[jc];
 	if (Verbose && DEBUG) fprintf(stderr, "ink(%d)=%f, ink(%d->%d)=%f", i, inki, jj, jc, inkj);
-	if (ip) {
-	  ni = (ip[i+1] - ip[i]);/* number of edges represented by i */
-	  MEMCPY(pick, &(jp[ip[i]]), sizeof(int)*ni);
-	} else {
-	  ni = 1; pick[0] = i; 
-	}
-	nj = Vector_get_length(cedges[jc]);
-	npicks = ni;
-	for (k = 0; k < nj; k++) {
-	  pick[npicks++] = *((int*) Vector_get(cedges[jc], k));
-	}
       }
 
-      npicks = ni + nj;
-      ink1 = ink(edges, npicks, pick, &ink0, &meet1, &meet2, angle_param, angle);
+      key = merge_key(i, jj, matching, gkeys, ckeys);
+      ink_requests++;
+      if (!ink_memo_find(memo, key, &ink1)){
+	npicks = merge_pick(i, jj, ip, jp, matching, cedges, pick);
+	ink1 = ink(edges, npicks, pick, &ink0, &meet1, &meet2, angle_param, angle);
+	ink_memo_add(memo, key, ink1);
+      }
       if (Verbose && DEBUG) {
+	npicks = merge_pick(i, jj, ip, jp, matching, cedges, pick);
 	fprintf(stderr,", if merging {");
 	for (k = 0; k < npicks; k++) fprintf(stderr,"%d,", pick[k]);
 	fprintf(stderr,"}, ");
@@ -196,6 +291,7 @@ static Agglomerative_Ink_Bundling Agglomerative_Ink_Bundling_establish(Agglomera
 	} else {
 	  Vector_add(cedges[nc], (void*) (&jmax));
 	}
+	ckeys[nc] = gkeys[jmax];
 	jc = nc;
 	nc++;
       } else {/*j is already matched */
@@ -208,6 +304,8 @@ static Agglomerative_Ink_Bundling Agglomerative_Ink_Bundling_establish(Agglomera
       assert(maxgain <= 0);
       matching[i] = nc;
       jc = nc;
+      ckeys[jc].n = 0;
+      ckeys[jc].h1 = ckeys[jc].h2 = 0;
       minink = inks[i];
       nc++;
     }
@@ -222,6 +320,7 @@ static Agglomerative_Ink_Bundling Agglomerative_Ink_Bundling_establish(Agglomera
     } else {
 	Vector_add(cedges[jc], (void*) (&i));
     }
+    ckeys[jc] = ink_key_union(ckeys[jc], gkeys[i]);
     cinks[jc] = minink;
     grand_total_ink += minink;
     grand_total_gain += maxgain;
@@ -277,7 +376,8 @@ static Agglomerative_Ink_Bundling Agglomerative_Ink_Bundling_establish(Agglomera
 			 cgrid->n, grid->total_ink, grand_total_ink, grid->total_ink - grand_total_ink, grand_total_gain);	 
     assert(ABS(grid->total_ink - cgrid->total_ink - grand_total_gain) <= 0.0001*grid->total_ink);
 
-    cgrid = Agglomerative_Ink_Bundling_establish(cgrid, pick, angle_param, angle);
+    ink_memo_next_level(memo);
+    cgrid = Agglomerative_Ink_Bundling_establish(cgrid, pick, memo, angle_param, angle);
     grid->next = cgrid;
     cgrid->prev = grid;
 
@@ -292,6 +392,8 @@ static Agglomerative_Ink_Bundling Agglomerative_Ink_Bundling_establish(Agglomera
   for (i = 0; i < n; i++) Vector_delete(cedges[i]);
   FREE(cedges);
   FREE(mask);
+  FREE(gkeys);
+  FREE(ckeys);
   return grid;
 }
 
@@ -547,6 +649,7 @@ static Agglomerative_Ink_Bundling Agglomerative_Ink_Bundling_new(SparseMatrix A0
   /* give a link of edges and their nearest neighbor graph, return a multilevel of edge bundling based on ink saving */
   Agglomerative_Ink_Bundling grid;
   int *pick;
+  ink_memo memo;
   SparseMatrix A = A0;
 
   if (!SparseMatrix_is_symmetric(A, FALSE) || A->type != MATRIX_TYPE_REAL){
@@ -557,7 +660,9 @@ static Agglomerative_Ink_Bundling Agglomerative_Ink_Bundling_new(SparseMatrix A0
   pick = MALLOC(sizeof(int)*A0->m);
   
   //grid = Agglomerative_Ink_Bundling_aggressive_establish(grid, pick, angle_param, angle);
-  grid = Agglomerative_Ink_Bundling_establish(grid, pick, angle_param, angle);
+  memo = ink_memo_new();
+  grid = Agglomerative_Ink_Bundling_establish(grid, pick, memo, angle_param, angle);
+  ink_memo_delete(memo);
   FREE(pick);
 
   if (A != A0) grid->delete_top_level_A = TRUE;/* be sure to clean up later */
@@ -763,12 +868,12 @@ pedge* agglomerative_ink_bundling(int dim, SparseMatrix A, pedge* edges, int nne
   real current_ink = -1, ink0;
   pedge *edges2;
 
-  ink_count = 0;
+  ink_count = ink_calls = ink_requests = 0;
   edges2 = agglomerative_ink_bundling_internal(dim, A, edges, nneighbor, &recurse_level, MAX_RECURSE_LEVEL, angle_param, angle, open_gl, &current_ink, &ink0, flag);
 
   
   if (Verbose > 1)
-    fprintf(stderr,"initial total ink = %f, final total ink = %f, inksaving = %f percent, total ink_calc = %f, avg ink_calc per edge = %f\n", ink0, current_ink, (ink0-current_ink)/ink0, ink_count,  ink_count/(real) A->m);
+    fprintf(stderr,"initial total ink = %f, final total ink = %f, inksaving = %f percent, total ink_calc = %f, avg ink_calc per edge = %f, ink evaluations = %.0f of %.0f candidates\n", ink0, current_ink, (ink0-current_ink)/ink0, ink_count,  ink_count/(real) A->m, ink_calls, ink_requests);
   return edges2;
 }
 
@@ -18,6 +18,8 @@
 #include "ink.h"
 
 double ink_count;
+double ink_calls;
+double ink_requests;
 
 static point_t addPoint (point_t a, point_t b)
 {
@@ -247,7 +249,10 @@ double ink(pedge* edges, int numEdges, int *pick, double *ink0, point_t *meet1,
   double wgt = 0;
 
   //  fprintf(stderr,"in ink code ========\n");
+#pragma omp atomic
   ink_count += numEdges;
+#pragma omp atomic
+  ink_calls += 1;
 
   *ink0 = 0;
 
@@ -355,3 +360,141 @@ double ink1(pedge e){
   ink0 += sqrt(xx*xx + yy*yy);
   return ink0;
 }
+
+/* the bundle keys are sums of a hash of each edge, so that the key of a union of disjoint bundles
+   is the sum of their keys. Two independent 64 bit sums make a clash between different bundles
+   of the same size vanishingly unlikely, and spare storing and comparing the edge lists */
+static uint64_t mix64(uint64_t x){
+  /* splitmix64 finalizer */
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+ink_key ink_key_edge(int e){
+  ink_key key;
+
+  key.n = 1;
+  key.h1 = mix64((uint64_t) e + 1);
+  key.h2 = mix64(((uint64_t) e + 1)*0x9e3779b97f4a7c15ULL);
+  return key;
+}
+
+ink_key ink_key_union(ink_key a, ink_key b){
+  a.n += b.n;
+  a.h1 += b.h1;
+  a.h2 += b.h2;
+  return a;
+}
+
+typedef struct {
+  /* open addressing hash table of bundle inks. A slot with n = 0 is empty */
+  int size;/* number of slots, a power of 2 */
+  int n;/* number of slots used */
+  ink_key *keys;
+  real *val;
+} ink_table;
+
+struct ink_memo_struct {
+  ink_table *cur;/* bundles of this level, and those of the previous level looked up again */
+  ink_table *old;/* bundles of the previous level */
+};
+
+static ink_table *ink_table_new(int size){
+  ink_table *t = MALLOC(sizeof(ink_table));
+  int i;
+
+  t->size = size;
+  t->n = 0;
+  t->keys = MALLOC(sizeof(ink_key)*size);
+  t->val = MALLOC(sizeof(real)*size);
+  for (i = 0; i < size; i++) t->keys[i].n = 0;
+  return t;
+}
+
+static void ink_table_delete(ink_table *t){
+  if (!t) return;
+  FREE(t->keys);
+  FREE(t->val);
+  FREE(t);
+}
+
+static int ink_table_slot(ink_table *t, ink_key key){
+  /* the slot holding the bundle, or the empty slot where it would go */
+  int i = (int) (key.h1 & (uint64_t) (t->size - 1));
+  ink_key *k;
+
+  while ((k = &(t->keys[i]))->n > 0){
+    if (k->h1 == key.h1 && k->h2 == key.h2 && k->n == key.n) break;
+    i = (i + 1) & (t->size - 1);
+  }
+  return i;
+}
+
+static void ink_table_add(ink_table *t, ink_key key, real inkv){
+  ink_table *t2;
+  int i;
+
+  if (2*(t->n + 1) > t->size){
+    t2 = ink_table_new(2*t->size);
+    for (i = 0; i < t->size; i++){
+      if (t->keys[i].n > 0) ink_table_add(t2, t->keys[i], t->val[i]);
+    }
+    FREE(t->keys);
+    FREE(t->val);
+    *t = *t2;
+    FREE(t2);
+  }
+  i = ink_table_slot(t, key);
+  if (t->keys[i].n > 0) return;
+  t->keys[i] = key;
+  t->val[i] = inkv;
+  t->n++;
+}
+
+ink_memo ink_memo_new(void){
+  ink_memo memo = MALLOC(sizeof(struct ink_memo_struct));
+
+  memo->cur = ink_table_new(1024);
+  memo->old = NULL;
+  return memo;
+}
+
+void ink_memo_delete(ink_memo memo){
+  if (!memo) return;
+  ink_table_delete(memo->cur);
+  ink_table_delete(memo->old);
+  FREE(memo);
+}
+
+void ink_memo_next_level(ink_memo memo){
+  ink_table_delete(memo->old);
+  memo->old = memo->cur;
+  memo->cur = ink_table_new(1024);
+}
+
+int ink_memo_find(ink_memo memo, ink_key key, real *inkv){
+  int i;
+
+  i = ink_table_slot(memo->cur, key);
+  if (memo->cur->keys[i].n > 0){
+    *inkv = memo->cur->val[i];
+    return TRUE;
+  }
+  if (memo->old){
+    i = ink_table_slot(memo->old, key);
+    if (memo->old->keys[i].n > 0){
+      /* still a candidate, so keep it for the next level */
+      *inkv = memo->old->val[i];
+      ink_table_add(memo->cur, key, *inkv);
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+void ink_memo_add(ink_memo memo, ink_key key, real inkv){
+  ink_table_add(memo->cur, key, inkv);
+}
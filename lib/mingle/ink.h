@@ -11,6 +11,7 @@
 #ifndef INK_H
 #define INK_H
 
+#include <stdint.h>
 #include <edge_bundling.h>
 
 typedef struct {
@@ -32,6 +33,32 @@ typedef struct {
 double ink(pedge* edges, int numEdges, int *pick, double *ink0, point_t *meet1, point_t *meet2, real angle_param, real angle);
 double ink1(pedge e);
 
-extern double ink_count;
+/* a memo of the ink of bundles, keyed by their set of original edges, so that bundles which are
+   candidates again on the next level of agglomeration are not recomputed. It keeps the bundles of
+   the current and the previous level only; ink_memo_next_level moves on to a new level.
+   As ink sums over the edges in the order given, the ink found may differ in the last bits
+   from that of the same bundle picked in another order. The memo is not thread safe */
+typedef struct {
+  int n;/* number of edges in the bundle */
+  uint64_t h1, h2;
+} ink_key;
+
+typedef struct ink_memo_struct *ink_memo;
+
+/* the key of the bundle of the single original edge e */
+ink_key ink_key_edge(int e);
+/* the key of the union of two bundles with no edge in common */
+ink_key ink_key_union(ink_key a, ink_key b);
+
+ink_memo ink_memo_new(void);
+void ink_memo_delete(ink_memo memo);
+void ink_memo_next_level(ink_memo memo);
+/* return TRUE, and the ink in *inkv, if the bundle is in the memo */
+int ink_memo_find(ink_memo memo, ink_key key, real *inkv);
+void ink_memo_add(ink_memo memo, ink_key key, real inkv);
+
+extern double ink_count;/* number of edges over all calls to ink */
+extern double ink_calls;/* number of calls to ink */
+extern double ink_requests;/* number of candidate bundles looked up in a memo */
 
 #endif /* INK_H */
@@ -0,0 +1,206 @@
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: See CVS logs. Details at http://www.graphviz.org/
+ *************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "general.h"
+#include "kd_tree.h"
+
+/* subtrees of at most this many points are scanned linearly */
+#define KD_LEAF 8
+
+typedef struct {
+  int k;/* number of neighbors wanted */
+  int cnt;/* number found so far */
+  int *idx;/* max-heap on dist of the best cnt points so far, by position in tree order */
+  real *dist;
+  real epsfac;/* (1+eps)^2 */
+} kd_heap;
+
+static void swap_int(int *a, int i, int j){
+  int tmp = a[i];
+  a[i] = a[j];
+  a[j] = tmp;
+}
+
+static void kd_select(int *perm, real *x, int dim, int d, int lo, int hi, int nth){
+  /* rearrange perm[lo:hi-1] so that perm[nth] is the point with the nth smallest d-th coordinate,
+     with no larger one before it and no smaller one after it. Three way partitioning keeps
+     this linear when many points share a coordinate */
+  int lt, gt, i;
+  real pivot, v;
+
+  while (hi - lo > 1){
+    pivot = x[perm[lo + (hi - lo)/2]*dim + d];
+    lt = i = lo;
+    gt = hi;
+    while (i < gt){/* [lo,lt) < pivot, [lt,i) == pivot, [gt,hi) > pivot */
+      v = x[perm[i]*dim + d];
+      if (v < pivot) {
+	swap_int(perm, lt++, i++);
+      } else if (v > pivot) {
+	swap_int(perm, i, --gt);
+      } else {
+	i++;
+      }
+    }
+    if (nth < lt) {
+      hi = lt;
+    } else if (nth >= gt) {
+      lo = gt;
+    } else {
+      return;
+    }
+  }
+}
+
+static void kd_build(kd_tree t, int *perm, real *x, int lo, int hi){
+  int dim = t->dim, mid, i, k, best = 0;
+  real xmin, xmax, v, spread = -1;
+
+  if (hi - lo <= KD_LEAF) return;
+
+  /* split at the median along the dimension of largest spread */
+  for (k = 0; k < dim; k++){
+    xmin = xmax = x[perm[lo]*dim + k];
+    for (i = lo + 1; i < hi; i++){
+      v = x[perm[i]*dim + k];
+      xmin = MIN(xmin, v);
+      xmax = MAX(xmax, v);
+    }
+    if (xmax - xmin > spread){
+      spread = xmax - xmin;
+      best = k;
+    }
+  }
+  mid = (lo + hi)/2;
+  kd_select(perm, x, dim, best, lo, hi, mid);
+  t->split[mid] = best;
+  kd_build(t, perm, x, lo, mid);
+  kd_build(t, perm, x, mid + 1, hi);
+}
+
+kd_tree kd_tree_new(int n, int dim, real *x){
+  kd_tree t;
+  int *perm, i, k;
+
+  t = MALLOC(sizeof(struct kd_tree_struct));
+  t->n = n;
+  t->dim = dim;
+  t->x = MALLOC(sizeof(real)*MAX(n, 1)*dim);
+  t->id = MALLOC(sizeof(int)*MAX(n, 1));
+  t->split = MALLOC(sizeof(int)*MAX(n, 1));
+
+  perm = t->id;
+  for (i = 0; i < n; i++) perm[i] = i;
+  kd_build(t, perm, x, 0, n);
+  for (i = 0; i < n; i++){
+    for (k = 0; k < dim; k++) t->x[i*dim + k] = x[perm[i]*dim + k];
+  }
+  return t;
+}
+
+void kd_tree_delete(kd_tree t){
+  if (!t) return;
+  FREE(t->x);
+  FREE(t->id);
+  FREE(t->split);
+  FREE(t);
+}
+
+static void heap_down(kd_heap *h, int i, int cnt){
+  int *idx = h->idx, c, id = idx[i];
+  real *dist = h->dist, d = dist[i];
+
+  while ((c = 2*i + 1) < cnt){
+    if (c + 1 < cnt && dist[c + 1] > dist[c]) c++;
+    if (dist[c] <= d) break;
+    dist[i] = dist[c];
+    idx[i] = idx[c];
+    i = c;
+  }
+  dist[i] = d;
+  idx[i] = id;
+}
+
+static void kd_visit(kd_tree t, real *q, int i, kd_heap *h){
+  /* offer the i-th point in tree order to the heap */
+  int *idx = h->idx, dim = t->dim, k, p;
+  real *dist = h->dist, *y = &(t->x[i*dim]), d = 0, dx;
+
+  if (h->cnt < h->k){
+    for (k = 0; k < dim; k++){
+      dx = q[k] - y[k];
+      d += dx*dx;
+    }
+    /* sift up */
+    for (p = h->cnt++; p > 0 && dist[(p - 1)/2] < d; p = (p - 1)/2){
+      dist[p] = dist[(p - 1)/2];
+      idx[p] = idx[(p - 1)/2];
+    }
+    dist[p] = d;
+    idx[p] = i;
+    return;
+  }
+  for (k = 0; k < dim; k++){
+    dx = q[k] - y[k];
+    d += dx*dx;
+    if (d >= dist[0]) return;
+  }
+  dist[0] = d;
+  idx[0] = i;
+  heap_down(h, 0, h->cnt);
+}
+
+static void kd_search(kd_tree t, real *q, int lo, int hi, kd_heap *h){
+  int mid, i;
+  real diff;
+
+  if (hi - lo <= KD_LEAF){
+    for (i = lo; i < hi; i++) kd_visit(t, q, i, h);
+    return;
+  }
+  mid = (lo + hi)/2;
+  diff = q[t->split[mid]] - t->x[mid*t->dim + t->split[mid]];
+  kd_visit(t, q, mid, h);
+  if (diff < 0){
+    kd_search(t, q, lo, mid, h);
+    if (h->cnt < h->k || diff*diff*h->epsfac < h->dist[0]) kd_search(t, q, mid + 1, hi, h);
+  } else {
+    kd_search(t, q, mid + 1, hi, h);
+    if (h->cnt < h->k || diff*diff*h->epsfac < h->dist[0]) kd_search(t, q, lo, mid, h);
+  }
+}
+
+int kd_tree_knn(kd_tree t, real *q, int k, real eps, int *idx, real *dist){
+  kd_heap h;
+  int i, m, tmp;
+  real d;
+
+  h.k = MIN(k, t->n);
+  h.cnt = 0;
+  h.idx = idx;
+  h.dist = dist;
+  h.epsfac = (1 + eps)*(1 + eps);
+  if (h.k <= 0) return 0;
+
+  kd_search(t, q, 0, t->n, &h);
+
+  /* heap sort, nearest first */
+  for (m = h.cnt - 1; m > 0; m--){
+    d = dist[0]; dist[0] = dist[m]; dist[m] = d;
+    tmp = idx[0]; idx[0] = idx[m]; idx[m] = tmp;
+    heap_down(&h, 0, m);
+  }
+  for (i = 0; i < h.cnt; i++) idx[i] = t->id[idx[i]];
+  return h.cnt;
+}
@@ -0,0 +1,40 @@
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: See CVS logs. Details at http://www.graphviz.org/
+ *************************************************************************/
+
+#ifndef KD_TREE_H
+#define KD_TREE_H
+
+typedef struct kd_tree_struct *kd_tree;
+
+struct kd_tree_struct {
+  /* a balanced k-d tree over n points in dim dimensions, stored implicitly. The subtree of
+     points [lo, hi) has its splitting point at mid = (lo+hi)/2, with the points of [lo, mid) on
+     the low side and those of [mid+1, hi) on the high side of split[mid]. Ranges of at most
+     KD_LEAF points are leaves and are scanned linearly. The points are copied in tree
+     order, so that each subtree is contiguous in memory */
+  int n;
+  int dim;
+  real *x;/* coordinates in tree order, n*dim */
+  int *id;/* id[i] is the index of the i-th point in tree order in the original array */
+  int *split;/* splitting dimension of the point at the middle of a subtree */
+};
+
+/* build the tree of the n points x[i*dim : i*dim + dim - 1]. x is copied */
+kd_tree kd_tree_new(int n, int dim, real *x);
+
+void kd_tree_delete(kd_tree t);
+
+/* find the k nearest points to q, including any point equal to q. On return idx[0..k-1] holds their
+   original indices and dist[0..k-1] their squared distances, nearest first. With eps > 0, the
+   i-th point found is within (1+eps) times the distance to the true i-th nearest. Returns
+   the number found, which is k unless there are fewer than k points. Safe to call concurrently. */
+int kd_tree_knn(kd_tree t, real *q, int k, real eps, int *idx, real *dist);
+
+#endif /* KD_TREE_H */
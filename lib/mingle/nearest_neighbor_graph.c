@@ -14,9 +14,62 @@
 
 #include "general.h"
 #include "SparseMatrix.h"
-#include "nearest_neighbor_graph_ann.h"
+#include "kd_tree.h"
 #include "nearest_neighbor_graph.h"
 
+/* below this many points the queries are not worth spreading over threads */
+#define KNN_PARALLEL_N 1000
+
+static void sort_pts(int n, int dim, real *x, int along){
+  /* for edges given as 4D points (x1,y1,x2,y2), swap the end points so that edges always go
+     from low to high in coordinate "along" (0 for x, 1 for y), ties broken by the other one */
+  real *p, t;
+  int i, a = along, b = 1 - along;
+
+  if (dim != 4) return;
+  for (i = 0; i < n; i++){
+    p = &(x[i*dim]);
+    if (p[a] < p[2 + a] || (p[a] == p[2 + a] && p[b] < p[2 + b])) continue;
+    t = p[0]; p[0] = p[2]; p[2] = t;
+    t = p[1]; p[1] = p[3]; p[3] = t;
+  }
+}
+
+static int knn_sweep(int nPts, int dim, int k, real eps, real *x, int *irn, int *jcn, real *val){
+  /* append the k nearest neighbors of each point, other than itself, to irn/jcn/val, with
+     val the squared distance. Each point is queried independently into its own k slots,
+     so the result does not depend on the number of threads. Returns the number of entries */
+  kd_tree t;
+  int *nbr, i, j, nz = 0;
+  real *dist;
+
+  t = kd_tree_new(nPts, dim, x);
+  nbr = MALLOC(sizeof(int)*nPts*k);
+  dist = MALLOC(sizeof(real)*nPts*k);
+
+  /* query in tree order, so that consecutive queries visit mostly the same part of the tree */
+#pragma omp parallel for schedule(dynamic, 64) if (nPts > KNN_PARALLEL_N)
+  for (j = 0; j < nPts; j++){
+    int p = t->id[j], m;
+    m = kd_tree_knn(t, &(t->x[j*dim]), k, eps, &(nbr[p*k]), &(dist[p*k]));
+    for (; m < k; m++) nbr[p*k + m] = -1;
+  }
+
+  for (i = 0; i < nPts; i++){
+    for (j = i*k; j < (i + 1)*k; j++){
+      if (nbr[j] < 0 || nbr[j] == i) continue;
+      irn[nz] = i;
+      jcn[nz] = nbr[j];
+      val[nz++] = dist[j];
+    }
+  }
+
+  FREE(nbr);
+  FREE(dist);
+  kd_tree_delete(t);
+  return nz;
+}
+
 SparseMatrix nearest_neighbor_graph(int nPts, int num_neigbors, int dim, double *x, double eps){
   /* Gives a nearest neighbor graph of a list of dim-dimendional points. The result is a sparse matrix
      of nPts x nPts, with num_neigbors entries per row.
@@ -27,9 +80,11 @@ SparseMatrix nearest_neighbor_graph(int nPts, int num_neigbors, int dim, double
     eps: error tolerance
     x: nPts*dim vector. The i-th point is x[i*dim : i*dim + dim - 1]
 
+    The neighbors are found with a k-d tree (kd_tree.c), exactly when eps = 0. For edges given
+    as 4D points, this is done twice: with the edges oriented left to right, then bottom to top.
   */
   int *irn = NULL, *jcn = NULL, nz;
-  real *val = NULL;
+  real *val = NULL, *xx;
   SparseMatrix A;
   int k = num_neigbors;
 
@@ -37,18 +92,20 @@ SparseMatrix nearest_neighbor_graph(int nPts, int num_neigbors, int dim, double
   irn =  MALLOC(sizeof(int)*nPts*k*2);
   jcn =  MALLOC(sizeof(int)*nPts*k*2);
   val =  MALLOC(sizeof(double)*nPts*k*2);
+  xx = MALLOC(sizeof(real)*nPts*dim);
+  memcpy(xx, x, sizeof(real)*nPts*dim);
 
-#ifdef HAVE_ANN
-  nearest_neighbor_graph_ann(nPts, dim, num_neigbors, eps, x, &nz, &irn, &jcn, &val);
+  sort_pts(nPts, dim, xx, 0);
+  nz = knn_sweep(nPts, dim, k, eps, xx, irn, jcn, val);
+  sort_pts(nPts, dim, xx, 1);
+  nz += knn_sweep(nPts, dim, k, eps, xx, irn + nz, jcn + nz, val + nz);
 
   A = SparseMatrix_from_coordinate_arrays(nz, nPts, nPts, irn, jcn, (void *) val, MATRIX_TYPE_REAL, sizeof(real));
-#else
-  A = NULL;
-#endif
 
   FREE(irn);
   FREE(jcn);
   FREE(val);
+  FREE(xx);
 
   return A;
 
@@ -0,0 +1,525 @@
+/* $Id$ $Revision$ */
+/* vim:set shiftwidth=4 ts=8: */
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: See CVS logs. Details at http://www.graphviz.org/
+ *************************************************************************/
+
+/*
+ * Layout of large graphs without the all-pairs distance matrix.
+ *
+ * Shortest path distances are computed from k pivots only, giving
+ * O(k*n) memory. The initial layout is by pivot MDS (Brandes and Pich,
+ * "Eigensolver Methods for Progressive Multidimensional Scaling of
+ * Large Data"). Stress is then minimized over the sparse stress model
+ * (Ortmann, Klimenta and Brandes, "A Sparse Stress Model"): an exact
+ * term for each edge, plus a term pulling each node towards each pivot,
+ * weighted by the number of nodes the pivot stands for.
+ */
+
+#include "neato.h"
+#include "dijkstra.h"
+#include "bfs.h"
+#include "matrix_ops.h"
+#include "landmark.h"
+#include <math.h>
+#include <stdlib.h>
+
+#ifndef HAVE_DRAND48
+extern double drand48(void);
+#endif
+
+/* choosePivots:
+ * Pick k distinct nodes at random. Unlike max-min selection,
+ * this does not need the distances from the previous pivots,
+ * so the searches from all pivots can run at once.
+ */
+static void choosePivots(int n, int k, int *pivots)
+{
+    int *perm = N_NEW(n, int);
+    int i, j, t;
+
+    for (i = 0; i < n; i++)
+	perm[i] = i;
+    for (i = 0; i < k; i++) {
+	j = i + (int) (drand48() * (n - i)) % (n - i);
+	t = perm[i];
+	perm[i] = perm[j];
+	perm[j] = t;
+	pivots[i] = perm[i];
+    }
+    free(perm);
+}
+
+/* mkComponents:
+ * Label each node with the lowest index of a node in its
+ * connected component.
+ */
+int *mkComponents(vtx_data * graph, int n)
+{
+    int *comp = N_NEW(n, int);
+    int i, j, e, nb;
+    Queue Q;
+
+    for (i = 0; i < n; i++)
+	comp[i] = -1;
+    mkQueue(&Q, n);
+    for (i = 0; i < n; i++) {
+	if (comp[i] >= 0)
+	    continue;
+	comp[i] = i;
+	initQueue(&Q, i);
+	while (deQueue(&Q, &j)) {
+	    for (e = 1; e < graph[j].nedges; e++) {
+		nb = graph[j].edges[e];
+		if (comp[nb] < 0) {
+		    comp[nb] = i;
+		    enQueue(&Q, nb);
+		}
+	    }
+	}
+    }
+    freeQueue(&Q);
+    return comp;
+}
+
+/* pivotDists:
+ * Shortest path distances from vertex. As with bfs, nodes
+ * that cannot be reached, i.e., those in another component,
+ * are placed just beyond the farthest reachable node.
+ */
+static void
+pivotDists(int vertex, vtx_data * graph, int n, int *comp, float *dist,
+	   DistType * idist, Queue * Q)
+{
+    int i;
+    float max = 0;
+
+    if (graph->ewgts) {
+	dijkstra_f(vertex, graph, n, dist);
+	for (i = 0; i < n; i++)
+	    if (comp[i] == comp[vertex] && dist[i] > max)
+		max = dist[i];
+	for (i = 0; i < n; i++)
+	    if (comp[i] != comp[vertex])
+		dist[i] = max + 10;
+    } else {
+	bfs(vertex, graph, n, idist, Q);
+	for (i = 0; i < n; i++)
+	    dist[i] = (float) idist[i];
+    }
+}
+
+static int fcmpf(const void *a, const void *b)
+{
+    float x = *(const float *) a;
+    float y = *(const float *) b;
+    if (x < y)
+	return -1;
+    else if (x > y)
+	return 1;
+    return 0;
+}
+
+/* mkLandmarks:
+ * Compute the distances from k random pivots, in parallel, and the
+ * weights of the sparse stress model. Each node belongs to the region
+ * of its nearest pivot. Node i gets a term towards pivot p, unless it
+ * is p or one of its neighbors, with weight s/d^2, where d is the
+ * distance from i to p and s is the number of nodes in p's region
+ * within d/2 of p.
+ */
+landmark_data *mkLandmarks(vtx_data * graph, int n, int k)
+{
+    landmark_data *ld = NEW(landmark_data);
+    int *region = N_NEW(n, int);
+    int *comp = (graph->ewgts ? mkComponents(graph, n) : NULL);
+    int i, p;
+
+    k = MIN(n, k);
+    ld->n = n;
+    ld->k = k;
+    ld->pivots = N_NEW(k, int);
+    ld->dist = N_NEW(k * n, float);
+    ld->wgt = N_NEW(k * n, float);
+    choosePivots(n, k, ld->pivots);
+
+#pragma omp parallel private(p)
+    {
+	DistType *idist = N_NEW(n, DistType);
+	Queue Q;
+
+	mkQueue(&Q, n);
+#pragma omp for schedule(dynamic)
+	for (p = 0; p < k; p++)
+	    pivotDists(ld->pivots[p], graph, n, comp, ld->dist + p * n,
+		       idist, &Q);
+	free(idist);
+	freeQueue(&Q);
+    }
+
+    for (i = 0; i < n; i++) {
+	region[i] = 0;
+	for (p = 1; p < k; p++)
+	    if (ld->dist[p * n + i] < ld->dist[region[i] * n + i])
+		region[i] = p;
+    }
+
+#pragma omp parallel private(i, p)
+    {
+	float *rdist = N_NEW(n, float);
+	float *dp, *wp, d;
+	size_t nr, lo, hi, mid;
+	int e, piv;
+
+#pragma omp for schedule(dynamic)
+	for (p = 0; p < k; p++) {
+	    dp = ld->dist + p * n;
+	    wp = ld->wgt + p * n;
+	    /* sorted distances from p of the nodes in its region */
+	    for (nr = 0, i = 0; i < n; i++)
+		if (region[i] == p)
+		    rdist[nr++] = dp[i];
+	    qsort(rdist, nr, sizeof(float), fcmpf);
+	    for (i = 0; i < n; i++) {
+		d = dp[i];
+		if (d <= 0) {
+		    wp[i] = 0;
+		    continue;
+		}
+		/* number of region nodes within d/2 of p */
+		lo = 0;
+		hi = nr;
+		while (lo < hi) {
+		    mid = (lo + hi) / 2;
+		    if (rdist[mid] <= d / 2)
+			lo = mid + 1;
+		    else
+			hi = mid;
+		}
+		wp[i] = (float) lo / (d * d);
+	    }
+	    /* neighbors of p are covered by the edge terms */
+	    piv = ld->pivots[p];
+	    for (e = 1; e < graph[piv].nedges; e++)
+		wp[graph[piv].edges[e]] = 0;
+	}
+	free(rdist);
+    }
+
+    free(region);
+    free(comp);
+    return ld;
+}
+
+void freeLandmarks(landmark_data * ld)
+{
+    if (!ld)
+	return;
+    free(ld->pivots);
+    free(ld->dist);
+    free(ld->wgt);
+    free(ld);
+}
+
+/* pivotMDS:
+ * Double-center the matrix C of squared distances to the pivots,
+ * take the top dim eigenvectors v of the k x k matrix C^T C, and
+ * place the nodes at C v. The layout is then scaled to fit the
+ * edge lengths.
+ */
+static void
+pivotMDS(vtx_data * graph, landmark_data * ld, int dim, double **coords)
+{
+    int n = ld->n, k = ld->k;
+    float *C = N_NEW(k * n, float);
+    double *colmean = N_NEW(k, double);
+    double *rowmean = N_NEW(n, double);
+    double **M = N_NEW(k, double *);
+    double **eigs = N_NEW(dim, double *);
+    double *evals = N_NEW(dim, double);
+    double mean = 0, sum, num = 0, den = 0, dist, dx, d, w, scale;
+    int i, j, p, q, e;
+
+    for (p = 0; p < k; p++) {
+	for (i = 0; i < n; i++) {
+	    d = ld->dist[p * n + i];
+	    C[p * n + i] = (float) (d * d);
+	    colmean[p] += d * d;
+	    rowmean[i] += d * d;
+	}
+	mean += colmean[p];
+	colmean[p] /= n;
+    }
+    mean /= ((double) n * k);
+    for (i = 0; i < n; i++)
+	rowmean[i] /= k;
+    for (p = 0; p < k; p++)
+	for (i = 0; i < n; i++)
+	    C[p * n + i] = (float) (-0.5 * (C[p * n + i] - rowmean[i]
+					    - colmean[p] + mean));
+
+    M[0] = N_NEW(k * k, double);
+    for (p = 1; p < k; p++)
+	M[p] = M[0] + p * k;
+#pragma omp parallel for private(q, i, sum) schedule(dynamic)
+    for (p = 0; p < k; p++) {
+	for (q = p; q < k; q++) {
+	    sum = 0;
+	    for (i = 0; i < n; i++)
+		sum += (double) C[p * n + i] * C[q * n + i];
+	    M[p][q] = M[q][p] = sum;
+	}
+    }
+
+    eigs[0] = N_NEW(dim * k, double);
+    for (j = 1; j < dim; j++)
+	eigs[j] = eigs[0] + j * k;
+    power_iteration(M, k, MIN(dim, k), eigs, evals, 1);
+
+#pragma omp parallel for private(j, p, sum) schedule(static)
+    for (i = 0; i < n; i++) {
+	for (j = 0; j < dim; j++) {
+	    sum = 0;
+	    for (p = 0; p < k; p++)
+		sum += C[p * n + i] * eigs[j][p];
+	    coords[j][i] = sum;
+	}
+    }
+
+    /* choose the scale minimizing the stress of the edges */
+    for (i = 0; i < n; i++) {
+	for (e = 1; e < graph[i].nedges; e++) {
+	    j = graph[i].edges[e];
+	    d = (graph[i].ewgts ? graph[i].ewgts[e] : 1);
+	    if (d <= 0)
+		continue;
+	    dist = 0;
+	    for (q = 0; q < dim; q++) {
+		dx = coords[q][i] - coords[q][j];
+		dist += dx * dx;
+	    }
+	    dist = sqrt(dist);
+	    w = 1 / (d * d);
+	    num += w * d * dist;
+	    den += w * dist * dist;
+	}
+    }
+    scale = (den > 0 ? num / den : 1);
+    for (j = 0; j < dim; j++)
+	for (i = 0; i < n; i++)
+	    coords[j][i] = coords[j][i] * scale + 1e-6 * (drand48() - 0.5);
+
+    free(C);
+    free(colmean);
+    free(rowmean);
+    free(M[0]);
+    free(M);
+    free(eigs[0]);
+    free(eigs);
+    free(evals);
+}
+
+int landmarkLayout(vtx_data * graph, landmark_data * ld, int dim,
+		   double **coords, node_t ** nodes)
+{
+    node_t *np;
+    double *pt;
+    int i, d;
+    int pinned = 0;
+
+    pivotMDS(graph, ld, dim, coords);
+    for (i = 0; i < ld->n; i++) {
+	np = nodes[i];
+	if (hasPos(np)) {
+	    pt = ND_pos(np);
+	    for (d = 0; d < dim; d++)
+		coords[d][i] = pt[d];
+	    if (isFixed(np))
+		pinned = 1;
+	}
+    }
+    return pinned;
+}
+
+/* landmarkStress:
+ * Stress over the edge and pivot terms.
+ */
+static double
+landmarkStress(vtx_data * graph, landmark_data * ld, int dim,
+	       double **coords)
+{
+    int n = ld->n;
+    double sum = 0;
+    int i;
+
+#pragma omp parallel for reduction(+:sum) schedule(static)
+    for (i = 0; i < n; i++) {
+	int e, j, p, q;
+	double d, w, dist, dx, r;
+
+	for (e = 1; e < graph[i].nedges; e++) {
+	    j = graph[i].edges[e];
+	    d = (graph[i].ewgts ? graph[i].ewgts[e] : 1);
+	    if (d <= 0)
+		continue;
+	    dist = 0;
+	    for (q = 0; q < dim; q++) {
+		dx = coords[q][i] - coords[q][j];
+		dist += dx * dx;
+	    }
+	    r = sqrt(dist) - d;
+	    sum += r * r / (d * d);
+	}
+	for (p = 0; p < ld->k; p++) {
+	    w = ld->wgt[p * n + i];
+	    if (w <= 0)
+		continue;
+	    j = ld->pivots[p];
+	    d = ld->dist[p * n + i];
+	    dist = 0;
+	    for (q = 0; q < dim; q++) {
+		dx = coords[q][i] - coords[q][j];
+		dist += dx * dx;
+	    }
+	    r = sqrt(dist) - d;
+	    sum += w * r * r;
+	}
+    }
+    return sum;
+}
+
+/* stress_majorization_landmark:
+ * Each iteration moves every node to the weighted average of the
+ * positions its terms ask for, given the old positions of the other
+ * nodes. All nodes are updated from the same old layout, so the
+ * result does not depend on the number of threads.
+ */
+int stress_majorization_landmark(vtx_data * graph, int n, double **coords,
+				 node_t ** nodes, int dim, int maxi)
+{
+    landmark_data *ld;
+    double **newc;
+    boolean *fixed = NULL;
+    double old_stress, new_stress;
+    int i, iterations;
+
+    if (maxi < 0)
+	return 0;
+    if (dim > MAXDIM) {
+	agerr(AGERR, "landmark: dimension %d is larger than %d\n", dim,
+	      MAXDIM);
+	return -1;
+    }
+    if (Verbose) {
+	fprintf(stderr, "Calculating distances from %d pivots",
+		MIN(n, num_landmarks));
+	start_timer();
+    }
+    ld = mkLandmarks(graph, n, num_landmarks);
+    if (Verbose) {
+	fprintf(stderr, ": %.2f sec\n", elapsed_sec());
+	fprintf(stderr, "Setting initial positions");
+	start_timer();
+    }
+    if (landmarkLayout(graph, ld, dim, coords, nodes)) {
+	fixed = N_NEW(n, boolean);
+	for (i = 0; i < n; i++)
+	    fixed[i] = isFixed(nodes[i]);
+    }
+    if (Verbose)
+	fprintf(stderr, ": %.2f sec\n", elapsed_sec());
+    if ((n == 1) || (maxi == 0)) {
+	freeLandmarks(ld);
+	free(fixed);
+	return 0;
+    }
+
+    if (Verbose) {
+	fprintf(stderr, "Solving model: ");
+	start_timer();
+    }
+    newc = N_NEW(dim, double *);
+    newc[0] = N_NEW(dim * n, double);
+    for (i = 1; i < dim; i++)
+	newc[i] = newc[0] + i * n;
+
+    old_stress = landmarkStress(graph, ld, dim, coords);
+    for (iterations = 0; iterations < maxi; iterations++) {
+#pragma omp parallel for schedule(dynamic, 64)
+	for (i = 0; i < n; i++) {
+	    double num[MAXDIM], den = 0, dx[MAXDIM];
+	    double d, w, dist;
+	    int e, j, p, q;
+
+	    if (fixed && fixed[i]) {
+		for (q = 0; q < dim; q++)
+		    newc[q][i] = coords[q][i];
+		continue;
+	    }
+	    for (q = 0; q < dim; q++)
+		num[q] = 0;
+	    for (e = 1; e < graph[i].nedges + ld->k; e++) {
+		if (e < graph[i].nedges) {
+		    j = graph[i].edges[e];
+		    d = (graph[i].ewgts ? graph[i].ewgts[e] : 1);
+		    if (d <= 0)
+			continue;
+		    w = 1 / (d * d);
+		} else {
+		    p = e - graph[i].nedges;
+		    w = ld->wgt[p * n + i];
+		    if (w <= 0)
+			continue;
+		    j = ld->pivots[p];
+		    d = ld->dist[p * n + i];
+		}
+		dist = 0;
+		for (q = 0; q < dim; q++) {
+		    dx[q] = coords[q][i] - coords[q][j];
+		    dist += dx[q] * dx[q];
+		}
+		dist = sqrt(dist);
+		for (q = 0; q < dim; q++) {
+		    num[q] += w * coords[q][j];
+		    if (dist > 0)
+			num[q] += w * d * dx[q] / dist;
+		}
+		den += w;
+	    }
+	    for (q = 0; q < dim; q++)
+		newc[q][i] = (den > 0 ? num[q] / den : coords[q][i]);
+	}
+	for (i = 0; i < dim; i++)
+	    memcpy(coords[i], newc[i], (size_t) n * sizeof(double));
+
+	new_stress = landmarkStress(graph, ld, dim, coords);
+	if (Verbose && (iterations % 10 == 0)) {
+	    fprintf(stderr, "%.3f ", new_stress);
+	    if ((iterations + 10) % 100 == 0)
+		fprintf(stderr, "\n");
+	}
+	if ((fabs(old_stress - new_stress) / old_stress < Epsilon)
+	    || (new_stress < Epsilon)) {
+	    iterations++;
+	    break;
+	}
+	old_stress = new_stress;
+    }
+    if (Verbose) {
+	fprintf(stderr, "\nfinal e = %f %d iterations %.2f sec\n",
+		new_stress, iterations, elapsed_sec());
+    }
+
+    free(newc[0]);
+    free(newc);
+    freeLandmarks(ld);
+    free(fixed);
+    return iterations;
+}
@@ -0,0 +1,65 @@
+/* $Id$ $Revision$ */
+/* vim:set shiftwidth=4 ts=8: */
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: See CVS logs. Details at http://www.graphviz.org/
+ *************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef LANDMARK_H
+#define LANDMARK_H
+
+#include "defs.h"
+
+    /* number of pivots (landmarks) */
+#define num_landmarks 100
+
+    /* Distances from a set of pivots to every node, with the
+     * weights of the sparse stress model. Uses O(k*n) memory.
+     */
+    typedef struct {
+	int n;			/* number of nodes */
+	int k;			/* number of pivots */
+	int *pivots;		/* node index of each pivot */
+	float *dist;		/* dist[p*n+i]: distance of node i from pivot p */
+	float *wgt;		/* wgt[p*n+i]: weight of the term pulling node i
+				 * towards pivot p; 0 if there is no such term */
+    } landmark_data;
+
+    /* comp[i] is the lowest index of a node in the component of node i */
+    extern int *mkComponents(vtx_data * graph, int n);
+
+    extern landmark_data *mkLandmarks(vtx_data * graph, int n, int k);
+    extern void freeLandmarks(landmark_data * ld);
+
+    /* Initial layout by pivot MDS. Nodes with pos set keep it.
+     * Returns true if some node is pinned.
+     */
+    extern int landmarkLayout(vtx_data * graph, landmark_data * ld,
+			      int dim, double **coords, node_t ** nodes);
+
+    /* Sparse stress majorization using edges and pivots only.
+     * Returns the number of iterations, or -1 on error.
+     */
+    extern int stress_majorization_landmark(vtx_data * graph,	/* Input graph in sparse representation */
+					    int n,	/* Number of nodes */
+					    double **coords,	/* coordinates of nodes (output layout)  */
+					    node_t ** nodes,	/* original nodes  */
+					    int dim,	/* dimensionality of layout */
+					    int maxi	/* max iterations */
+	);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -23,11 +23,13 @@
 #define MODEL_CIRCUIT        1
 #define MODEL_SUBSET         2
 #define MODEL_MDS            3
+#define MODEL_LANDMARK       4
 
 #define MODE_KK          0
 #define MODE_MAJOR       1
 #define MODE_HIER        2
 #define MODE_IPSEP       3
+#define MODE_SGD         4
 
 #define INIT_ERROR       -1
 #define INIT_SELF        0
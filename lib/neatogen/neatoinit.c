@@ -25,6 +25,8 @@
 #include "neato.h"
 #include "pack.h"
 #include "stress.h"
+#include "sgd.h"
+#include "landmark.h"
 #ifdef DIGCOLA
 #include "digcola.h"
 #endif
@@ -633,6 +635,8 @@ static int neatoModel(graph_t * g)
 	else if (streq(p, "shortpath"))
 	    return MODEL_SHORTPATH;
     }
+    if ((c == 'l') && streq(p, "landmark"))
+	return MODEL_LANDMARK;
     if ((c == 'm') && streq(p, "mds")) {
 	if (agattr(g, AGEDGE, "len", 0))
 	    return MODEL_MDS;
@@ -662,6 +666,8 @@ static int neatoMode(graph_t * g)
 	    mode = MODE_KK;
 	else if (streq(str, "major"))
 	    mode = MODE_MAJOR;
+	else if (streq(str, "sgd"))
+	    mode = MODE_SGD;
 #ifdef DIGCOLA
 	else if (streq(str, "hier"))
 	    mode = MODE_HIER;
@@ -1120,7 +1126,7 @@ void dumpOpts (ipsep_options* opp, int nv)
  * Solve stress using majorization.
  * Old neato attributes to incorporate:
  *  weight
- * mode will be MODE_MAJOR, MODE_HIER or MODE_IPSEP
+ * mode will be MODE_MAJOR, MODE_SGD, MODE_HIER or MODE_IPSEP
  */
 static void
 majorization(graph_t *mg, graph_t * g, int nv, int mode, int model, int dim, int steps, adjust_data* am)
@@ -1161,6 +1167,11 @@ majorization(graph_t *mg, graph_t * g, int nv, int mode, int model, int dim, int
 	fprintf(stderr, "%d nodes %.2f sec\n", nv, elapsed_sec());
     }
 
+    if (mode == MODE_SGD)
+	rv = sgd(gp, nv, coords, nodes, Ndim, model, MaxIter);
+    else if ((mode == MODE_MAJOR) && (model == MODEL_LANDMARK))
+	rv = stress_majorization_landmark(gp, nv, coords, nodes, Ndim, MaxIter);
+    else
 #ifdef DIGCOLA
     if (mode != MODE_MAJOR) {
         double lgap = late_double(g, agfindgraphattr(g, "levelsgap"), 0.0, -MAXDOUBLE);
@@ -1348,6 +1359,8 @@ neatoLayout(Agraph_t * mg, Agraph_t * g, int layoutMode, int layoutModel,
 	MaxIter = atoi(str);
     else if (layoutMode == MODE_MAJOR)
 	MaxIter = DFLT_ITERATIONS;
+    else if (layoutMode == MODE_SGD)
+	MaxIter = DFLT_SGD_ITERATIONS;
     else
 	MaxIter = 100 * agnnodes(g);
 
@@ -0,0 +1,343 @@
+/* $Id$ $Revision$ */
+/* vim:set shiftwidth=4 ts=8: */
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: See CVS logs. Details at http://www.graphviz.org/
+ *************************************************************************/
+
+/*
+ * Stress minimization by stochastic gradient descent.
+ *
+ * Rather than minimizing the whole stress function at once, each term
+ * w_ij (|p_i - p_j| - d_ij)^2 is taken in turn, in random order, and
+ * p_i and p_j are moved to reduce it, with a step size that decays
+ * exponentially over the iterations (Zheng, Pawar and Goodman,
+ * "Graph Drawing by Stochastic Gradient Descent").
+ *
+ * For small graphs, or models which need the full distance matrix, there
+ * is a term for every pair of nodes. Otherwise, or with the landmark
+ * model, there is an exact term for every edge, plus a term between
+ * every node and each of a set of pivots, weighted by the number of
+ * nodes the pivot stands for, and the initial layout is by pivot MDS
+ * (see landmark.c). This uses O(n + m) memory and time per iteration.
+ */
+
+#include "neato.h"
+#include "dijkstra.h"
+#include "bfs.h"
+#include "stress.h"
+#include "landmark.h"
+#include "sgd.h"
+#include <math.h>
+#include <stdlib.h>
+
+#ifndef HAVE_DRAND48
+extern double drand48(void);
+#endif
+
+/* smallest step, relative to 1/w_max */
+#define SGD_EPS 0.1
+
+typedef struct {
+    int i, j;
+    float d;			/* ideal distance */
+    float wi, wj;		/* weights for moving i and j; 0 if it does not move */
+} term_sgd;
+
+/* sgd_dists:
+ * Shortest path distances from vertex, as float.
+ * Unreachable nodes are left unset by dijkstra_f; bfs
+ * places them just beyond the farthest reachable node.
+ */
+static void
+sgd_dists(int vertex, vtx_data * graph, int n, float *dist,
+	  DistType * idist, Queue * Q)
+{
+    int i;
+
+    if (graph->ewgts)
+	dijkstra_f(vertex, graph, n, dist);
+    else {
+	bfs(vertex, graph, n, idist, Q);
+	for (i = 0; i < n; i++)
+	    dist[i] = (float) idist[i];
+    }
+}
+
+/* dense_terms:
+ * One term for every pair of nodes i < j, using the packed
+ * distance matrix Dij if given, and shortest paths otherwise.
+ * With edge weights, the distances come from dijkstra_f, and
+ * pairs in different components get no term.
+ */
+static term_sgd *dense_terms(vtx_data * graph, int n, float *Dij,
+			     int *nterms)
+{
+    term_sgd *terms = N_NEW(n * (n - 1) / 2, term_sgd);
+    float *Di = NULL;
+    DistType *idist = NULL;
+    Queue Q;
+    int *comp = (graph->ewgts ? mkComponents(graph, n) : NULL);
+    int i, j, count = 0, nt = 0;
+    float d;
+
+    if (!Dij) {
+	Di = N_NEW(n, float);
+	idist = N_NEW(n, DistType);
+	mkQueue(&Q, n);
+    }
+    for (i = 0; i < n; i++) {
+	if (Dij)
+	    count++;		/* skip self distance */
+	else
+	    sgd_dists(i, graph, n, Di, idist, &Q);
+	for (j = i + 1; j < n; j++) {
+	    d = (Dij ? Dij[count++] : Di[j]);
+	    if (d <= 0 || (comp && comp[i] != comp[j]))
+		continue;
+	    terms[nt].i = i;
+	    terms[nt].j = j;
+	    terms[nt].d = d;
+	    terms[nt].wi = terms[nt].wj = 1 / (d * d);
+	    nt++;
+	}
+    }
+    if (!Dij) {
+	free(Di);
+	free(idist);
+	freeQueue(&Q);
+    }
+    free(comp);
+    *nterms = nt;
+    return terms;
+}
+
+/* sparse_terms:
+ * An exact term for each edge, and a one-sided term pulling each
+ * node towards each pivot, with the weights of the sparse stress
+ * model computed by mkLandmarks.
+ */
+static term_sgd *sparse_terms(vtx_data * graph, landmark_data * ld,
+			      int *nterms)
+{
+    int n = ld->n;
+    term_sgd *terms;
+    int i, j, e, p, nt = 0, ne = 0;
+    float d, w;
+
+    for (i = 0; i < n; i++)
+	ne += graph[i].nedges - 1;
+    for (p = 0; p < ld->k * n; p++)
+	if (ld->wgt[p] > 0)
+	    ne++;
+    terms = N_NEW(ne, term_sgd);
+
+    for (i = 0; i < n; i++) {
+	for (e = 1; e < graph[i].nedges; e++) {
+	    j = graph[i].edges[e];
+	    if (j < i)
+		continue;
+	    d = (graph[i].ewgts ? graph[i].ewgts[e] : 1);
+	    if (d <= 0)
+		continue;
+	    terms[nt].i = i;
+	    terms[nt].j = j;
+	    terms[nt].d = d;
+	    terms[nt].wi = terms[nt].wj = 1 / (d * d);
+	    nt++;
+	}
+    }
+    for (p = 0; p < ld->k; p++) {
+	for (i = 0; i < n; i++) {
+	    w = ld->wgt[p * n + i];
+	    if (w <= 0)
+		continue;
+	    terms[nt].i = i;
+	    terms[nt].j = ld->pivots[p];
+	    terms[nt].d = ld->dist[p * n + i];
+	    terms[nt].wi = w;
+	    terms[nt].wj = 0;
+	    nt++;
+	}
+    }
+    *nterms = nt;
+    return terms;
+}
+
+/* sgd_stress:
+ * Stress of the layout, as the weighted sum over the terms.
+ */
+static double sgd_stress(term_sgd * terms, int nterms, double **coords,
+			 int dim)
+{
+    double sum = 0, dist, dx, r;
+    int t, k;
+
+    for (t = 0; t < nterms; t++) {
+	dist = 0;
+	for (k = 0; k < dim; k++) {
+	    dx = coords[k][terms[t].i] - coords[k][terms[t].j];
+	    dist += dx * dx;
+	}
+	r = sqrt(dist) - terms[t].d;
+	sum += MAX(terms[t].wi, terms[t].wj) * r * r;
+    }
+    return sum;
+}
+
+int sgd(vtx_data * graph, int n, double **coords, node_t ** nodes,
+	int dim, int model, int maxi)
+{
+    float *Dij = NULL;
+    term_sgd *terms, tmp;
+    int nterms;
+    int i, j, k, t, iterations;
+    landmark_data *ld = NULL;
+    boolean *fixed = NULL;
+    int havePinned;
+    double wmin, wmax, eta_max, eta_min, lambda, eta;
+    double dx[MAXDIM], mag, r, mu_i, mu_j, delta, delta_max;
+
+    if (maxi < 0)
+	return 0;
+    if (dim > MAXDIM) {
+	agerr(AGERR, "sgd: dimension %d is larger than %d\n", dim, MAXDIM);
+	return -1;
+    }
+
+    if (Verbose) {
+	fprintf(stderr, "Calculating shortest paths");
+	start_timer();
+    }
+
+    if (model == MODEL_SUBSET)
+	Dij = compute_apsp_artifical_weights_packed(graph, n);
+    else if (model == MODEL_CIRCUIT) {
+	Dij = circuitModel(graph, n);
+	if (!Dij) {
+	    agerr(AGWARN,
+		  "graph is disconnected. Hence, the circuit model\n");
+	    agerr(AGPREV,
+		  "is undefined. Reverting to the shortest path model.\n");
+	}
+    } else if (model == MODEL_MDS)
+	Dij = mdsModel(graph, n);
+
+    if ((model == MODEL_LANDMARK) || (!Dij && (n > sgd_sparse_size))) {
+	ld = mkLandmarks(graph, n, num_landmarks);
+	terms = sparse_terms(graph, ld, &nterms);
+    } else
+	terms = dense_terms(graph, n, Dij, &nterms);
+    free(Dij);
+
+    if (Verbose) {
+	fprintf(stderr, ": %d terms %.2f sec\n", nterms, elapsed_sec());
+	fprintf(stderr, "Setting initial positions");
+	start_timer();
+    }
+
+    if (ld) {
+	havePinned = landmarkLayout(graph, ld, dim, coords, nodes);
+	freeLandmarks(ld);
+    } else
+	havePinned = initLayout(graph, n, dim, coords, nodes);
+    if (havePinned) {
+	fixed = N_NEW(n, boolean);
+	for (i = 0; i < n; i++)
+	    fixed[i] = isFixed(nodes[i]);
+    }
+    if ((n == 1) || (maxi == 0) || (nterms == 0)) {
+	free(terms);
+	free(fixed);
+	return 0;
+    }
+
+    /* step sizes decay from 1/w_min to SGD_EPS/w_max */
+    wmin = MAXDOUBLE;
+    wmax = 0;
+    for (t = 0; t < nterms; t++) {
+	if (terms[t].wi > 0) {
+	    wmin = MIN(wmin, terms[t].wi);
+	    wmax = MAX(wmax, terms[t].wi);
+	}
+	if (terms[t].wj > 0) {
+	    wmin = MIN(wmin, terms[t].wj);
+	    wmax = MAX(wmax, terms[t].wj);
+	}
+    }
+    eta_max = 1 / wmin;
+    eta_min = SGD_EPS / wmax;
+    lambda = (maxi > 1 ? log(eta_max / eta_min) / (maxi - 1) : 0);
+
+    if (Verbose) {
+	fprintf(stderr, ": %.2f sec\n", elapsed_sec());
+	fprintf(stderr, "Solving model: ");
+	start_timer();
+    }
+
+    for (iterations = 0; iterations < maxi; iterations++) {
+	eta = eta_max * exp(-lambda * iterations);
+
+	/* visit the terms in random order */
+	for (t = nterms - 1; t > 0; t--) {
+	    j = (int) (drand48() * (t + 1)) % (t + 1);
+	    tmp = terms[t];
+	    terms[t] = terms[j];
+	    terms[j] = tmp;
+	}
+
+	delta_max = 0;
+	for (t = 0; t < nterms; t++) {
+	    i = terms[t].i;
+	    j = terms[t].j;
+	    mag = 0;
+	    for (k = 0; k < dim; k++) {
+		dx[k] = coords[k][i] - coords[k][j];
+		mag += dx[k] * dx[k];
+	    }
+	    mag = sqrt(mag);
+	    if (mag <= 0)
+		continue;
+	    r = (mag - terms[t].d) / (2 * mag);
+	    mu_i = MIN(terms[t].wi * eta, 1);
+	    mu_j = MIN(terms[t].wj * eta, 1);
+	    if (fixed) {
+		if (fixed[i])
+		    mu_i = 0;
+		if (fixed[j])
+		    mu_j = 0;
+	    }
+	    for (k = 0; k < dim; k++) {
+		coords[k][i] -= mu_i * r * dx[k];
+		coords[k][j] += mu_j * r * dx[k];
+	    }
+	    delta = MAX(mu_i, mu_j) * fabs(r) * mag;
+	    if (delta > delta_max)
+		delta_max = delta;
+	}
+	if (Verbose && (iterations % 5 == 0)) {
+	    fprintf(stderr, "%.3f ", sgd_stress(terms, nterms, coords, dim));
+	    if ((iterations + 5) % 50 == 0)
+		fprintf(stderr, "\n");
+	}
+	if (delta_max < Epsilon) {
+	    iterations++;
+	    break;
+	}
+    }
+    if (Verbose) {
+	fprintf(stderr, "\nfinal e = %f %d iterations %.2f sec\n",
+		sgd_stress(terms, nterms, coords, dim), iterations,
+		elapsed_sec());
+    }
+
+    free(terms);
+    free(fixed);
+    return iterations;
+}
@@ -0,0 +1,44 @@
+/* $Id$ $Revision$ */
+/* vim:set shiftwidth=4 ts=8: */
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: See CVS logs. Details at http://www.graphviz.org/
+ *************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SGD_H
+#define SGD_H
+
+#include "defs.h"
+
+#define DFLT_SGD_ITERATIONS 30
+
+    /* graphs with more nodes use the sparse pivot approximation */
+#define sgd_sparse_size 1000
+
+    /* Stress minimization by stochastic gradient descent over pairs
+     * of nodes. Returns the number of iterations, or -1 on error.
+     */
+    extern int sgd(vtx_data * graph,	/* Input graph in sparse representation */
+		   int n,	/* Number of nodes */
+		   double **coords,	/* coordinates of nodes (output layout)  */
+		   node_t ** nodes,	/* original nodes  */
+		   int dim,	/* dimensionality of layout */
+		   int model,	/* model */
+		   int maxi	/* max iterations */
+	);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -707,28 +707,40 @@ finish0:
     return iterations;
 }
 
+/* Offset of row i, holding the distances from i to nodes i..n-1,
+ * in a packed n(n+1)/2 distance matrix.
+ */
+#define packedRow(i,n) ((i)*(n) - (i)*((i)-1)/2)
+
+/* The rows of the packed distance matrices below depend only on their
+ * source node, so they are computed in parallel, each thread with its
+ * own distance vector and queue, writing to disjoint parts of Dij.
+ */
+
 /* compute_weighted_apsp_packed:
  * Edge lengths can be any float > 0
  */
 static float *compute_weighted_apsp_packed(vtx_data * graph, int n)
 {
-    int i, j, count;
+    int i;
     float *Dij = N_NEW(n * (n + 1) / 2, float);
 
-    float *Di = N_NEW(n, float);
-    Queue Q;
+#pragma omp parallel
+    {
+	float *Di = N_NEW(n, float);
+	float *row;
+	int j;
 
-    mkQueue(&Q, n);
-
-    count = 0;
-    for (i = 0; i < n; i++) {
-	dijkstra_f(i, graph, n, Di);
-	for (j = i; j < n; j++) {
-	    Dij[count++] = Di[j];
+#pragma omp for schedule(dynamic, 16)
+	for (i = 0; i < n; i++) {
+	    dijkstra_f(i, graph, n, Di);
+	    row = Dij + packedRow(i, n);
+	    for (j = i; j < n; j++) {
+		*row++ = Di[j];
+	    }
 	}
+	free(Di);
     }
-    free(Di);
-    freeQueue(&Q);
     return Dij;
 }
 
@@ -771,23 +783,28 @@ float *mdsModel(vtx_data * graph, int nG)
  */
 float *compute_apsp_packed(vtx_data * graph, int n)
 {
-    int i, j, count;
+    int i;
     float *Dij = N_NEW(n * (n + 1) / 2, float);
 
-    DistType *Di = N_NEW(n, DistType);
-    Queue Q;
-
-    mkQueue(&Q, n);
+#pragma omp parallel
+    {
+	DistType *Di = N_NEW(n, DistType);
+	float *row;
+	int j;
+	Queue Q;
 
-    count = 0;
-    for (i = 0; i < n; i++) {
-	bfs(i, graph, n, Di, &Q);
-	for (j = i; j < n; j++) {
-	    Dij[count++] = ((float) Di[j]);
+	mkQueue(&Q, n);
+#pragma omp for schedule(dynamic, 16)
+	for (i = 0; i < n; i++) {
+	    bfs(i, graph, n, Di, &Q);
+	    row = Dij + packedRow(i, n);
+	    for (j = i; j < n; j++) {
+		*row++ = ((float) Di[j]);
+	    }
 	}
+	free(Di);
+	freeQueue(&Q);
     }
-    free(Di);
-    freeQueue(&Q);
     return Dij;
 }
 
@@ -26,6 +26,9 @@ static int     PQcnt;
 static snode    guard;
 static int     PQsize;
 
+    /* each thread of the negotiated router has its own queue */
+#pragma omp threadprivate(pq, PQcnt, guard, PQsize)
+
 void
 PQgen(int sz)
 {
@@ -51,6 +54,10 @@ PQinit(void)
   PQcnt = 0;
 }
 
+/* PQcheck:
+ * Verify the heap indices. This is linear in the size of the queue,
+ * so it is only called after each operation when debugging.
+ */
 void
 PQcheck (void)
 {
@@ -91,7 +98,9 @@ PQ_insert(snode* np)
   PQcnt++;
   pq[PQcnt] = np;
   PQupheap (PQcnt);
+#ifdef DEBUG
   PQcheck();
+#endif
   return 0;
 }
 
@@ -132,7 +141,9 @@ PQremove (void)
     pq[1] = pq[PQcnt];
     PQcnt--;
     if (PQcnt) PQdownheap (1);
+#ifdef DEBUG
     PQcheck();
+#endif
     return n;
   }
   else return 0;
@@ -143,7 +154,9 @@ PQupdate (snode* n, int d)
 {
   N_VAL(n) = d;
   PQupheap (n->n_idx);
+#ifdef DEBUG
   PQcheck();
+#endif
 }
 
 void
@@ -97,7 +97,9 @@ PQ_insert(snode* np)
   PQcnt++;
   pq[PQcnt] = np;
   PQupheap (PQcnt);
+#ifdef DEBUG
   PQcheck();
+#endif
   return 0;
 }
 
@@ -138,7 +140,9 @@ PQremove ()
     pq[1] = pq[PQcnt];
     PQcnt--;
     if (PQcnt) PQdownheap (1);
+#ifdef DEBUG
     PQcheck();
+#endif
     return n;
   }
   else return 0;
@@ -149,7 +153,9 @@ PQupdate (snode* n, int d)
 {
   N_VAL(n) = d;
   PQupheap (n->n_idx);
+#ifdef DEBUG
   PQcheck();
+#endif
 }
 
 static void
@@ -191,6 +191,54 @@ updateWts (sgraph* g, cell* cp, sedge* ep)
     }
 }
 
+/* edgeCaps:
+ * Return, for each edge of the search graph, the number of routes it
+ * can carry before updateWts raises its weight.
+ */
+int*
+edgeCaps (maze* mp)
+{
+    sgraph* g = mp->sg;
+    int* caps = N_NEW(g->nedges, int);
+    int i, j, hsz, vsz;
+    cell* cp;
+    sedge* e;
+
+    for (i = 0; i < mp->ncells; i++) {
+	cp = mp->cells+i;
+	hsz = CHANSZ (cp->bb.UR.y - cp->bb.LL.y);
+	vsz = CHANSZ (cp->bb.UR.x - cp->bb.LL.x);
+	for (j = 0; j < cp->nedges; j++) {
+	    e = cp->edges[j];
+	    if (BEND(g,e))
+		caps[e - g->edges] = MIN(hsz, vsz);
+	    else
+		caps[e - g->edges] = (HORZ(g,e)?hsz:vsz);
+	}
+    }
+    return caps;
+}
+
+/* addUse:
+ * Add inc to the use count of each edge in cell cp that updateWts
+ * would charge for a route crossing cp by the edge with index ep.
+ * Edges are identified by their index in g, so ep may come from
+ * a copy of g.
+ */
+void
+addUse (sgraph* g, cell* cp, int ep, int inc, int* use)
+{
+    int i, idx;
+    sedge* e = g->edges + ep;
+    int isBend = BEND(g,e);
+
+    for (i = 0; i < cp->nedges; i++) {
+	idx = cp->edges[i] - g->edges;
+	if (isBend || BEND(g,cp->edges[i]) || (idx == ep))
+	    use[idx] += inc;
+    }
+}
+
 /* markSmall:
  * cp corresponds to a real node. If it is small, its associated cells should
  * be marked as usable.
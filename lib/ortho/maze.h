@@ -56,6 +56,8 @@ typedef struct {
 extern maze* mkMaze (graph_t*, int);
 extern void freeMaze (maze*);
 void updateWts (sgraph* g, cell* cp, sedge* ep);
+extern int* edgeCaps (maze*);
+extern void addUse (sgraph* g, cell* cp, int ep, int inc, int* use);
 #ifdef DEBUG
 extern int odb_flags;
 #define ODB_MAZE    1
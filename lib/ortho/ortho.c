@@ -41,6 +41,20 @@ typedef struct {
     Agedge_t* e;
 } epair_t;
 
+/* A cell crossed by a route, with the edge passed to updateWts for it */
+typedef struct {
+    cell* cp;
+    int e;
+} celluse_t;
+
+/* Cells crossed by a route, used by the negotiated router to add and
+ * remove the route's use of the search graph.
+ */
+typedef struct {
+    int n;
+    celluse_t* u;
+} trail_t;
+
 static jmp_buf jbuf;
 
 #ifdef DEBUG
@@ -136,11 +150,13 @@ setSeg (segment* sp, int dir, double fix, double b1, double b2, int l1, int l2)
  * Note that the shortest path will always have at least 4 nodes:
  * the two dummy nodes representing the center of the two real nodes,
  * and the two nodes on the boundary of the two real nodes.
+ * If tp is NULL, the weights of the cells crossed are updated;
+ * otherwise, the cells are recorded in tp.
  */
 #define PUSH(rte,P) (rte.p[rte.n++] = P)
 
 static route
-convertSPtoRoute (sgraph* g, snode* fst, snode* lst)
+convertSPtoRoute (sgraph* g, snode* fst, snode* lst, trail_t* tp)
 {
     route rte;
     snode* ptr;
@@ -158,6 +174,10 @@ convertSPtoRoute (sgraph* g, snode* fst, snode* lst)
     for (ptr = fst; ptr; ptr = N_DAD(ptr)) sz++;
     rte.n = 0;
     rte.segs = N_NEW(sz-2, segment);  /* at most sz-2 segments */
+    if (tp) {
+	tp->n = 0;
+	tp->u = N_NEW(sz, celluse_t);
+    }
 
     seg.prev = seg.next = 0;
     ptr = prev = N_DAD(fst);
@@ -169,7 +189,13 @@ convertSPtoRoute (sgraph* g, snode* fst, snode* lst)
     bp1 = sidePt (ptr, cp);
     while (N_DAD(next)!=NULL) {
 	ncp = cellOf (prev, next);
-	updateWts (g, ncp, N_EDGE(ptr));
+	if (tp) {
+	    tp->u[tp->n].cp = ncp;
+	    tp->u[tp->n].e = N_EDGE(ptr) - g->edges;
+	    tp->n++;
+	}
+	else
+	    updateWts (g, ncp, N_EDGE(ptr));
 
         /* add seg if path bends or at end */
 	if ((ptr->isVert != next->isVert) || (N_DAD(next) == lst)) {
@@ -450,6 +476,8 @@ assignSegs (int nrtes, route* route_list, maze* mp)
 /* addLoop:
  * Add two temporary nodes to sgraph corresponding to two ends of a loop at cell cp, i
  * represented by dp and sp.
+ * The sides of cp are looked up by index, so sg may be a copy of the
+ * maze's search graph.
  */
 static void
 addLoop (sgraph* sg, cell* cp, snode* dp, snode* sp)
@@ -462,7 +490,7 @@ addLoop (sgraph* sg, cell* cp, snode* dp, snode* sp)
 	cell* ocp;
 	pointf p;
 	double wt;
-	snode* onp = cp->sides[i];
+	snode* onp = sg->nodes + cp->sides[i]->index;
 
 	if (onp->isVert) continue;
 	if (onp->cells[0] == cp) {
@@ -485,7 +513,7 @@ addLoop (sgraph* sg, cell* cp, snode* dp, snode* sp)
 
 /* addNodeEdges:
  * Add temporary node to sgraph corresponding to cell cp, represented
- * by np.
+ * by np. As with addLoop, sg may be a copy of the maze's search graph.
  */
 static void
 addNodeEdges (sgraph* sg, cell* cp, snode* np)
@@ -494,7 +522,7 @@ addNodeEdges (sgraph* sg, cell* cp, snode* np)
     pointf midp = midPt (cp);
 
     for (i = 0; i < cp->nsides; i++) {
-	snode* onp = cp->sides[i];
+	snode* onp = sg->nodes + cp->sides[i]->index;
 	cell* ocp;
 	pointf p;
 	double wt;
@@ -1230,10 +1258,187 @@ static boolean swap_ends_p(edge_t * e)
 
 static splineInfo sinfo = { swap_ends_p, spline_merge, 1, 1 };
 
+/* Negotiated congestion routing, after PathFinder (McMurchie and Ebeling).
+ * Rather than penalizing an edge of the search graph for good once it
+ * fills up, as updateWts does, every route is ripped up and rerouted in
+ * each round. The weight of an edge is its base weight, plus a history
+ * cost that grows each round the edge is over capacity, plus a penalty
+ * for its present overuse that grows with the round. Routes are thus
+ * pushed apart over the rounds, whatever order they are routed in.
+ *
+ * Within a round, edges are routed in batches of ORTHO_BATCH. All edges
+ * in a batch see the same weights, each is routed by one thread on its
+ * own copy of the search graph, and the use of the batch is added in
+ * edge order. The routes therefore do not depend on the number of
+ * threads.
+ */
+#define ORTHO_BATCH 32
+#define OVER_WT 16384           /* penalty per route over capacity */
+#define PRES_FAC 0.5            /* initial factor on OVER_WT ... */
+#define PRES_MULT 1.5           /* ... and its growth per round */
+#define HIST_WT 512             /* history cost per route over capacity */
+#define MAX_WT (16*OVER_WT)     /* keeps path lengths within an int */
+
+/* Every edge can take at least one route; otherwise, the thin cells
+ * between close nodes would count as overused whichever way the routes
+ * go.
+ */
+#define CAP(c) MAX((c), 1)
+
+/* negWt:
+ * Weight of an edge for a route, given the routes already using it.
+ */
+static double
+negWt (double base, double hist, int use, int cap, double pfac)
+{
+    int over = use + 1 - CAP(cap);
+    double wt = base + hist;
+
+    if (over > 0)
+	wt += pfac * OVER_WT * over;
+    return MIN(wt, MAX_WT);
+}
+
+static void
+addTrail (sgraph* sg, trail_t* tp, int inc, int* use)
+{
+    int i;
+
+    for (i = 0; i < tp->n; i++)
+	addUse (sg, tp->u[i].cp, tp->u[i].e, inc, use);
+}
+
+/* negotiateRoutes:
+ * Route the edges of es with at most rounds rounds of negotiated
+ * congestion on nthreads threads, storing in route_list the routes
+ * of the round with the least overuse. Returns non-zero on failure.
+ */
+static int
+negotiateRoutes (maze* mp, int n_edges, epair_t* es, route* route_list,
+		 int rounds, int nthreads)
+{
+    sgraph* sg = mp->sg;
+    int nedges = sg->nedges;
+    int gstart = sg->nnodes;
+    int* caps = edgeCaps (mp);
+    int* use = N_NEW(nedges, int);
+    double* base = N_NEW(nedges, double);
+    double* hist = N_NEW(nedges, double);
+    trail_t* trails = N_NEW(n_edges, trail_t);
+    route* cur = N_NEW(n_edges, route);
+    int i, maxdeg = 0, best = INT_MAX, done = 0, err = 0;
+    double pfac = PRES_FAC;
+
+    for (i = 0; i < mp->ngcells; i++)
+	maxdeg = MAX(maxdeg, mp->gcells[i].nsides);
+    for (i = 0; i < nedges; i++)
+	base[i] = sg->edges[i].weight;
+
+#pragma omp parallel num_threads(nthreads)
+    {
+	sgraph* tg = cloneSGraph (sg, maxdeg);
+	snode* sn = tg->nodes + gstart;
+	snode* dn = tg->nodes + gstart + 1;
+	int rnd, b, last, j, k, over;
+	cell* start;
+	cell* dest;
+	Agedge_t* e;
+
+	PQgen (tg->nnodes+2);
+	for (rnd = 0; (rnd < rounds) && !done && !err; rnd++) {
+	    for (b = 0; (b < n_edges) && !err; b += ORTHO_BATCH) {
+		last = MIN(b + ORTHO_BATCH, n_edges);
+#pragma omp single
+		{
+		    for (j = b; j < last; j++) {
+			addTrail (sg, trails + j, -1, use);
+			free (trails[j].u);
+			trails[j].u = NULL;
+			trails[j].n = 0;
+			free (cur[j].segs);
+			cur[j].segs = NULL;
+		    }
+		    for (k = 0; k < nedges; k++)
+			sg->edges[k].weight = negWt (base[k], hist[k], use[k],
+			    caps[k], pfac);
+		}
+		for (k = 0; k < nedges; k++)
+		    tg->edges[k].weight = sg->edges[k].weight;
+#pragma omp for schedule(dynamic)
+		for (j = b; j < last; j++) {
+		    if (err) continue;
+		    e = es[j].e;
+		    start = CELL(agtail(e));
+		    dest = CELL(aghead(e));
+		    if (start == dest)
+			addLoop (tg, start, dn, sn);
+		    else {
+			addNodeEdges (tg, dest, dn);
+			addNodeEdges (tg, start, sn);
+		    }
+		    if (shortPath (tg, dn, sn)) {
+#pragma omp atomic write
+			err = 1;
+		    }
+		    else
+			cur[j] = convertSPtoRoute (tg, sn, dn, trails + j);
+		    reset (tg);
+		}
+#pragma omp single
+		if (!err)
+		    for (j = b; j < last; j++)
+			addTrail (sg, trails + j, 1, use);
+	    }
+#pragma omp single
+	    if (!err) {
+		for (over = k = 0; k < nedges; k++) {
+		    if (use[k] > CAP(caps[k])) {
+			over += use[k] - CAP(caps[k]);
+			hist[k] += HIST_WT * (use[k] - CAP(caps[k]));
+		    }
+		}
+		pfac *= PRES_MULT;
+		if (Verbose)
+		    fprintf (stderr, "ortho round %d: %d over capacity\n",
+			rnd, over);
+		if (over < best) {
+		    best = over;
+		    for (j = 0; j < n_edges; j++) {
+			free (route_list[j].segs);
+			route_list[j] = cur[j];
+			cur[j].segs = NULL;
+			cur[j].n = 0;
+		    }
+		}
+		if (over == 0)
+		    done = 1;
+	    }
+	}
+	PQfree ();
+	freeSGraph (tg);
+    }
+
+    for (i = 0; i < n_edges; i++) {
+	free (trails[i].u);
+	free (cur[i].segs);
+    }
+    free (trails);
+    free (cur);
+    free (hist);
+    free (base);
+    free (use);
+    free (caps);
+    return err;
+}
+
 /* orthoEdges:
  * For edges without position information, construct an orthogonal routing.
  * If doLbls is true, use edge label info when available to guide routing, 
  * and set label pos for those edges for which this info is not available.
+ * If orthorounds is positive and doLbls is false, the edges are routed
+ * by negotiated congestion; otherwise, they are routed one at a time.
+ * Negotiation searches a route for every edge, including those whose
+ * labels are already placed, so it is not used when doLbls is set.
  */
 void
 orthoEdges (Agraph_t* g, int doLbls)
@@ -1242,7 +1447,7 @@ orthoEdges (Agraph_t* g, int doLbls)
     maze* mp;
     int n_edges;
     route* route_list;
-    int i, gstart;
+    int i, gstart, rounds;
     Agnode_t* n;
     Agedge_t* e;
     snode* sn;
@@ -1321,34 +1526,42 @@ orthoEdges (Agraph_t* g, int doLbls)
 
     qsort((char *)es, n_edges, sizeof(epair_t), (qsort_cmpf) edgecmp);
 
-    gstart = sg->nnodes;
-    PQgen (sg->nnodes+2);
-    sn = &sg->nodes[gstart];
-    dn = &sg->nodes[gstart+1];
-    for (i = 0; i < n_edges; i++) {
+    rounds = late_int(g, agfindgraphattr(g, "orthorounds"), 0, 0);
+    if ((rounds > 0) && !doLbls) {
+	if (negotiateRoutes (mp, n_edges, es, route_list, rounds,
+		late_int(g, agfindgraphattr(g, "threads"), 1, 1)))
+	    goto orthofinish;
+    }
+    else {
+	gstart = sg->nnodes;
+	PQgen (sg->nnodes+2);
+	sn = &sg->nodes[gstart];
+	dn = &sg->nodes[gstart+1];
+	for (i = 0; i < n_edges; i++) {
 #ifdef DEBUG
-	if ((i > 0) && (odb_flags & ODB_IGRAPH)) emitSearchGraph (stderr, sg);
+	    if ((i > 0) && (odb_flags & ODB_IGRAPH)) emitSearchGraph (stderr, sg);
 #endif
-	e = es[i].e;
-        start = CELL(agtail(e));
-        dest = CELL(aghead(e));
+	    e = es[i].e;
+	    start = CELL(agtail(e));
+	    dest = CELL(aghead(e));
 
-	if (doLbls && (lbl = ED_label(e)) && lbl->set) {
-	}
-	else {
-	    if (start == dest)
-		addLoop (sg, start, dn, sn);
+	    if (doLbls && (lbl = ED_label(e)) && lbl->set) {
+	    }
 	    else {
-       		addNodeEdges (sg, dest, dn);
-		addNodeEdges (sg, start, sn);
+		if (start == dest)
+		    addLoop (sg, start, dn, sn);
+		else {
+		    addNodeEdges (sg, dest, dn);
+		    addNodeEdges (sg, start, sn);
+		}
+		if (shortPath (sg, dn, sn)) goto orthofinish;
 	    }
-       	    if (shortPath (sg, dn, sn)) goto orthofinish;
+
+	    route_list[i] = convertSPtoRoute(sg, sn, dn, NULL);
+	    reset (sg);
 	}
-	    
-       	route_list[i] = convertSPtoRoute(sg, sn, dn);
-       	reset (sg);
+	PQfree ();
     }
-    PQfree ();
 
     mp->hchans = extractHChans (mp);
     mp->vchans = extractVChans (mp);
@@ -17,6 +17,7 @@
 #endif
 
 #include <limits.h>
+#include <string.h>
 #include "memory.h"
 #include "sgraph.h"
 #include "fPQ.h"
@@ -99,15 +100,25 @@ gsave (sgraph* G)
 	G->nodes[i].save_n_adj =  G->nodes[i].n_adj;
 }
 
+/* reset:
+ * Remove the temporary nodes and edges added since gsave.
+ * Only the end points of the temporary edges have changed,
+ * so only their adjacency lists are restored.
+ */
 void 
 reset(sgraph* G)
 {
     int i;
+    sedge* e;
+
+    for (i = G->save_nedges; i < G->nedges; i++) {
+	e = G->edges + i;
+	G->nodes[e->v1].n_adj = G->nodes[e->v1].save_n_adj;
+	G->nodes[e->v2].n_adj = G->nodes[e->v2].save_n_adj;
+    }
     G->nnodes = G->save_nnodes;
     G->nedges = G->save_nedges;
-    for (i = 0; i < G->nnodes; i++)
-	G->nodes[i].n_adj = G->nodes[i].save_n_adj;
-    for (; i < G->nnodes+2; i++)
+    for (i = G->nnodes; i < G->nnodes+2; i++)
 	G->nodes[i].n_adj = 0;
 }
 
@@ -127,6 +138,34 @@ initSEdges (sgraph* g, int maxdeg)
     }
 }
 
+/* cloneSGraph:
+ * Copy the core of G, as saved by gsave, with room for the two
+ * temporary nodes of a search, each with up to maxdeg edges.
+ * Searches can then run on the copy while G is used elsewhere.
+ * The nodes still refer to the cells of G's maze.
+ */
+sgraph*
+cloneSGraph (sgraph* G, int maxdeg)
+{
+    sgraph* g = NEW(sgraph);
+    int i;
+
+    *g = *G;
+    g->nodes = N_NEW(G->save_nnodes+2, snode);
+    memcpy (g->nodes, G->nodes, (G->save_nnodes+2)*sizeof(snode));
+    g->nnodes = G->save_nnodes;
+    initSEdges (g, maxdeg);
+    memcpy (g->edges, G->edges, G->save_nedges*sizeof(sedge));
+    g->nedges = G->save_nedges;
+    for (i = 0; i < g->nnodes; i++) {
+	memcpy (g->nodes[i].adj_edge_list, G->nodes[i].adj_edge_list,
+	    G->nodes[i].save_n_adj*sizeof(int));
+	g->nodes[i].n_adj = g->nodes[i].save_n_adj;
+    }
+    g->nodes[g->nnodes].n_adj = g->nodes[g->nnodes+1].n_adj = 0;
+    return g;
+}
+
 sgraph*
 createSGraph (int nnodes)
 {
@@ -200,9 +239,13 @@ freeSGraph (sgraph* g)
  * 
  * The path is given by
  *  to, N_DAD(to), N_DAD(N_DAD(to)), ..., from
+ *
+ * Rather than clearing N_VAL on every node before each search, each
+ * search gets a new number in g->gen. A node whose n_gen differs has
+ * not been seen in this search.
  */
 
-#define UNSEEN INT_MIN
+#define SEEN(g,n) ((n)->n_gen == (g)->gen)
 
 static snode*
 adjacentNode(sgraph* g, sedge* e, snode* n)
@@ -220,18 +263,14 @@ shortPath (sgraph* g, snode* from, snode* to)
     sedge* e;
     snode* adjn;
     int d;
-    int   x, y;
+    int   y;
 
-    for (x = 0; x<g->nnodes; x++) {
-	snode* temp;
-	temp = &(g->nodes[x]);
-	N_VAL(temp) = UNSEEN;
-    }
-    
+    g->gen++;
     PQinit();
     if (PQ_insert (from)) return 1;
     N_DAD(from) = NULL;
     N_VAL(from) = 0;
+    from->n_gen = g->gen;
     
     while ((n = PQremove())) {
 #ifdef DEBUG
@@ -242,13 +281,14 @@ shortPath (sgraph* g, snode* from, snode* to)
 	for (y=0; y<n->n_adj; y++) {
 	    e = &(g->edges[n->adj_edge_list[y]]);
 	    adjn = adjacentNode(g, e, n);
-	    if (N_VAL(adjn) < 0) {
+	    if (!SEEN(g,adjn) || (N_VAL(adjn) < 0)) {
 		d = -(N_VAL(n) + E_WT(e));
-		if (N_VAL(adjn) == UNSEEN) {
+		if (!SEEN(g,adjn)) {
 #ifdef DEBUG
 		    fprintf (stderr, "new %d (%d)\n", adjn->index, -d);
 #endif
 		    N_VAL(adjn) = d;
+		    adjn->n_gen = g->gen;
 		    if (PQ_insert(adjn)) return 1;
 		    N_DAD(adjn) = n;
 		    N_EDGE(adjn) = e;
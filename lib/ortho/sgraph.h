@@ -21,6 +21,7 @@ typedef struct sedge sedge;
 
 struct snode {
   int n_val, n_idx;
+  int n_gen;       /* search in which n_val was last set */
   snode* n_dad;
   sedge* n_edge;
   short   n_adj;
@@ -47,6 +48,7 @@ struct sedge {
 typedef struct {
   int nnodes, nedges;
   int save_nnodes, save_nedges;
+  int gen;         /* number of the current search */
   snode* nodes;
   sedge* edges;
 } sgraph;
@@ -54,6 +56,7 @@ typedef struct {
 extern void reset(sgraph*);
 extern void gsave(sgraph*);
 extern sgraph* createSGraph(int);
+extern sgraph* cloneSGraph(sgraph*, int);
 extern void freeSGraph (sgraph*);
 extern void initSEdges (sgraph* g, int maxdeg);
 extern int shortPath (sgraph* g, snode* from, snode* to);
@@ -320,6 +320,7 @@ tuneControl (graph_t* g, spring_electrical_control ctrl)
 	agerr (AGWARN, "label_scheme = %d > 4 : ignoring\n", ctrl->edge_labeling_scheme);
 	ctrl->edge_labeling_scheme = 0;
     }
+    ctrl->threads = late_int(g, agfindgraphattr(g, "threads"), 1, 1);
 }
 
 void sfdp_layout(graph_t * g)
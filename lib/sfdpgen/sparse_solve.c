@@ -24,6 +24,57 @@
 
 /* #define DEBUG_PRINT */
 
+/* vectors shorter than this are handled by one thread */
+#define CG_PARALLEL_N 20000
+
+/* dot products of longer vectors are summed in blocks of this size, then
+   over the blocks in order, so the result does not depend on the number of threads */
+#define CG_BLOCK 4096
+
+static real cg_dot(int n, real *x, real *y){
+  real res = 0, *part;
+  int b, nb;
+
+  if (n <= CG_PARALLEL_N) return vector_product(n, x, y);
+
+  nb = (n + CG_BLOCK - 1)/CG_BLOCK;
+  part = MALLOC(sizeof(real)*nb);
+#pragma omp parallel for schedule(static)
+  for (b = 0; b < nb; b++){
+    int i, end = MIN(n, (b + 1)*CG_BLOCK);
+    real sum = 0;
+    for (i = b*CG_BLOCK; i < end; i++) sum += x[i]*y[i];
+    part[b] = sum;
+  }
+  for (b = 0; b < nb; b++) res += part[b];
+  FREE(part);
+  return res;
+}
+
+static real* cg_subtract_to(int n, real *x, real *y){
+  /* y = x-y */
+  int i;
+#pragma omp parallel for schedule(static) if (n > CG_PARALLEL_N)
+  for (i = 0; i < n; i++) y[i] = x[i] - y[i];
+  return y;
+}
+
+static real* cg_saxpy(int n, real *x, real *y, real beta){
+  /* y = x+beta*y */
+  int i;
+#pragma omp parallel for schedule(static) if (n > CG_PARALLEL_N)
+  for (i = 0; i < n; i++) y[i] = x[i] + beta*y[i];
+  return y;
+}
+
+static real* cg_saxpy2(int n, real *x, real *y, real beta){
+  /* x = x+beta*y */
+  int i;
+#pragma omp parallel for schedule(static) if (n > CG_PARALLEL_N)
+  for (i = 0; i < n; i++) x[i] = x[i] + beta*y[i];
+  return x;
+}
+
 struct uniform_stress_matmul_data{
   real alpha;
   SparseMatrix A;
@@ -41,11 +92,12 @@ real *Operator_uniform_stress_matmul_apply(Operator o, real *x, real *y){
   real xsum = 0.;
   int m = A->m, i;
 
-  SparseMatrix_multiply_vector(A, x, &y, FALSE);
+  SparseMatrix_csr_multiply_vector(m, A->ia, A->ja, (real*) A->a, x, y);
 
   /* alpha*V*x */
   for (i = 0; i < m; i++) xsum += x[i];
 
+#pragma omp parallel for schedule(static) if (m > CG_PARALLEL_N)
   for (i = 0; i < m; i++) y[i] += alpha*(m*x[i] - xsum);
 
   return y;
@@ -57,6 +109,7 @@ Operator Operator_uniform_stress_matmul(SparseMatrix A, real alpha){
   Operator o;
   struct uniform_stress_matmul_data *d;
 
+  assert(A->format == FORMAT_CSR && A->type == MATRIX_TYPE_REAL);
   o = MALLOC(sizeof(struct Operator_struct));
   o->data = d = MALLOC(sizeof(struct uniform_stress_matmul_data));
   d->alpha = alpha;
@@ -68,13 +121,14 @@ Operator Operator_uniform_stress_matmul(SparseMatrix A, real alpha){
 
 real *Operator_matmul_apply(Operator o, real *x, real *y){
   SparseMatrix A = (SparseMatrix) o->data;
-  SparseMatrix_multiply_vector(A, x, &y, FALSE);
+  SparseMatrix_csr_multiply_vector(A->m, A->ia, A->ja, (real*) A->a, x, y);
   return y;
 }
 
 Operator Operator_matmul_new(SparseMatrix A){
   Operator o;
 
+  assert(A->format == FORMAT_CSR && A->type == MATRIX_TYPE_REAL);
   o = GNEW(struct Operator_struct);
   o->data = (void*) A;
   o->Operator_apply = Operator_matmul_apply;
@@ -92,6 +146,7 @@ real* Operator_diag_precon_apply(Operator o, real *x, real *y){
   real *diag = (real*) o->data;
   m = (int) diag[0];
   diag++;
+#pragma omp parallel for schedule(static) if (m > CG_PARALLEL_N)
   for (i = 0; i < m; i++) y[i] = x[i]*diag[i];
   return y;
 }
@@ -172,9 +227,9 @@ static real conjugate_gradient(Operator A, Operator precon, int n, real *x, real
   q = N_GNEW(n,real);
 
   r = Ax(A, x, r);
-  r = vector_subtract_to(n, rhs, r);
+  r = cg_subtract_to(n, rhs, r);
 
-  res0 = res = sqrt(vector_product(n, r, r))/n;
+  res0 = res = sqrt(cg_dot(n, r, r))/n;
 #ifdef DEBUG_PRINT
     if (Verbose){
       fprintf(stderr, "on entry, cg iter = %d of %d, residual = %g, tol = %g\n", iter, maxit, res, tol);
@@ -183,23 +238,23 @@ static real conjugate_gradient(Operator A, Operator precon, int n, real *x, real
 
   while ((iter++) < maxit && res > tol*res0){
     z = Minvx(precon, r, z);
-    rho = vector_product(n, r, z);
+    rho = cg_dot(n, r, z);
 
     if (iter > 1){
       beta = rho/rho_old;
-      p = vector_saxpy(n, z, p, beta);
+      p = cg_saxpy(n, z, p, beta);
     } else {
       MEMCPY(p, z, sizeof(real)*n);
     }
 
     q = Ax(A, p, q);
 
-    alpha = rho/vector_product(n, p, q);
+    alpha = rho/cg_dot(n, p, q);
 
-    x = vector_saxpy2(n, x, p, alpha);
-    r = vector_saxpy2(n, r, q, -alpha);
+    x = cg_saxpy2(n, x, p, alpha);
+    r = cg_saxpy2(n, r, q, -alpha);
     
-    res = sqrt(vector_product(n, r, r))/n;
+    res = sqrt(cg_dot(n, r, r))/n;
 
 #ifdef DEBUG_PRINT
     if (Verbose && 0){
@@ -69,6 +69,7 @@ spring_electrical_control spring_electrical_control_new(){
   ctrl->initial_scaling = -4;
   ctrl->rotation = 0.;
   ctrl->edge_labeling_scheme = 0;
+  ctrl->threads = 1;
   return ctrl;
 }
 
@@ -469,7 +470,7 @@ void spring_electrical_embedding_fast(int dim, SparseMatrix A0, spring_electrica
   real *f = NULL, dist, F, Fnorm = 0, Fnorm0;
   int iter = 0;
   int adaptive_cooling = ctrl->adaptive_cooling;
-  QuadTree qt = NULL;
+  QuadTreeFlat qt = NULL;
   real counts[4], *force = NULL;
 #ifdef TIME
   clock_t start, end, start0;
@@ -486,6 +487,7 @@ void spring_electrical_embedding_fast(int dim, SparseMatrix A0, spring_electrica
   if (n <= 0 || dim <= 0) return;
 
   qtree_level_optimizer = oned_optimizer_new(max_qtree_level);
+  qt = QuadTreeFlat_new(dim);
 
   *flag = 0;
   if (m != n) {
@@ -542,9 +544,9 @@ void spring_electrical_embedding_fast(int dim, SparseMatrix A0, spring_electrica
     start = clock();
 #endif
     if (ctrl->use_node_weights){
-      qt = QuadTree_new_from_point_list(dim, n, max_qtree_level, x, node_weights);
+      QuadTreeFlat_build(qt, n, max_qtree_level, x, node_weights);
     } else {
-      qt = QuadTree_new_from_point_list(dim, n, max_qtree_level, x, NULL);
+      QuadTreeFlat_build(qt, n, max_qtree_level, x, NULL);
     }
   
 #ifdef TIME
@@ -556,7 +558,7 @@ void spring_electrical_embedding_fast(int dim, SparseMatrix A0, spring_electrica
     start = clock();
 #endif
 
-    QuadTree_get_repulsive_force(qt, force, x, ctrl->bh, p, KP, counts, flag);
+    QuadTreeFlat_get_repulsive_force(qt, force, x, ctrl->bh, p, KP, counts, flag);
 
     assert(!(*flag));
 
@@ -592,15 +594,6 @@ void spring_electrical_embedding_fast(int dim, SparseMatrix A0, spring_electrica
 
 
     if (qt) {
-#ifdef TIME
-      start = clock();
-#endif
-      QuadTree_delete(qt);
-#ifdef TIME
-      end = clock();
-      qtree_new_cpu += ((real) (end - start)) / CLOCKS_PER_SEC;
-#endif
-
 #ifdef TIME
       qtree_cpu0 = qtree_cpu - qtree_cpu0;
       qtree_new_cpu0 = qtree_new_cpu - qtree_new_cpu0;
@@ -652,6 +645,7 @@ void spring_electrical_embedding_fast(int dim, SparseMatrix A0, spring_electrica
   if (xold) FREE(xold);
   if (A != A0) SparseMatrix_delete(A);
   if (force) FREE(force);
+  QuadTreeFlat_delete(qt);
 
 }
 
@@ -918,6 +912,58 @@ void spring_electrical_embedding_slow(int dim, SparseMatrix A0, spring_electrica
 
 
 
+/* qtree_repulsive_force:
+ * Barnes-Hut repulsive force on every node, stored in r[i*dim..i*dim+dim-1].
+ * The force on node i depends only on the tree, which is built once per
+ * iteration, and on x[i] before node i moves, so it can be computed for all
+ * nodes up front. The nodes are split across nthreads threads, each with its
+ * own supernode buffers; every r[i] is summed by a single thread in a fixed
+ * order, and nsuper/counts are integer valued, so the result does not depend
+ * on the number of threads.
+ */
+static void qtree_repulsive_force(QuadTreeFlat qt, int dim, int n, real *x, real bh, real p, real KP,
+				  int nthreads, real *r, real *nsuper_avg, real *counts_avg, int *flag){
+  int i, err = 0;
+  real nsuper_sum = 0, counts_sum = 0;
+
+#pragma omp parallel num_threads(nthreads) reduction(+:nsuper_sum,counts_sum) reduction(|:err)
+  {
+    int j, k, nsuper = 0, nsupermax = 10, lflag = 0;
+    real dist, counts = 0, *f;
+    real *center = MALLOC(sizeof(real)*nsupermax*dim);
+    real *supernode_wgts = MALLOC(sizeof(real)*nsupermax);
+    real *distances = MALLOC(sizeof(real)*nsupermax);
+
+#pragma omp for schedule(dynamic, 64)
+    for (i = 0; i < n; i++){
+      if (lflag) continue;
+      f = &(r[i*dim]);
+      for (k = 0; k < dim; k++) f[k] = 0.;
+      QuadTreeFlat_get_supernodes(qt, bh, &(x[dim*i]), i, &nsuper, &nsupermax,
+			      &center, &supernode_wgts, &distances, &counts, &lflag);
+      counts_sum += counts;
+      nsuper_sum += nsuper;
+      for (j = 0; j < nsuper; j++){
+	dist = MAX(distances[j], MINDIST);
+	for (k = 0; k < dim; k++){
+	  if (p == -1){
+	    f[k] += supernode_wgts[j]*KP*(x[i*dim+k] - center[j*dim+k])/(dist*dist);
+	  } else {
+	    f[k] += supernode_wgts[j]*KP*(x[i*dim+k] - center[j*dim+k])/pow(dist, 1.- p);
+	  }
+	}
+      }
+    }
+    err |= lflag;
+    FREE(center);
+    FREE(supernode_wgts);
+    FREE(distances);
+  }
+  *nsuper_avg += nsuper_sum;
+  *counts_avg += counts_sum;
+  *flag = err;
+}
+
 void spring_electrical_embedding(int dim, SparseMatrix A0, spring_electrical_control ctrl, real *node_weights, real *x, int *flag){
   /* x is a point to a 1D array, x[i*dim+j] gives the coordinate of the i-th node at dimension j.  */
   SparseMatrix A = A0;
@@ -929,10 +975,11 @@ void spring_electrical_embedding(int dim, SparseMatrix A0, spring_electrical_con
   real *f = NULL, dist, F, Fnorm = 0, Fnorm0;
   int iter = 0;
   int adaptive_cooling = ctrl->adaptive_cooling;
-  QuadTree qt = NULL;
+  QuadTreeFlat qt = NULL;
   int USE_QT = FALSE;
   int nsuper = 0, nsupermax = 10;
   real *center = NULL, *supernode_wgts = NULL, *distances = NULL, nsuper_avg, counts = 0, counts_avg = 0;
+  real *rep = NULL;
 #ifdef TIME
   clock_t start, end, start0, start2;
   real qtree_cpu = 0, qtree_cpu0 = 0;
@@ -950,9 +997,11 @@ void spring_electrical_embedding(int dim, SparseMatrix A0, spring_electrical_con
   if (n >= ctrl->quadtree_size) {
     USE_QT = TRUE;
     qtree_level_optimizer = oned_optimizer_new(max_qtree_level);
+    qt = QuadTreeFlat_new(dim);
     center = MALLOC(sizeof(real)*nsupermax*dim);
     supernode_wgts = MALLOC(sizeof(real)*nsupermax);
     distances = MALLOC(sizeof(real)*nsupermax);
+    if (ctrl->threads > 1) rep = MALLOC(sizeof(real)*dim*n);
   }
   *flag = 0;
   if (m != n) {
@@ -1029,9 +1078,9 @@ void spring_electrical_embedding(int dim, SparseMatrix A0, spring_electrical_con
 
       max_qtree_level = oned_optimizer_get(qtree_level_optimizer);
       if (ctrl->use_node_weights){
-	qt = QuadTree_new_from_point_list(dim, n, max_qtree_level, x, node_weights);
+	QuadTreeFlat_build(qt, n, max_qtree_level, x, node_weights);
       } else {
-	qt = QuadTree_new_from_point_list(dim, n, max_qtree_level, x, NULL);
+	QuadTreeFlat_build(qt, n, max_qtree_level, x, NULL);
       }
 
 	  
@@ -1040,6 +1089,18 @@ void spring_electrical_embedding(int dim, SparseMatrix A0, spring_electrical_con
     start2 = clock();
 #endif
 
+    if (rep) {
+#ifdef TIME
+      start = clock();
+#endif
+      qtree_repulsive_force(qt, dim, n, x, ctrl->bh, p, KP, ctrl->threads, rep, &nsuper_avg, &counts_avg, flag);
+#ifdef TIME
+      end = clock();
+      qtree_cpu += ((real) (end - start)) / CLOCKS_PER_SEC;
+#endif
+      if (*flag) goto RETURN;
+    }
+
     for (i = 0; i < n; i++){
       for (k = 0; k < dim; k++) f[k] = 0.;
       /* attractive force   C^((2-p)/3) ||x_i-x_j||/K * (x_j - x_i) */
@@ -1052,11 +1113,13 @@ void spring_electrical_embedding(int dim, SparseMatrix A0, spring_electrical_con
       }
 
       /* repulsive force K^(1 - p)/||x_i-x_j||^(1 - p) (x_i - x_j) */
-      if (USE_QT){
+      if (rep){
+	for (k = 0; k < dim; k++) f[k] += rep[i*dim+k];
+      } else if (USE_QT){
 #ifdef TIME
 	start = clock();
 #endif
-	QuadTree_get_supernodes(qt, ctrl->bh, &(x[dim*i]), i, &nsuper, &nsupermax, 
+	QuadTreeFlat_get_supernodes(qt, ctrl->bh, &(x[dim*i]), i, &nsuper, &nsupermax, 
 				&center, &supernode_wgts, &distances, &counts, flag);
 
 #ifdef TIME
@@ -1117,7 +1180,6 @@ void spring_electrical_embedding(int dim, SparseMatrix A0, spring_electrical_con
     }/* done vertex i */
 
     if (qt) {
-      QuadTree_delete(qt);
       nsuper_avg /= n;
       counts_avg /= n;
 #ifdef TIME
@@ -1185,6 +1247,8 @@ void spring_electrical_embedding(int dim, SparseMatrix A0, spring_electrical_con
   if (center) FREE(center);
   if (supernode_wgts) FREE(supernode_wgts);
   if (distances) FREE(distances);
+  QuadTreeFlat_delete(qt);
+  if (rep) FREE(rep);
 
 }
 
@@ -1259,7 +1323,7 @@ void spring_maxent_embedding(int dim, SparseMatrix A0, SparseMatrix D, spring_el
   real *f = NULL, dist, F, Fnorm = 0, Fnorm0;
   int iter = 0;
   int adaptive_cooling = ctrl->adaptive_cooling;
-  QuadTree qt = NULL;
+  QuadTreeFlat qt = NULL;
   int USE_QT = FALSE;
   int nsuper = 0, nsupermax = 10;
   real *center = NULL, *supernode_wgts = NULL, *distances = NULL, nsuper_avg, counts = 0;
@@ -1274,6 +1338,7 @@ void spring_maxent_embedding(int dim, SparseMatrix A0, SparseMatrix D, spring_el
 
   if (ctrl->tscheme != QUAD_TREE_NONE && n >= ctrl->quadtree_size) {
     USE_QT = TRUE;
+    qt = QuadTreeFlat_new(dim);
     center = MALLOC(sizeof(real)*nsupermax*dim);
     supernode_wgts = MALLOC(sizeof(real)*nsupermax);
     distances = MALLOC(sizeof(real)*nsupermax);
@@ -1347,9 +1412,9 @@ void spring_maxent_embedding(int dim, SparseMatrix A0, SparseMatrix D, spring_el
 
     if (USE_QT) {
       if (ctrl->use_node_weights){
-	qt = QuadTree_new_from_point_list(dim, n, max_qtree_level, x, node_weights);
+	QuadTreeFlat_build(qt, n, max_qtree_level, x, node_weights);
       } else {
-	qt = QuadTree_new_from_point_list(dim, n, max_qtree_level, x, NULL);
+	QuadTreeFlat_build(qt, n, max_qtree_level, x, NULL);
       }
     }
 
@@ -1420,7 +1485,7 @@ void spring_maxent_embedding(int dim, SparseMatrix A0, SparseMatrix D, spring_el
 
       /* repulsive force ||x_i-x_j||^(1 - p) (x_i - x_j) */
       if (USE_QT){
-	QuadTree_get_supernodes(qt, ctrl->bh, &(x[dim*i]), i, &nsuper, &nsupermax, 
+	QuadTreeFlat_get_supernodes(qt, ctrl->bh, &(x[dim*i]), i, &nsuper, &nsupermax, 
 				&center, &supernode_wgts, &distances, &counts, flag);
 	nsuper_avg += nsuper;
 	if (*flag) goto RETURN;
@@ -1474,7 +1539,6 @@ void spring_maxent_embedding(int dim, SparseMatrix A0, SparseMatrix D, spring_el
 
     }/* done vertex i */
 
-    if (qt) QuadTree_delete(qt);
     nsuper_avg /= n;
 #ifdef DEBUG_PRINT
     stress /= (double) A->nz;
@@ -1500,6 +1564,7 @@ void spring_maxent_embedding(int dim, SparseMatrix A0, SparseMatrix D, spring_el
   if (center) FREE(center);
   if (supernode_wgts) FREE(supernode_wgts);
   if (distances) FREE(distances);
+  QuadTreeFlat_delete(qt);
 
 }
 
@@ -1520,7 +1585,7 @@ void spring_electrical_spring_embedding(int dim, SparseMatrix A0, SparseMatrix D
   real *f = NULL, dist, F, Fnorm = 0, Fnorm0;
   int iter = 0;
   int adaptive_cooling = ctrl->adaptive_cooling;
-  QuadTree qt = NULL;
+  QuadTreeFlat qt = NULL;
   int USE_QT = FALSE;
   int nsuper = 0, nsupermax = 10;
   real *center = NULL, *supernode_wgts = NULL, *distances = NULL, nsuper_avg, counts = 0;
@@ -1532,6 +1597,7 @@ void spring_electrical_spring_embedding(int dim, SparseMatrix A0, SparseMatrix D
 
   if (n >= ctrl->quadtree_size) {
     USE_QT = TRUE;
+    qt = QuadTreeFlat_new(dim);
     center = MALLOC(sizeof(real)*nsupermax*dim);
     supernode_wgts = MALLOC(sizeof(real)*nsupermax);
     distances = MALLOC(sizeof(real)*nsupermax);
@@ -1584,9 +1650,9 @@ void spring_electrical_spring_embedding(int dim, SparseMatrix A0, SparseMatrix D
 
     if (USE_QT) {
       if (ctrl->use_node_weights){
-	qt = QuadTree_new_from_point_list(dim, n, max_qtree_level, x, node_weights);
+	QuadTreeFlat_build(qt, n, max_qtree_level, x, node_weights);
       } else {
-	qt = QuadTree_new_from_point_list(dim, n, max_qtree_level, x, NULL);
+	QuadTreeFlat_build(qt, n, max_qtree_level, x, NULL);
       }
     }
 
@@ -1617,7 +1683,7 @@ void spring_electrical_spring_embedding(int dim, SparseMatrix A0, SparseMatrix D
 
       /* repulsive force K^(1 - p)/||x_i-x_j||^(1 - p) (x_i - x_j) */
       if (USE_QT){
-	QuadTree_get_supernodes(qt, ctrl->bh, &(x[dim*i]), i, &nsuper, &nsupermax, 
+	QuadTreeFlat_get_supernodes(qt, ctrl->bh, &(x[dim*i]), i, &nsuper, &nsupermax, 
 				&center, &supernode_wgts, &distances, &counts, flag);
 	nsuper_avg += nsuper;
 	if (*flag) goto RETURN;
@@ -1671,7 +1737,6 @@ void spring_electrical_spring_embedding(int dim, SparseMatrix A0, SparseMatrix D
 
     }/* done vertex i */
 
-    if (qt) QuadTree_delete(qt);
     nsuper_avg /= n;
 #ifdef DEBUG_PRINT
     if (Verbose && 0) {
@@ -1710,6 +1775,7 @@ void spring_electrical_spring_embedding(int dim, SparseMatrix A0, SparseMatrix D
   if (center) FREE(center);
   if (supernode_wgts) FREE(supernode_wgts);
   if (distances) FREE(distances);
+  QuadTreeFlat_delete(qt);
 
 }
 
@@ -63,6 +63,7 @@ struct spring_electrical_control_struct {
 			       0 (no action, default), 1 (penalty based method to make that kind of node close to the center of its neighbor), 
 			       1 (penalty based method to make that kind of node close to the old center of its neighbor),
 			       3 (two step process of overlap removal and straightening) */
+  int threads; /* number of threads for the quadtree repulsive force. 1 (default) computes it serially, node by node */
 };
 
 typedef struct  spring_electrical_control_struct  *spring_electrical_control; 
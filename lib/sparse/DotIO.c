@@ -136,16 +136,15 @@ SparseMatrix_import_dot (Agraph_t* g, int dim, real **label_sizes, real **x, int
 {
   SparseMatrix A = 0;
   Agnode_t* n;
-  Agedge_t* e;
-  Agsym_t *sym, *symD = NULL;
+  Agcsr_t* csr;
   Agsym_t *psym;
   int nnodes;
   int nedges;
-  int i, row;
+  int i;
   int* I;
   int* J;
   real *val, *valD = NULL;
-  real v;
+  double *wt, *len = NULL;
   int type = MATRIX_TYPE_REAL;
   size_t sz = sizeof(real);
   real padding = 10;
@@ -154,33 +153,20 @@ SparseMatrix_import_dot (Agraph_t* g, int dim, real **label_sizes, real **x, int
 
 
   if (!g) return NULL;
-  nnodes = agnnodes (g);
-  nedges = agnedges (g);
   if (format != FORMAT_CSR && format != FORMAT_COORD) {
     fprintf (stderr, "Format %d not supported\n", format);
     exit (1);
   }
+  csr = agcsr (g);
+  nnodes = csr->nnodes;
+  nedges = csr->nedges;
 
   /* Assign node ids */
-  i = 0;
-  for (n = agfstnode (g); n; n = agnxtnode (g, n))
-    ND_id(n) = i++;
-
-  if (format == FORMAT_COORD){
-    A = SparseMatrix_new(i, i, nedges, MATRIX_TYPE_REAL, format);
-    A->nz = nedges;
-    I = A->ia;
-    J = A->ja;
-    val = (real*) A->a;
-  } else {
-    I = N_NEW(nedges, int);
-    J = N_NEW(nedges, int);
-    val = N_NEW(nedges, real);
-  }
-
+  for (i = 0; i < nnodes; i++)
+    ND_id(csr->node[i]) = i;
 
   if (format == FORMAT_COORD){
-    A = SparseMatrix_new(i, i, nedges, MATRIX_TYPE_REAL, format);
+    A = SparseMatrix_new(nnodes, nnodes, nedges, MATRIX_TYPE_REAL, format);
     A->nz = nedges;
     I = A->ia;
     J = A->ja;
@@ -191,42 +177,22 @@ SparseMatrix_import_dot (Agraph_t* g, int dim, real **label_sizes, real **x, int
     val = N_NEW(nedges, real);
   }
 
-  sym = agattr(g, AGEDGE, "weight", NULL);
+  wt = agcsrcol(csr, agattr(g, AGEDGE, "weight", NULL), 1);
   if (D) {
-    symD = agattr(g, AGEDGE, "len", NULL);
+    len = agcsrcol(csr, agattr(g, AGEDGE, "len", NULL), 1);
     valD = N_NEW(nedges, real);
   }
-  i = 0;
-  for (n = agfstnode (g); n; n = agnxtnode (g, n)) {
-    if (edge_label_nodes && strncmp(agnameof(n), "|edgelabel|",11)==0) nedge_nodes++;
-    row = ND_id(n);
-    for (e = agfstout (g, n); e; e = agnxtout (g, e)) {
-      I[i] = row;
-      J[i] = ND_id(aghead(e));
-
-      /* edge weight */
-      if (sym) {
-        if (sscanf (agxget(e,sym), "%lf", &v) != 1) v = 1;
-      } else {
-        v = 1;
-      }
-      val[i] = v;
-
-      /* edge length */
-      if (symD) {
-        if (sscanf (agxget (e, symD), "%lf", &v) != 1) {
-          v = 72;
-        } else {
-          v *= 72;/* len is specified in inch. Convert to points */
-        }
-	valD[i] = v;
-      } else if (valD) {
-        valD[i] = 72;
-      }
-
-      i++;
-    }
+  for (i = 0; i < nedges; i++) {
+    I[i] = csr->tail[i];
+    J[i] = csr->head[i];
+    val[i] = wt[i];
+    if (valD) valD[i] = len[i]*72;/* len is specified in inch. Convert to points */
+  }
+  if (edge_label_nodes) {
+    for (i = 0; i < nnodes; i++)
+      if (strncmp(agnameof(csr->node[i]), "|edgelabel|",11)==0) nedge_nodes++;
   }
+  agcsrfree(csr);
   
   if (edge_label_nodes) {
     *edge_label_nodes = MALLOC(sizeof(int)*nedge_nodes);
@@ -70,7 +70,7 @@ int node_data_get_id(void *d){
 void check_or_realloc_arrays(int dim, int *nsuper, int *nsupermax, real **center, real **supernode_wgts, real **distances){
   
   if (*nsuper >= *nsupermax) {
-    *nsupermax = *nsuper + MAX(10, (int) 0.2*(*nsuper));
+    *nsupermax = *nsuper + MAX(10, (int) (0.2*(*nsuper)));
     *center = REALLOC(*center, sizeof(real)*(*nsupermax)*dim);
     *supernode_wgts = REALLOC(*supernode_wgts, sizeof(real)*(*nsupermax));
     *distances = REALLOC(*distances, sizeof(real)*(*nsupermax));
@@ -730,3 +730,398 @@ void QuadTree_get_nearest(QuadTree qt, real *x, real *ymin, int *imin, real *min
 
 
 }
+
+
+QuadTreeFlat QuadTreeFlat_new(int dim){
+  QuadTreeFlat qt;
+
+  qt = MALLOC(sizeof(struct QuadTreeFlat_struct));
+  qt->dim = dim;
+  qt->max_level = 0;
+  qt->n = 0;
+  qt->nnodes = 0;
+  qt->npts = qt->child = qt->start = NULL;
+  qt->width = qt->total_weight = qt->center = qt->average = qt->force = NULL;
+  qt->id = NULL;
+  qt->weight = qt->coord = NULL;
+  qt->perm = qt->work = NULL;
+  qt->nnodes_max = qt->n_max = 0;
+  return qt;
+}
+
+void QuadTreeFlat_delete(QuadTreeFlat qt){
+  if (!qt) return;
+  FREE(qt->npts);
+  FREE(qt->child);
+  FREE(qt->start);
+  FREE(qt->width);
+  FREE(qt->total_weight);
+  FREE(qt->center);
+  FREE(qt->average);
+  FREE(qt->force);
+  FREE(qt->id);
+  FREE(qt->weight);
+  FREE(qt->coord);
+  FREE(qt->perm);
+  FREE(qt->work);
+  FREE(qt);
+}
+
+static int QuadTreeFlat_new_cells(QuadTreeFlat qt, int k){
+  /* append k consecutive cells, return the index of the first one */
+  int i = qt->nnodes, dim = qt->dim;
+
+  if (qt->nnodes + k > qt->nnodes_max){
+    qt->nnodes_max = MAX(2*qt->nnodes_max, qt->nnodes + k);
+    qt->npts = REALLOC(qt->npts, sizeof(int)*((size_t) qt->nnodes_max));
+    qt->child = REALLOC(qt->child, sizeof(int)*((size_t) qt->nnodes_max));
+    qt->start = REALLOC(qt->start, sizeof(int)*((size_t) qt->nnodes_max));
+    qt->width = REALLOC(qt->width, sizeof(real)*((size_t) qt->nnodes_max));
+    qt->total_weight = REALLOC(qt->total_weight, sizeof(real)*((size_t) qt->nnodes_max));
+    qt->center = REALLOC(qt->center, sizeof(real)*((size_t) qt->nnodes_max)*((size_t) dim));
+    qt->average = REALLOC(qt->average, sizeof(real)*((size_t) qt->nnodes_max)*((size_t) dim));
+    qt->force = REALLOC(qt->force, sizeof(real)*((size_t) qt->nnodes_max)*((size_t) dim));
+  }
+  qt->nnodes += k;
+  return i;
+}
+
+static void QuadTreeFlat_build_internal(QuadTreeFlat qt, int cell, int a, int m, int level, real *coord, real *weight){
+  /* fill in cell, whose center and width are set, from the m points perm[a], ..., perm[a+m-1].
+     The points are in the order in which QuadTree_add_internal would see them, and the weight
+     and average are accumulated in that order with the same arithmetic, so that the
+     result is identical to the pointer based tree. */
+  int dim = qt->dim, nq = 1<<dim, *perm = qt->perm, *work = qt->work;
+  int i, j, k, c, ii;
+  real w, tw, *avg, *ctr;
+
+  qt->npts[cell] = m;
+  qt->child[cell] = -1;
+  qt->start[cell] = a;
+
+  avg = &(qt->average[cell*dim]);
+  i = perm[a];
+  tw = weight ? weight[i] : 1;
+  for (k = 0; k < dim; k++) avg[k] = coord[i*dim+k];
+  for (j = 1; j < m; j++){
+    i = perm[a+j];
+    w = weight ? weight[i] : 1;
+    tw += w;
+    if (level < qt->max_level){
+      for (k = 0; k < dim; k++) avg[k] = (avg[k]*j + coord[i*dim+k])/(j + 1);
+    } else {
+      for (k = 0; k < dim; k++) avg[k] = (avg[k]*(j + 1) + coord[i*dim+k])/(j + 2);
+    }
+  }
+  qt->total_weight[cell] = tw;
+
+  if (m == 1) return;
+
+  if (level >= qt->max_level){
+    /* QuadTree_add_internal prepends to the list of the last level */
+    for (i = a, j = a + m - 1; i < j; i++, j--){
+      ii = perm[i]; perm[i] = perm[j]; perm[j] = ii;
+    }
+    return;
+  }
+
+  /* when a cell splits, its second point reaches the children before its first */
+  ii = perm[a]; perm[a] = perm[a+1]; perm[a+1] = ii;
+
+  c = QuadTreeFlat_new_cells(qt, nq);/* may move the cell arrays */
+  qt->child[cell] = c;
+  for (i = 0; i < nq; i++) qt->npts[c+i] = 0;
+  ctr = &(qt->center[cell*dim]);
+  for (j = a; j < a + m; j++){
+    qt->npts[c+QuadTree_get_quadrant(dim, ctr, &(coord[perm[j]*dim]))]++;
+  }
+
+  /* stable partition of the points by quadrant */
+  for (i = 0, k = a; i < nq; i++){
+    qt->start[c+i] = k;
+    k += qt->npts[c+i];
+  }
+  for (j = a; j < a + m; j++){
+    i = QuadTree_get_quadrant(dim, ctr, &(coord[perm[j]*dim]));
+    work[qt->start[c+i]++] = perm[j];
+  }
+  for (j = a; j < a + m; j++) perm[j] = work[j];
+
+  for (i = 0, k = a; i < nq; i++){
+    /* same arithmetic as QuadTree_new_in_quadrant */
+    qt->width[c+i] = qt->width[cell]/2;
+    for (j = 0, ii = i; j < dim; j++){
+      qt->center[(c+i)*dim+j] = qt->center[cell*dim+j];
+      if (ii%2 == 0){
+	qt->center[(c+i)*dim+j] -= qt->width[c+i];
+      } else {
+	qt->center[(c+i)*dim+j] += qt->width[c+i];
+      }
+      ii = (ii - ii%2)/2;
+    }
+    m = qt->npts[c+i];
+    if (m > 0) {
+      QuadTreeFlat_build_internal(qt, c+i, k, m, level + 1, coord, weight);
+    } else {
+      qt->child[c+i] = -1;
+      qt->start[c+i] = k;
+    }
+    k += m;
+  }
+}
+
+void QuadTreeFlat_build(QuadTreeFlat qt, int n, int max_level, real *coord, real *weight){
+  /* same bounding box as QuadTree_new_from_point_list */
+  int dim = qt->dim, i, j, k;
+  real width;
+
+  qt->n = n;
+  qt->max_level = max_level;
+  qt->nnodes = 0;
+  if (n > qt->n_max){
+    qt->n_max = n;
+    qt->id = REALLOC(qt->id, sizeof(int)*((size_t) n));
+    qt->weight = REALLOC(qt->weight, sizeof(real)*((size_t) n));
+    qt->coord = REALLOC(qt->coord, sizeof(real)*((size_t) n)*((size_t) dim));
+    qt->perm = REALLOC(qt->perm, sizeof(int)*((size_t) n));
+    qt->work = REALLOC(qt->work, sizeof(int)*((size_t) n));
+  }
+  QuadTreeFlat_new_cells(qt, 1);
+  qt->npts[0] = 0;
+  qt->child[0] = -1;
+  qt->start[0] = 0;
+  qt->total_weight[0] = 0;
+  if (n <= 0) return;
+
+  for (k = 0; k < dim; k++){
+    qt->center[k] = qt->average[k] = coord[k];/* xmin and xmax for now */
+  }
+  for (i = 1; i < n; i++){
+    for (k = 0; k < dim; k++){
+      qt->center[k] = MIN(qt->center[k], coord[i*dim+k]);
+      qt->average[k] = MAX(qt->average[k], coord[i*dim+k]);
+    }
+  }
+  width = qt->average[0] - qt->center[0];
+  for (k = 0; k < dim; k++){
+    width = MAX(width, qt->average[k] - qt->center[k]);
+    qt->center[k] = (qt->center[k] + qt->average[k])*0.5;
+  }
+  if (width <= 0) width = 0.00001;/* if we only have one point, width = 0! */
+  width *= 0.52;
+  qt->width[0] = width;
+
+  for (i = 0; i < n; i++) qt->perm[i] = i;
+  QuadTreeFlat_build_internal(qt, 0, 0, n, 0, coord, weight);
+
+  for (j = 0; j < n; j++){
+    i = qt->perm[j];
+    qt->id[j] = i;
+    qt->weight[j] = weight ? weight[i] : 1;
+    for (k = 0; k < dim; k++) qt->coord[j*dim+k] = coord[i*dim+k];
+  }
+}
+
+static void QuadTreeFlat_get_supernodes_internal(QuadTreeFlat qt, int cell, real bh, real *pt, int nodeid, int *nsuper, int *nsupermax, real **center, real **supernode_wgts, real **distances, real *counts){
+  /* the traversal of QuadTree_get_supernodes_internal, with empty cells in place of NULL quadrants */
+  real *coord, dist;
+  int dim = qt->dim, i, j, c;
+
+  (*counts)++;
+
+  if (qt->npts[cell] == 0) return;
+  c = qt->child[cell];
+  if (c < 0){
+    for (j = qt->start[cell]; j < qt->start[cell] + qt->npts[cell]; j++){
+      check_or_realloc_arrays(dim, nsuper, nsupermax, center, supernode_wgts, distances);
+      if (qt->id[j] != nodeid){
+	coord = &(qt->coord[j*dim]);
+	for (i = 0; i < dim; i++){
+	  (*center)[dim*(*nsuper)+i] = coord[i];
+	}
+	(*supernode_wgts)[*nsuper] = qt->weight[j];
+	(*distances)[*nsuper] = point_distance(pt, coord, dim);
+	(*nsuper)++;
+      }
+    }
+    return;
+  }
+
+  dist = point_distance(&(qt->center[cell*dim]), pt, dim); 
+  if (qt->width[cell] < bh*dist){
+    check_or_realloc_arrays(dim, nsuper, nsupermax, center, supernode_wgts, distances);
+    for (i = 0; i < dim; i++){
+      (*center)[dim*(*nsuper)+i] = qt->average[cell*dim+i];
+    }
+    (*supernode_wgts)[*nsuper] = qt->total_weight[cell];
+    (*distances)[*nsuper] = point_distance(&(qt->average[cell*dim]), pt, dim); 
+    (*nsuper)++;
+  } else {
+    for (i = 0; i < 1<<dim; i++){
+      QuadTreeFlat_get_supernodes_internal(qt, c+i, bh, pt, nodeid, nsuper, nsupermax, center, 
+					   supernode_wgts, distances, counts);
+    }
+  }
+}
+
+void QuadTreeFlat_get_supernodes(QuadTreeFlat qt, real bh, real *pt, int nodeid, int *nsuper, 
+				 int *nsupermax, real **center, real **supernode_wgts, real **distances, real *counts, int *flag){
+  /* as QuadTree_get_supernodes. The buffers are kept at their current size *nsupermax
+     from one call to the next. */
+  int dim = qt->dim;
+
+  (*counts) = 0;
+  *nsuper = 0;
+  *flag = 0;
+  if (!*center || !*supernode_wgts || !*distances){
+    *nsupermax = MAX(*nsupermax, 10);
+    *center = REALLOC(*center, sizeof(real)*((size_t) *nsupermax)*((size_t) dim));
+    *supernode_wgts = REALLOC(*supernode_wgts, sizeof(real)*((size_t) *nsupermax));
+    *distances = REALLOC(*distances, sizeof(real)*((size_t) *nsupermax));
+  }
+  QuadTreeFlat_get_supernodes_internal(qt, 0, bh, pt, nodeid, nsuper, nsupermax, center, supernode_wgts, distances, counts);
+}
+
+static void QuadTreeFlat_repulsive_force_interact(QuadTreeFlat qt, int c1, int c2, real *x, real *force, real bh, real p, int square, real KP, real *counts){
+  /* QuadTree_repulsive_force_interact on the flat tree. square is set if p is -1 */
+  real *x1, *x2, dist, wgt1, wgt2, f, *f1, *f2, w1, w2;
+  int dim = qt->dim, i, j, i1, i2, j1, j2, k, l1, l2;
+  int ch1, ch2;
+
+  if (qt->npts[c1] == 0 || qt->npts[c2] == 0) return;
+
+  ch1 = qt->child[c1];
+  ch2 = qt->child[c2];
+  l1 = ch1 < 0;
+  l2 = ch2 < 0;
+
+  /* far enough, calculate repulsive force */
+  dist = point_distance(&(qt->average[c1*dim]), &(qt->average[c2*dim]), dim); 
+  if (qt->width[c1] + qt->width[c2] < bh*dist){
+    counts[0]++;
+    x1 = &(qt->average[c1*dim]);
+    w1 = qt->total_weight[c1];
+    f1 = &(qt->force[c1*dim]);
+    x2 = &(qt->average[c2*dim]);
+    w2 = qt->total_weight[c2];
+    f2 = &(qt->force[c2*dim]);
+    assert(dist > 0);
+    for (k = 0; k < dim; k++){
+      if (square){
+	f = w1*w2*KP*(x1[k] - x2[k])/(dist*dist);
+      } else {
+	f = w1*w2*KP*(x1[k] - x2[k])/pow(dist, 1.- p);
+      }
+      f1[k] += f;
+      f2[k] -= f;
+    }
+    return;
+  }
+
+  /* both at leaves, calculate repulsive force */
+  if (l1 && l2){
+    for (j1 = qt->start[c1]; j1 < qt->start[c1] + qt->npts[c1]; j1++){
+      x1 = &(qt->coord[j1*dim]);
+      wgt1 = qt->weight[j1];
+      i1 = qt->id[j1];
+      f1 = &(force[i1*dim]);
+      for (j2 = qt->start[c2]; j2 < qt->start[c2] + qt->npts[c2]; j2++){
+	x2 = &(qt->coord[j2*dim]);
+	wgt2 = qt->weight[j2];
+	i2 = qt->id[j2];
+	f2 = &(force[i2*dim]);
+	if ((c1 == c2 && i2 < i1) || i1 == i2) continue;
+	counts[1]++;
+	dist = distance_cropped(x, dim, i1, i2);
+	for (k = 0; k < dim; k++){
+	  if (square){
+	    f = wgt1*wgt2*KP*(x1[k] - x2[k])/(dist*dist);
+	  } else {
+	    f = wgt1*wgt2*KP*(x1[k] - x2[k])/pow(dist, 1.- p);
+	  }
+	  f1[k] += f;
+	  f2[k] -= f;
+	}
+      }
+    }
+    return;
+  }
+
+  /* identical, split one */
+  if (c1 == c2){
+    for (i = 0; i < 1<<dim; i++){
+      for (j = i; j < 1<<dim; j++){
+	QuadTreeFlat_repulsive_force_interact(qt, ch1+i, ch1+j, x, force, bh, p, square, KP, counts);
+      }
+    }
+  } else {
+    /* split the one with bigger box, or one not at the last level */
+    if (qt->width[c1] > qt->width[c2] && !l1){
+      for (i = 0; i < 1<<dim; i++){
+	QuadTreeFlat_repulsive_force_interact(qt, ch1+i, c2, x, force, bh, p, square, KP, counts);
+      }
+    } else if (qt->width[c2] > qt->width[c1] && !l2){
+      for (i = 0; i < 1<<dim; i++){
+	QuadTreeFlat_repulsive_force_interact(qt, ch2+i, c1, x, force, bh, p, square, KP, counts);
+      }
+    } else if (!l1){/* pick one that is not at the last level */
+      for (i = 0; i < 1<<dim; i++){
+	QuadTreeFlat_repulsive_force_interact(qt, ch1+i, c2, x, force, bh, p, square, KP, counts);
+      }
+    } else if (!l2){
+      for (i = 0; i < 1<<dim; i++){
+	QuadTreeFlat_repulsive_force_interact(qt, ch2+i, c1, x, force, bh, p, square, KP, counts);
+      }
+    } else {
+      assert(0); /* can't be both at the leaf level since that is caught above */
+    }
+  }
+}
+
+static void QuadTreeFlat_repulsive_force_accumulate(QuadTreeFlat qt, int cell, real *force, real *counts){
+  /* push down forces on cells into the node level */
+  real wgt, wgt2;
+  real *f, *f2;
+  int dim = qt->dim, i, j, k, c, c2;
+
+  wgt = qt->total_weight[cell];
+  f = &(qt->force[cell*dim]);
+  assert(wgt > 0);
+  counts[2]++;
+
+  c = qt->child[cell];
+  if (c < 0){
+    for (j = qt->start[cell]; j < qt->start[cell] + qt->npts[cell]; j++){
+      f2 = &(force[qt->id[j]*dim]);
+      wgt2 = qt->weight[j]/wgt;
+      for (k = 0; k < dim; k++) f2[k] += wgt2*f[k];
+    }
+    return;
+  }
+
+  for (i = 0; i < 1<<dim; i++){
+    c2 = c + i;
+    if (qt->npts[c2] == 0) continue;
+    f2 = &(qt->force[c2*dim]);
+    wgt2 = qt->total_weight[c2]/wgt;
+    for (k = 0; k < dim; k++) f2[k] += wgt2*f[k];
+    QuadTreeFlat_repulsive_force_accumulate(qt, c2, force, counts);
+  }
+}
+
+void QuadTreeFlat_get_repulsive_force(QuadTreeFlat qt, real *force, real *x, real bh, real p, real KP, real *counts, int *flag){
+  /* as QuadTree_get_repulsive_force */
+  int n = qt->n, dim = qt->dim, i;
+  int square = fabs(p + 1) < MACHINEACC;
+
+  for (i = 0; i < 4; i++) counts[i] = 0;
+
+  *flag = 0;
+
+  for (i = 0; i < dim*n; i++) force[i] = 0;
+  for (i = 0; i < dim*qt->nnodes; i++) qt->force[i] = 0;
+
+  QuadTreeFlat_repulsive_force_interact(qt, 0, 0, x, force, bh, p, square, KP, counts);
+  QuadTreeFlat_repulsive_force_accumulate(qt, 0, force, counts);
+  for (i = 0; i < 4; i++) counts[i] /= n;
+}
@@ -61,4 +61,45 @@ void QuadTree_get_nearest(QuadTree qt, real *x, real *ymin, int *imin, real *min
 
 QuadTree QuadTree_new_in_quadrant(int dim, real *center, real width, int max_level, int i);
 
+typedef struct QuadTreeFlat_struct *QuadTreeFlat;
+
+struct QuadTreeFlat_struct {
+  /* the same tree as QuadTree_new_from_point_list builds, stored in flat arrays so that it can be
+     rebuilt every iteration without allocating. Cell 0 is the root. The 2^dim children of a cell
+     are consecutive cells starting at child[i]; a quadrant with no points is a cell with npts = 0.
+     The points are sorted along the tree (Morton order), so the points of a leaf
+     are at positions start[i], ..., start[i] + npts[i] - 1 of the point arrays */
+  int dim;
+  int max_level;
+  int n;/* number of points */
+  int nnodes;/* number of cells */
+  /* cell arrays, of length nnodes, or dim*nnodes for center, average and force */
+  int *npts;/* number of points in the cell */
+  int *child;/* first child, or -1 for a leaf */
+  int *start;/* first point of a leaf */
+  real *width;
+  real *total_weight;
+  real *center;
+  real *average;
+  real *force;/* cell forces, used by QuadTreeFlat_get_repulsive_force */
+  /* point arrays, of length n, or dim*n for coord */
+  int *id;
+  real *weight;
+  real *coord;
+  int *perm, *work;/* work space for the build */
+  int nnodes_max, n_max;/* allocated sizes */
+};
+
+QuadTreeFlat QuadTreeFlat_new(int dim);
+
+void QuadTreeFlat_delete(QuadTreeFlat qt);
+
+/* rebuild qt from the n points in coord, reusing its storage. weight may be NULL for unit weights */
+void QuadTreeFlat_build(QuadTreeFlat qt, int n, int max_level, real *coord, real *weight);
+
+void QuadTreeFlat_get_supernodes(QuadTreeFlat qt, real bh, real *pt, int nodeid, int *nsuper, 
+				 int *nsupermax, real **center, real **supernode_wgts, real **distances, real *counts, int *flag);
+
+void QuadTreeFlat_get_repulsive_force(QuadTreeFlat qt, real *force, real *x, real bh, real p, real KP, real *counts, int *flag);
+
 #endif
@@ -1112,6 +1112,60 @@ static void dense_transpose(real *v, int m, int n){
 }
 
 
+/* matrices with fewer nonzeros are multiplied by one thread */
+#define SPMV_PARALLEL_NZ 20000
+
+void SparseMatrix_csr_multiply_vector(int m, int *ia, int *ja, real *a, real *v, real *u){
+  /* u = A v. Each row is summed in a local accumulator, in the order of its entries,
+     so the inner loop does not store to memory and the result is independent of the threading. */
+  int i;
+
+#pragma omp parallel for schedule(static) if (ia[m] > SPMV_PARALLEL_NZ)
+  for (i = 0; i < m; i++){
+    real s = 0.;
+    int j;
+    for (j = ia[i]; j < ia[i+1]; j++) s += a[j]*v[ja[j]];
+    u[i] = s;
+  }
+}
+
+void SparseMatrix_csr_multiply_dense(int m, int *ia, int *ja, real *a, int dim, real *v, real *u){
+  /* u = A v, with v and u of second dimension dim. */
+  int i;
+
+  if (dim == 1) {
+    SparseMatrix_csr_multiply_vector(m, ia, ja, a, v, u);
+    return;
+  }
+
+  if (dim == 2) {
+#pragma omp parallel for schedule(static) if (ia[m] > SPMV_PARALLEL_NZ)
+    for (i = 0; i < m; i++){
+      real s0 = 0., s1 = 0., *vj;
+      int j;
+      for (j = ia[i]; j < ia[i+1]; j++){
+	vj = &(v[ja[j]*2]);
+	s0 += a[j]*vj[0];
+	s1 += a[j]*vj[1];
+      }
+      u[i*2] = s0;
+      u[i*2+1] = s1;
+    }
+    return;
+  }
+
+#pragma omp parallel for schedule(static) if (ia[m] > SPMV_PARALLEL_NZ/dim)
+  for (i = 0; i < m; i++){
+    real *ui = &(u[i*dim]), *vj;
+    int j, k;
+    for (k = 0; k < dim; k++) ui[k] = 0.;
+    for (j = ia[i]; j < ia[i+1]; j++){
+      vj = &(v[ja[j]*dim]);
+      for (k = 0; k < dim; k++) ui[k] += a[j]*vj[k];
+    }
+  }
+}
+
 static void SparseMatrix_multiply_dense1(SparseMatrix A, real *v, real **res, int dim, int transposed, int res_transposed){
   /* A v or A^T v where v a dense matrix of second dimension dim. Real only for now. */
   int i, j, k, *ia, *ja, n, m;
@@ -1129,12 +1183,7 @@ static void SparseMatrix_multiply_dense1(SparseMatrix A, real *v, real **res, in
 
   if (!transposed){
     if (!u) u = MALLOC(sizeof(real)*((size_t) m)*((size_t) dim));
-    for (i = 0; i < m; i++){
-      for (k = 0; k < dim; k++) u[i*dim+k] = 0.;
-      for (j = ia[i]; j < ia[i+1]; j++){
-	for (k = 0; k < dim; k++) u[i*dim+k] += a[j]*v[ja[j]*dim+k];
-      }
-    }
+    SparseMatrix_csr_multiply_dense(m, ia, ja, a, dim, v, u);
     if (res_transposed) dense_transpose(u, m, dim);
   } else {
     if (!u) u = MALLOC(sizeof(real)*((size_t) n)*((size_t) dim));
@@ -1233,12 +1282,7 @@ void SparseMatrix_multiply_vector(SparseMatrix A, real *v, real **res, int trans
     if (v){
       if (!transposed){
 	if (!u) u = MALLOC(sizeof(real)*((size_t)m));
-	for (i = 0; i < m; i++){
-	  u[i] = 0.;
-	  for (j = ia[i]; j < ia[i+1]; j++){
-	    u[i] += a[j]*v[ja[j]];
-	  }
-	}
+	SparseMatrix_csr_multiply_vector(m, ia, ja, a, v, u);
       } else {
 	if (!u) u = MALLOC(sizeof(real)*((size_t)n));
 	for (i = 0; i < n; i++) u[i] = 0.;
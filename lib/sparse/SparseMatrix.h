@@ -93,6 +93,11 @@ SparseMatrix SparseMatrix_divide_row_by_degree(SparseMatrix A);
 SparseMatrix SparseMatrix_get_real_adjacency_matrix_symmetrized(SparseMatrix A);  /* symmetric, all entries to 1, diaginal removed */
 SparseMatrix SparseMatrix_normalize_to_rowsum1(SparseMatrix A);/* for real only! */
 void SparseMatrix_multiply_dense(SparseMatrix A, int ATranspose, real *v, int vTransposed, real **res, int res_transpose, int dim);
+
+/* real CSR kernels: u = A v, and U = A V with V and U stored row by row with dim columns.
+   Rows are split among threads for large matrices; the result does not depend on the number of threads. */
+void SparseMatrix_csr_multiply_vector(int m, int *ia, int *ja, real *a, real *v, real *u);
+void SparseMatrix_csr_multiply_dense(int m, int *ia, int *ja, real *a, int dim, real *v, real *u);
 SparseMatrix SparseMatrix_apply_fun(SparseMatrix A, double (*fun)(double x));/* for real only! */
 SparseMatrix SparseMatrix_apply_fun_general(SparseMatrix A, void (*fun)(int i, int j, int n, double *x));/* for real and complex (n=2) */
 SparseMatrix SparseMatrix_copy(SparseMatrix A);
@@ -24,15 +24,18 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <math.h>
 
 #include "macros.h"
 #include "const.h"
+#include "xdot.h"
 
 #include "gvplugin_render.h"
 #include "gvplugin_device.h"
 #include "agxbuf.h"
 #include "utils.h"
 #include "gvio.h"
+#include "gvxdot.h"
 
 #define GNEW(t)          (t*)malloc(sizeof(t))
 
@@ -89,9 +92,78 @@ typedef struct {
     unsigned char buf[NUMXBUFS][BUFSIZ];
     unsigned short version;
     char* version_s;
+    boolean ops;
 } xdot_state_t;
 static xdot_state_t* xd;
 
+/* With OUTPUT_DRAW_OPS, operations are recorded as xdot_op's in the
+ * lists below instead of being printed. They are shared among the emit
+ * states in the same way as the xbufs.
+ */
+typedef struct {
+    int cnt;
+    int size;
+    xdot_op* ops;
+} xoplist_t;
+static xoplist_t xop[NUMXBUFS];
+#define XOPS(s) (xop + (xbufs[s] - xbuf))
+
+/* xdot_round:
+ * Round v to 1/scale the way printf does when writing xdot, so that
+ * recorded operations match parsed ones. The residual from fma is exact,
+ * so halfway cases go to even as in printf, and a result of zero keeps
+ * the sign of v as "-0" does.
+ */
+static double xdot_round (double v, double scale)
+{
+    double r = floor(v * scale + 0.5);
+    double e = fma(v, scale, -r);
+
+    if ((e < -0.5) || ((e == -0.5) && (fmod(r, 2) != 0)))
+	r -= 1;
+    else if ((e > 0.5) || ((e == 0.5) && (fmod(r, 2) != 0)))
+	r += 1;
+    if (r == 0)
+	return copysign(0.0, v);
+    return r / scale;
+}
+#define XNUM(v) xdot_round(v, 100)
+
+static xdot_op* xdot_newop (GVJ_t *job, xdot_kind kind)
+{
+    xoplist_t* xl = XOPS(job->obj->emit_state);
+    xdot_op* op;
+
+    if (xl->cnt == xl->size) {
+	xl->size = (xl->size ? 2 * xl->size : 16);
+	xl->ops = realloc(xl->ops, xl->size * sizeof(xdot_op));
+    }
+    op = xl->ops + xl->cnt++;
+    memset(op, 0, sizeof(xdot_op));
+    op->kind = kind;
+    return op;
+}
+
+/* xdot_takeops:
+ * Move the operations in xl into a new xdot, or return NULL if there are none.
+ */
+static xdot* xdot_takeops (xoplist_t* xl)
+{
+    xdot* x;
+
+    if (xl->cnt == 0)
+	return NULL;
+    x = GNEW(xdot);
+    x->cnt = xl->cnt;
+    x->sz = sizeof(xdot_op);
+    x->ops = realloc(xl->ops, xl->cnt * sizeof(xdot_op));
+    x->freefunc = NULL;
+    x->flags = 0;
+    xl->cnt = xl->size = 0;
+    xl->ops = NULL;
+    return x;
+}
+
 static void xdot_str_xbuf (agxbuf* xb, char* pfx, char* s)
 {
     char buf[BUFSIZ];
@@ -146,7 +218,7 @@ static void xdot_fmt_num (char* buf, double v)
     xdot_trim_zeros (buf, 1);
 }
 
-static void xdot_point(agxbuf *xbuf, pointf p)
+static void xdot_fmt_point(agxbuf *xbuf, pointf p)
 {
     char buf[BUFSIZ];
     xdot_fmt_num (buf, p.x);
@@ -168,11 +240,42 @@ static void xdot_points(GVJ_t *job, char c, pointf * A, int n)
     char buf[BUFSIZ];
     int i;
 
+    if (xd->ops) {
+	xdot_kind kind;
+	xdot_polyline* pl;
+
+	switch (c) {
+	case 'b' :
+	    kind = xd_filled_bezier;
+	    break;
+	case 'B' :
+	    kind = xd_unfilled_bezier;
+	    break;
+	case 'P' :
+	    kind = xd_filled_polygon;
+	    break;
+	case 'p' :
+	    kind = xd_unfilled_polygon;
+	    break;
+	default :
+	    kind = xd_polyline;
+	    break;
+	}
+	pl = &xdot_newop(job, kind)->u.polyline;
+	pl->cnt = n;
+	pl->pts = calloc(n, sizeof(xdot_point));
+	for (i = 0; i < n; i++) {
+	    pl->pts[i].x = XNUM(A[i].x);
+	    pl->pts[i].y = XNUM(yDir(A[i].y));
+	}
+	return;
+    }
+
     agxbputc(xbufs[emit_state], c);
     sprintf(buf, " %d ", n);
     agxbput(xbufs[emit_state], buf);
     for (i = 0; i < n; i++)
-        xdot_point(xbufs[emit_state], A[i]);
+        xdot_fmt_point(xbufs[emit_state], A[i]);
 }
 
 static char*
@@ -189,12 +292,28 @@ color2str (unsigned char rgba[4])
 
 static void xdot_pencolor (GVJ_t *job)
 {
-    xdot_str (job, "c ", color2str (job->obj->pencolor.u.rgba));
+    if (xd->ops)
+	xdot_newop(job, xd_pen_color)->u.color =
+	    strdup(color2str (job->obj->pencolor.u.rgba));
+    else
+	xdot_str (job, "c ", color2str (job->obj->pencolor.u.rgba));
 }
 
 static void xdot_fillcolor (GVJ_t *job)
 {
-    xdot_str (job, "C ", color2str (job->obj->fillcolor.u.rgba));
+    if (xd->ops)
+	xdot_newop(job, xd_fill_color)->u.color =
+	    strdup(color2str (job->obj->fillcolor.u.rgba));
+    else
+	xdot_str (job, "C ", color2str (job->obj->fillcolor.u.rgba));
+}
+
+static void xdot_style_str (GVJ_t *job, char* s)
+{
+    if (xd->ops)
+	xdot_newop(job, xd_style)->u.style = strdup(s);
+    else
+	xdot_str (job, "S ", s);
 }
 
 static void xdot_style (GVJ_t *job)
@@ -215,7 +334,7 @@ static void xdot_style (GVJ_t *job)
 	xdot_trim_zeros (buf, 0);
 	agxbput(&xbuf, buf);
 	agxbputc (&xbuf, ')');
-        xdot_str (job, "S ", agxbuse(&xbuf));
+        xdot_style_str (job, agxbuse(&xbuf));
     }
 
     /* now process raw style, if any */
@@ -242,20 +361,45 @@ static void xdot_style (GVJ_t *job)
             }
             agxbputc(&xbuf, ')');
         }
-        xdot_str (job, "S ", agxbuse(&xbuf));
+        xdot_style_str (job, agxbuse(&xbuf));
     }
 
     agxbfree(&xbuf);
 
 }
 
+/* xdot_set:
+ * Store the operations of emit state s in attribute sym of obj or,
+ * with OUTPUT_DRAW_OPS, attach them to obj under the name of sym.
+ * If clear is true, sym is set even when there are no operations.
+ */
+static void xdot_set (void* obj, attrsym_t* sym, emit_state_t s, int clear)
+{
+    xdot* x;
+
+    if (!xd->ops) {
+	if (clear || agxblen(xbufs[s]))
+	    agxset(obj, sym, agxbuse(xbufs[s]));
+    }
+    else if ((x = xdot_takeops(XOPS(s))))
+	gvSetDrawOps(obj, sym->name, x);
+    else if (clear)
+	agxset(obj, sym, "");
+}
+
+static int xdot_empty (emit_state_t s)
+{
+    if (xd->ops)
+	return (XOPS(s)->cnt == 0);
+    else
+	return (agxblen(xbufs[s]) == 0);
+}
+
 static void xdot_end_node(GVJ_t* job)
 {
     Agnode_t* n = job->obj->u.n; 
-    if (agxblen(xbufs[EMIT_NDRAW]))
-	agxset(n, xd->n_draw, agxbuse(xbufs[EMIT_NDRAW]));
-    if (agxblen(xbufs[EMIT_NLABEL]))
-	agxset(n, xd->n_l_draw, agxbuse(xbufs[EMIT_NLABEL]));
+    xdot_set(n, xd->n_draw, EMIT_NDRAW, FALSE);
+    xdot_set(n, xd->n_l_draw, EMIT_NLABEL, FALSE);
     penwidth[EMIT_NDRAW] = 1;
     penwidth[EMIT_NLABEL] = 1;
     textflags[EMIT_NDRAW] = 0;
@@ -266,18 +410,12 @@ static void xdot_end_edge(GVJ_t* job)
 {
     Agedge_t* e = job->obj->u.e; 
 
-    if (agxblen(xbufs[EMIT_EDRAW]))
-	agxset(e, xd->e_draw, agxbuse(xbufs[EMIT_EDRAW]));
-    if (agxblen(xbufs[EMIT_TDRAW]))
-	agxset(e, xd->t_draw, agxbuse(xbufs[EMIT_TDRAW]));
-    if (agxblen(xbufs[EMIT_HDRAW]))
-	agxset(e, xd->h_draw, agxbuse(xbufs[EMIT_HDRAW]));
-    if (agxblen(xbufs[EMIT_ELABEL]))
-	agxset(e, xd->e_l_draw,agxbuse(xbufs[EMIT_ELABEL]));
-    if (agxblen(xbufs[EMIT_TLABEL]))
-	agxset(e, xd->tl_draw, agxbuse(xbufs[EMIT_TLABEL]));
-    if (agxblen(xbufs[EMIT_HLABEL]))
-	agxset(e, xd->hl_draw, agxbuse(xbufs[EMIT_HLABEL]));
+    xdot_set(e, xd->e_draw, EMIT_EDRAW, FALSE);
+    xdot_set(e, xd->t_draw, EMIT_TDRAW, FALSE);
+    xdot_set(e, xd->h_draw, EMIT_HDRAW, FALSE);
+    xdot_set(e, xd->e_l_draw, EMIT_ELABEL, FALSE);
+    xdot_set(e, xd->tl_draw, EMIT_TLABEL, FALSE);
+    xdot_set(e, xd->hl_draw, EMIT_HLABEL, FALSE);
     penwidth[EMIT_EDRAW] = 1;
     penwidth[EMIT_ELABEL] = 1;
     penwidth[EMIT_TDRAW] = 1;
@@ -332,9 +470,9 @@ static void xdot_end_cluster(GVJ_t * job)
 {
     Agraph_t* cluster_g = job->obj->u.sg;
 
-    agxset(cluster_g, xd->g_draw, agxbuse(xbufs[EMIT_CDRAW]));
+    xdot_set(cluster_g, xd->g_draw, EMIT_CDRAW, TRUE);
     if (GD_label(cluster_g))
-	agxset(cluster_g, xd->g_l_draw, agxbuse(xbufs[EMIT_CLABEL]));
+	xdot_set(cluster_g, xd->g_l_draw, EMIT_CLABEL, TRUE);
     penwidth[EMIT_CDRAW] = 1;
     penwidth[EMIT_CLABEL] = 1;
     textflags[EMIT_CDRAW] = 0;
@@ -471,6 +609,7 @@ static void dot_begin_graph(GVJ_t *job)
 	case FORMAT_XDOT14:
 	    attach_attrs_and_arrows(g, &s_arrows, &e_arrows);
 	    xdot_begin_graph(g, s_arrows, e_arrows, job->render.id);
+	    xd->ops = ((job->flags & OUTPUT_DRAW_OPS) != 0);
 	    break;
     }
 }
@@ -478,18 +617,22 @@ static void dot_begin_graph(GVJ_t *job)
 static void xdot_end_graph(graph_t* g)
 {
     int i;
+    xdot* x;
 
-    if (agxblen(xbufs[EMIT_GDRAW])) {
+    if (!xdot_empty(EMIT_GDRAW)) {
 	if (!xd->g_draw)
 	    xd->g_draw = safe_dcl(g, AGRAPH, "_draw_", "");
-	agxset(g, xd->g_draw, agxbuse(xbufs[EMIT_GDRAW]));
+	xdot_set(g, xd->g_draw, EMIT_GDRAW, FALSE);
     }
     if (GD_label(g))
-	agxset(g, xd->g_l_draw, agxbuse(xbufs[EMIT_GLABEL]));
+	xdot_set(g, xd->g_l_draw, EMIT_GLABEL, TRUE);
     agsafeset (g, "xdotversion", xd->version_s, "");
 
-    for (i = 0; i < NUMXBUFS; i++)
+    for (i = 0; i < NUMXBUFS; i++) {
 	agxbfree(xbuf+i);
+	if ((x = xdot_takeops(xop+i)))
+	    freeXDot(x);
+    }
     free (xd);
     penwidth[EMIT_GDRAW] = 1;
     penwidth[EMIT_GLABEL] = 1;
@@ -544,11 +687,19 @@ static void xdot_textspan(GVJ_t * job, pointf p, textspan_t * span)
     int flags;
     char buf[BUFSIZ];
     int j;
+    xdot_op* op;
     
-    agxbput(xbufs[emit_state], "F ");
-    xdot_fmt_num (buf, span->font->size);
-    agxbput(xbufs[emit_state], buf);
-    xdot_str (job, "", span->font->name);
+    if (xd->ops) {
+	op = xdot_newop(job, xd_font);
+	op->u.font.size = XNUM(span->font->size);
+	op->u.font.name = strdup(span->font->name);
+    }
+    else {
+	agxbput(xbufs[emit_state], "F ");
+	xdot_fmt_num (buf, span->font->size);
+	agxbput(xbufs[emit_state], buf);
+	xdot_str (job, "", span->font->name);
+    }
     xdot_pencolor(job);
 
     switch (span->just) {
@@ -571,15 +722,28 @@ static void xdot_textspan(GVJ_t * job, pointf p, textspan_t * span)
 	unsigned int mask = flag_masks[xd->version-15];
 	unsigned int bits = flags & mask;
 	if (textflags[emit_state] != bits) {
-	    sprintf (buf, "t %u ", bits);
-	    agxbput(xbufs[emit_state], buf);
+	    if (xd->ops)
+		xdot_newop(job, xd_fontchar)->u.fontchar = bits;
+	    else {
+		sprintf (buf, "t %u ", bits);
+		agxbput(xbufs[emit_state], buf);
+	    }
 	    textflags[emit_state] = bits;
 	}
     }
 
     p.y += span->yoffset_centerline;
+    if (xd->ops) {
+	op = xdot_newop(job, xd_text);
+	op->u.text.x = XNUM(p.x);
+	op->u.text.y = XNUM(yDir(p.y));
+	op->u.text.align = (j < 0 ? xd_left : (j > 0 ? xd_right : xd_center));
+	op->u.text.width = XNUM(span->size.x);
+	op->u.text.text = strdup(span->str);
+	return;
+    }
     agxbput(xbufs[emit_state], "T ");
-    xdot_point(xbufs[emit_state], p);
+    xdot_fmt_point(xbufs[emit_state], p);
     sprintf(buf, "%d ", j);
     agxbput(xbufs[emit_state], buf);
     xdot_fmt_num (buf, span->size.x);
@@ -587,7 +751,7 @@ static void xdot_textspan(GVJ_t * job, pointf p, textspan_t * span)
     xdot_str (job, "", span->str);
 }
 
-static void xdot_color_stop (agxbuf* xb, float v, gvcolor_t* clr)
+static void xdot_fmt_stop (agxbuf* xb, float v, gvcolor_t* clr)
 {
     char buf[BUFSIZ];
 
@@ -596,13 +760,49 @@ static void xdot_color_stop (agxbuf* xb, float v, gvcolor_t* clr)
     xdot_str_xbuf (xb, buf, color2str (clr->u.rgba));
 }
 
+/* xdot_gradient_op:
+ * Record the gradient fill color built by xdot_gradient_fillcolor.
+ */
+static void xdot_gradient_op (GVJ_t* job, int filled, pointf* G, pointf c1,
+    float r1, pointf c2, float r2, float f0, float f1)
+{
+    obj_state_t* obj = job->obj;
+    xdot_color* clr = &xdot_newop(job, xd_grad_fill_color)->u.grad_color;
+    xdot_color_stop* stops = calloc(2, sizeof(xdot_color_stop));
+
+    stops[0].frac = (float)xdot_round(f0, 1000);
+    stops[0].color = strdup(color2str (obj->fillcolor.u.rgba));
+    stops[1].frac = (float)xdot_round(f1, 1000);
+    stops[1].color = strdup(color2str (obj->stopcolor.u.rgba));
+    if (filled == GRADIENT) {
+	clr->type = xd_linear;
+	clr->u.ling.x0 = XNUM(G[0].x);
+	clr->u.ling.y0 = XNUM(yDir(G[0].y));
+	clr->u.ling.x1 = XNUM(G[1].x);
+	clr->u.ling.y1 = XNUM(yDir(G[1].y));
+	clr->u.ling.n_stops = 2;
+	clr->u.ling.stops = stops;
+    }
+    else {
+	clr->type = xd_radial;
+	clr->u.ring.x0 = XNUM(c1.x);
+	clr->u.ring.y0 = XNUM(yDir(c1.y));
+	clr->u.ring.r0 = XNUM(r1);
+	clr->u.ring.x1 = XNUM(c2.x);
+	clr->u.ring.y1 = XNUM(yDir(c2.y));
+	clr->u.ring.r1 = XNUM(r2);
+	clr->u.ring.n_stops = 2;
+	clr->u.ring.stops = stops;
+    }
+}
+
 static void xdot_gradient_fillcolor (GVJ_t* job, int filled, pointf* A, int n)
 {
     unsigned char buf0[BUFSIZ];
     agxbuf xbuf;
     obj_state_t* obj = job->obj;
     float angle = obj->gradient_angle * M_PI / 180;
-    float r1,r2;
+    float r1,r2,f0,f1;
     pointf G[2],c1,c2;
 
     if (xd->version < 14) {
@@ -610,12 +810,8 @@ static void xdot_gradient_fillcolor (GVJ_t* job, int filled, pointf* A, int n)
 	return;
     }
 
-    agxbinit(&xbuf, BUFSIZ, buf0);
     if (filled == GRADIENT) {
 	get_gradient_points(A, G, n, angle, 2);
-	agxbputc (&xbuf, '[');
-	xdot_point (&xbuf, G[0]);
-	xdot_point (&xbuf, G[1]);
     }
     else {
 	get_gradient_points(A, G, n, 0, 3);
@@ -633,22 +829,35 @@ static void xdot_gradient_fillcolor (GVJ_t* job, int filled, pointf* A, int n)
 	c2.x = G[0].x;
 	c2.y = G[0].y;
 	r1 = r2/4;
+    }
+    if (obj->gradient_frac > 0)
+	f0 = f1 = obj->gradient_frac;
+    else {
+	f0 = 0;
+	f1 = 1;
+    }
+    if (xd->ops) {
+	xdot_gradient_op (job, filled, G, c1, r1, c2, r2, f0, f1);
+	return;
+    }
+
+    agxbinit(&xbuf, BUFSIZ, buf0);
+    if (filled == GRADIENT) {
+	agxbputc (&xbuf, '[');
+	xdot_fmt_point (&xbuf, G[0]);
+	xdot_fmt_point (&xbuf, G[1]);
+    }
+    else {
 	agxbputc(&xbuf, '(');
-	xdot_point (&xbuf, c1);
+	xdot_fmt_point (&xbuf, c1);
 	xdot_num (&xbuf, r1);
-	xdot_point (&xbuf, c2);
+	xdot_fmt_point (&xbuf, c2);
 	xdot_num (&xbuf, r2);
     }
     
     agxbput(&xbuf, "2 ");
-    if (obj->gradient_frac > 0) {
-	xdot_color_stop (&xbuf, obj->gradient_frac, &obj->fillcolor);
-	xdot_color_stop (&xbuf, obj->gradient_frac, &obj->stopcolor);
-    }
-    else {
-	xdot_color_stop (&xbuf, 0, &obj->fillcolor);
-	xdot_color_stop (&xbuf, 1, &obj->stopcolor);
-    }
+    xdot_fmt_stop (&xbuf, f0, &obj->fillcolor);
+    xdot_fmt_stop (&xbuf, f1, &obj->stopcolor);
     agxbpop(&xbuf);
     if (filled == GRADIENT)
 	agxbputc(&xbuf, ']');
@@ -658,11 +867,20 @@ static void xdot_gradient_fillcolor (GVJ_t* job, int filled, pointf* A, int n)
     agxbfree(&xbuf);
 }
 
+static void xdot_op_rect(xdot_rect* r, pointf p, double w, double h)
+{
+    r->x = XNUM(p.x);
+    r->y = XNUM(yDir(p.y));
+    r->w = XNUM(w);
+    r->h = XNUM(h);
+}
+
 static void xdot_ellipse(GVJ_t * job, pointf * A, int filled)
 {
     emit_state_t emit_state = job->obj->emit_state;
 
     char buf[BUFSIZ];
+    xdot_op* op;
 
     xdot_style (job);
     xdot_pencolor (job);
@@ -672,11 +890,17 @@ static void xdot_ellipse(GVJ_t * job, pointf * A, int filled)
 	}
         else 
 	    xdot_fillcolor (job);
-        agxbput(xbufs[emit_state], "E ");
     }
+    if (xd->ops) {
+	op = xdot_newop(job, (filled ? xd_filled_ellipse : xd_unfilled_ellipse));
+	xdot_op_rect(&op->u.ellipse, A[0], A[1].x - A[0].x, A[1].y - A[0].y);
+	return;
+    }
+    if (filled)
+        agxbput(xbufs[emit_state], "E ");
     else
         agxbput(xbufs[emit_state], "e ");
-    xdot_point(xbufs[emit_state], A[0]);
+    xdot_fmt_point(xbufs[emit_state], A[0]);
     xdot_fmt_num (buf, A[1].x - A[0].x);
     agxbput(xbufs[emit_state], buf);
     xdot_fmt_num (buf, A[1].y - A[0].y);
@@ -715,7 +939,7 @@ static void xdot_polygon(GVJ_t * job, pointf * A, int n, int filled)
         xdot_points(job, 'p', A, n);
 }
 
-static void xdot_polyline(GVJ_t * job, pointf * A, int n)
+static void xdot_poly_line(GVJ_t * job, pointf * A, int n)
 {
     xdot_style (job);
     xdot_pencolor (job);
@@ -726,9 +950,16 @@ void core_loadimage_xdot(GVJ_t * job, usershape_t *us, boxf b, boolean filled)
 {
     emit_state_t emit_state = job->obj->emit_state;
     char buf[BUFSIZ];
+    xdot_op* op;
     
+    if (xd->ops) {
+	op = xdot_newop(job, xd_image);
+	xdot_op_rect(&op->u.image.pos, b.LL, b.UR.x - b.LL.x, b.UR.y - b.LL.y);
+	op->u.image.name = strdup(us->name);
+	return;
+    }
     agxbput(xbufs[emit_state], "I ");
-    xdot_point(xbufs[emit_state], b.LL);
+    xdot_fmt_point(xbufs[emit_state], b.LL);
     xdot_fmt_num (buf, b.UR.x - b.LL.x);
     agxbput(xbufs[emit_state], buf);
     xdot_fmt_num (buf, b.UR.y - b.LL.y);
@@ -802,13 +1033,14 @@ gvrender_engine_t xdot_engine = {
     xdot_ellipse,
     xdot_polygon,
     xdot_bezier,
-    xdot_polyline,
+    xdot_poly_line,
     0,				/* xdot_comment */
     0,				/* xdot_library_shape */
 };
 
 gvrender_features_t render_features_dot = {
-    GVRENDER_DOES_TRANSFORM,	/* not really - uses raw graph coords */  /* flags */
+    GVRENDER_DOES_TRANSFORM	/* not really - uses raw graph coords */
+	| GVRENDER_MODIFIES_GRAPH, /* flags */
     0.,                         /* default pad - graph units */
     NULL,			/* knowncolors */
     0,				/* sizeof knowncolors */
@@ -819,7 +1051,8 @@ gvrender_features_t render_features_xdot = {
     GVRENDER_DOES_TRANSFORM 	/* not really - uses raw graph coords */  
 	| GVRENDER_DOES_MAPS
 	| GVRENDER_DOES_TARGETS
-	| GVRENDER_DOES_TOOLTIPS, /* flags */
+	| GVRENDER_DOES_TOOLTIPS
+	| GVRENDER_MODIFIES_GRAPH, /* flags */
     0.,                         /* default pad - graph units */
     NULL,			/* knowncolors */
     0,				/* sizeof knowncolors */
@@ -30,6 +30,7 @@
 #include "xdot.h"
 
 #include "gvplugin_render.h"
+#include "gvxdot.h"
 #include "gvplugin_device.h"
 #include "agxbuf.h"
 #include "utils.h"
@@ -68,7 +69,7 @@ static void json_begin_graph(GVJ_t *job)
     if (job->render.id == FORMAT_JSON) {
 	GVC_t* gvc = gvCloneGVC (job->gvc); 
 	graph_t *g = job->obj->u.g;
-	gvRender (gvc, g, "xdot", NULL); 
+	gvRenderOps (gvc, g);
 	gvFreeCloneGVC (gvc);
     }
     else if (job->render.id == FORMAT_JSON0) {
@@ -311,20 +312,11 @@ static void write_xdot (xdot_op * op, GVJ_t * job, state_t* sp)
     gvputs(job, "}");
 }
 
-static void write_xdots (char * val, GVJ_t * job, state_t* sp)
+static void write_xdot_ops (xdot* cmds, GVJ_t * job, state_t* sp)
 {
-    xdot* cmds;
     int i;
     int not_first = 0;
 
-    if (!val || (*val == '\0')) return;
-
-    cmds = parseXDot(val);
-    if (!cmds) {
-	agerr(AGWARN, "Could not parse xdot \"%s\"\n", val);
-	return;
-    }
-
     gvputs(job, "\n");
     indent(job, sp->Level++);
     gvputs(job, "[\n");
@@ -339,6 +331,20 @@ static void write_xdots (char * val, GVJ_t * job, state_t* sp)
     gvputs(job, "\n");
     indent(job, sp->Level);
     gvputs(job, "]");
+}
+
+static void write_xdots (char * val, GVJ_t * job, state_t* sp)
+{
+    xdot* cmds;
+
+    if (!val || (*val == '\0')) return;
+
+    cmds = parseXDot(val);
+    if (!cmds) {
+	agerr(AGWARN, "Could not parse xdot \"%s\"\n", val);
+	return;
+    }
+    write_xdot_ops (cmds, job, sp);
     freeXDot(cmds);
 }
 
@@ -355,16 +361,24 @@ static void write_attrs(Agobj_t * obj, GVJ_t * job, state_t* sp)
     Agraph_t* g = agroot(obj);
     int type = AGTYPE(obj);
     char* attrval;
+    xdot* ops;
     Agsym_t* sym = agnxtattr(g, type, NULL);
     if (!sym) return;
 
     for (; sym; sym = agnxtattr(g, type, sym)) {
 	if (!(attrval = agxget(obj, sym))) continue;
-	if ((*attrval == '\0') && !streq(sym->name, "label")) continue;
+	/* operations recorded by gvRenderOps take the place of the string */
+	if (sp->doXDot && isXDot(sym->name))
+	    ops = gvDrawOps(obj, sym->name);
+	else
+	    ops = NULL;
+	if (!ops && (*attrval == '\0') && !streq(sym->name, "label")) continue;
 	gvputs(job, ",\n");
 	indent(job, sp->Level);
 	gvprintf(job, "\"%s\": ", stoj(sym->name, sp));
-	if (sp->doXDot && isXDot(sym->name))
+	if (ops)
+	    write_xdot_ops(ops, job, sp);
+	else if (sp->doXDot && isXDot(sym->name))
 	    write_xdots(agxget(obj, sym), job, sp);
 	else
 	    gvprintf(job, "\"%s\"", stoj(agxget(obj, sym), sp));
@@ -738,6 +752,7 @@ static void json_end_graph(GVJ_t *job)
     sp.Attrs_not_written_flag = 0;
     write_graph(g, job, TRUE, &sp);
     /* agwrite(g, (FILE*)job); */
+    gvFreeDrawOps(g);
 }
 
 gvrender_engine_t json_engine = {
@@ -785,7 +800,8 @@ gvrender_features_t render_features_json = {
     GVRENDER_DOES_TRANSFORM	/* not really - uses raw graph coords */
 	| GVRENDER_DOES_MAPS
 	| GVRENDER_DOES_TARGETS
-	| GVRENDER_DOES_TOOLTIPS, /* flags */
+	| GVRENDER_DOES_TOOLTIPS
+	| GVRENDER_MODIFIES_GRAPH, /* flags */
     0.,                         /* default pad - graph units */
     NULL,			/* knowncolors */
     0,				/* sizeof knowncolors */
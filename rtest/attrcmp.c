@@ -0,0 +1,360 @@
+/* $Id$ $Revision$ */
+/* vim:set shiftwidth=4 ts=8: */
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: See CVS logs. Details at http://www.graphviz.org/
+ *************************************************************************/
+
+/*
+ * attrcmp file ...
+ *
+ * Checks that a graph opened with desc.attrcols, which stores its
+ * string attributes by column, holds the same values as one stored by
+ * object. Each graph read from the files is copied into a graph with
+ * columns, declaring the node and edge attributes only once the nodes
+ * and edges exist, so they are not visited. Its subgraphs are copied
+ * with their objects, their own defaults and their graph attributes.
+ * Then every value must be the same in both graphs through agxget,
+ * through the columns that agattrcol returns, and through agcsrcol,
+ * in the root graph and in each subgraph, before and after values are
+ * set on some of the objects, a new attribute is declared, and objects
+ * are created in a subgraph with defaults of its own.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cgraph.h>
+
+/* from cghdr.h, to tell which attributes a subgraph declares itself */
+extern Dict_t *agdictof(Agraph_t * g, int kind);
+extern Agsym_t *aglocaldictsym(Dict_t * dict, char *name);
+
+static int Errors;
+
+static void fail(char *file, char *what, char *name, char *attr)
+{
+    fprintf(stderr, "attrcmp: %s: %s %s, attribute %s differs\n", file,
+	    what, name, attr);
+    Errors++;
+}
+
+/* the attribute of the copy c with the name of sym */
+static Agsym_t *copysym(Agraph_t * c, int kind, Agsym_t * sym)
+{
+    return agattr(c, kind, sym->name, NULL);
+}
+
+static int islocal(Agraph_t * g, int kind, Agsym_t * sym)
+{
+    return (aglocaldictsym(agdictof(g, kind), sym->name) != NULL);
+}
+
+/* copy the subgraphs of g into c, with the defaults they declare and
+ * their graph attributes, and add their nodes and edges. The edges of
+ * a node are in the same order in both graphs.
+ */
+static void copysubgs(Agraph_t * root, Agraph_t * g, Agraph_t * croot,
+		      Agraph_t * c)
+{
+    Agraph_t *s, *sc;
+    Agnode_t *n, *nc;
+    Agedge_t *e, *ec;
+    Agsym_t *sym;
+
+    for (s = agfstsubg(g); s; s = agnxtsubg(s)) {
+	sc = agsubg(c, agnameof(s), 1);
+	for (sym = NULL; (sym = agnxtattr(s, AGNODE, sym));)
+	    if (islocal(s, AGNODE, sym))
+		agattr(sc, AGNODE, sym->name, sym->defval);
+	for (sym = NULL; (sym = agnxtattr(s, AGEDGE, sym));)
+	    if (islocal(s, AGEDGE, sym))
+		agattr(sc, AGEDGE, sym->name, sym->defval);
+	for (sym = NULL; (sym = agnxtattr(s, AGRAPH, sym));)
+	    agxset(sc, copysym(sc, AGRAPH, sym), agxget(s, sym));
+	for (n = agfstnode(root); n; n = agnxtnode(root, n)) {
+	    if (!agsubnode(s, n, 0))
+		continue;
+	    nc = agsubnode(sc, agnode(croot, agnameof(n), 0), 1);
+	    for (e = agfstout(root, n), ec = agfstout(croot, nc); e && ec;
+		 e = agnxtout(root, e), ec = agnxtout(croot, ec))
+		if (agsubedge(s, e, 0))
+		    agsubedge(sc, ec, 1);
+	}
+	copysubgs(root, s, croot, sc);
+    }
+}
+
+static Agraph_t *copygraph(Agraph_t * g)
+{
+    Agdesc_t desc = g->desc;
+    Agraph_t *c;
+    Agnode_t *n;
+    Agedge_t *e;
+    Agsym_t *sym;
+
+    desc.attrcols = 1;
+    c = agopen(agnameof(g), desc, NULL);
+    for (n = agfstnode(g); n; n = agnxtnode(g, n))
+	agnode(c, agnameof(n), 1);
+    for (n = agfstnode(g); n; n = agnxtnode(g, n))
+	for (e = agfstout(g, n); e; e = agnxtout(g, e))
+	    agedge(c, agnode(c, agnameof(agtail(e)), 0),
+		   agnode(c, agnameof(aghead(e)), 0), agnameof(e), 1);
+
+    for (sym = NULL; (sym = agnxtattr(g, AGRAPH, sym));) {
+	agattr(c, AGRAPH, sym->name, sym->defval);
+	agset(c, sym->name, agxget(g, sym));
+    }
+    for (sym = NULL; (sym = agnxtattr(g, AGNODE, sym));)
+	agattr(c, AGNODE, sym->name, sym->defval);
+    for (sym = NULL; (sym = agnxtattr(g, AGEDGE, sym));)
+	agattr(c, AGEDGE, sym->name, sym->defval);
+    copysubgs(g, g, c, c);
+    return c;
+}
+
+static void copyvalues(Agraph_t * g, Agraph_t * c)
+{
+    Agnode_t *n, *nc;
+    Agedge_t *e, *ec;
+    Agsym_t *sym;
+
+    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	nc = agnode(c, agnameof(n), 0);
+	for (sym = NULL; (sym = agnxtattr(g, AGNODE, sym));)
+	    agxset(nc, copysym(c, AGNODE, sym), agxget(n, sym));
+	for (e = agfstout(g, n), ec = agfstout(c, nc); e && ec;
+	     e = agnxtout(g, e), ec = agnxtout(c, ec))
+	    for (sym = NULL; (sym = agnxtattr(g, AGEDGE, sym));)
+		agxset(ec, copysym(c, AGEDGE, sym), agxget(e, sym));
+    }
+}
+
+/* a subgraph with defaults of its own, and a node and an edge created
+ * in it, which must take those defaults.
+ */
+static void addsubg(Agraph_t * g)
+{
+    Agraph_t *s = agsubg(g, "_attrcmp", 1);
+    Agnode_t *n = agfstnode(g);
+    Agnode_t *m;
+
+    agattr(s, AGRAPH, "attrcmp", "subgraph");
+    agattr(s, AGNODE, "attrcmp", "local");
+    agattr(s, AGEDGE, "weight", "3");
+    m = agnode(s, "_attrcmp", 1);
+    if (n)
+	agedge(s, m, n, NULL, 1);
+}
+
+static void chklocal(char *file, Agraph_t * g)
+{
+    Agnode_t *n = agnode(g, "_attrcmp", 0);
+    Agedge_t *e;
+
+    if (strcmp(agget(n, "attrcmp"), "local"))
+	fail(file, "node", agnameof(n), "attrcmp");
+    if ((e = agfstout(g, n)) && strcmp(agget(e, "weight"), "3"))
+	fail(file, "edge", agnameof(n), "weight");
+    if (strcmp(agget(agsubg(g, "_attrcmp", 0), "attrcmp"), "subgraph"))
+	fail(file, "graph", "_attrcmp", "attrcmp");
+}
+
+/* set some values back to the default, and some to a value of
+ * their own, declare a new attribute, and add a subgraph with defaults
+ * of its own, in both graphs.
+ */
+static void change(Agraph_t * g, Agraph_t * c)
+{
+    Agnode_t *n, *nc;
+    Agsym_t *sym;
+    char buf[32];
+    int i = 0;
+
+    for (n = agfstnode(g); n; n = agnxtnode(g, n), i++) {
+	nc = agnode(c, agnameof(n), 0);
+	for (sym = NULL; (sym = agnxtattr(g, AGNODE, sym));) {
+	    if (i % 3 == 0)
+		strcpy(buf, sym->defval);
+	    else if (i % 3 == 1)
+		sprintf(buf, "%d", i);
+	    else
+		continue;
+	    agxset(n, sym, buf);
+	    agxset(nc, copysym(c, AGNODE, sym), buf);
+	}
+    }
+    agattr(g, AGNODE, "attrcmp", "x");
+    agattr(c, AGNODE, "attrcmp", "x");
+    agattr(g, AGEDGE, "weight", "2");
+    agattr(c, AGEDGE, "weight", "2");
+    addsubg(g);
+    addsubg(c);
+}
+
+/* the values of sym in obj and symc in objc, and in the column of
+ * symc, must be the same.
+ */
+static void cmpvalue(char *file, void *obj, Agsym_t * sym, void *objc,
+		     Agsym_t * symc, char **col, int size)
+{
+    char *v = agxget(obj, sym);
+    char *name = agnameof(obj);
+    char *what = (AGTYPE(obj) == AGNODE ? "node" : "edge");
+
+    if (!name)
+	name = agnameof(agtail((Agedge_t *) obj));
+    if (strcmp(v, agxget(objc, symc)))
+	fail(file, what, name, sym->name);
+    else if ((AGSEQ(objc) >= (unsigned long) size)
+	     || strcmp(v, col[AGSEQ(objc)]))
+	fail(file, what, name, sym->name);
+}
+
+static void cmpkind(char *file, Agraph_t * g, Agraph_t * c, int kind)
+{
+    Agnode_t *n, *nc;
+    Agedge_t *e, *ec;
+    Agsym_t *sym, *symc;
+    char **col;
+    int size;
+
+    for (sym = NULL; (sym = agnxtattr(g, kind, sym));) {
+	symc = copysym(c, kind, sym);
+	if (agattrcol(g, sym, &size)) {
+	    fprintf(stderr, "attrcmp: %s: columns without attrcols\n",
+		    file);
+	    Errors++;
+	}
+	if (!(col = agattrcol(c, symc, &size))) {
+	    fprintf(stderr, "attrcmp: %s: no column for %s\n", file,
+		    sym->name);
+	    Errors++;
+	    continue;
+	}
+	for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	    nc = agnode(c, agnameof(n), 0);
+	    if (kind == AGNODE) {
+		cmpvalue(file, n, sym, nc, symc, col, size);
+		continue;
+	    }
+	    for (e = agfstout(g, n), ec = agfstout(c, nc); e && ec;
+		 e = agnxtout(g, e), ec = agnxtout(c, ec))
+		cmpvalue(file, e, sym, ec, symc, col, size);
+	}
+    }
+}
+
+static void cmpcsr(char *file, Agraph_t * g, Agraph_t * c)
+{
+    Agcsr_t *csr = agcsr(g);
+    Agcsr_t *csrc = agcsr(c);
+    double *w = agcsrcol(csr, agattr(g, AGEDGE, "weight", NULL), 1);
+    double *wc = agcsrcol(csrc, agattr(c, AGEDGE, "weight", NULL), 1);
+    int k;
+
+    if (csr->nedges != csrc->nedges) {
+	fprintf(stderr, "attrcmp: %s: edge counts differ\n", file);
+	Errors++;
+    } else
+	for (k = 0; k < csr->nedges; k++)
+	    if (w[k] < wc[k] || w[k] > wc[k]) {
+		fail(file, "edge", agnameof(agtail(csr->edge[k])),
+		     "weight");
+		break;
+	    }
+    agcsrfree(csr);
+    agcsrfree(csrc);
+}
+
+/* the defaults of kind in subgraph s and its copy sc must be the same,
+ * and declared in both or in neither.
+ */
+static void cmpdefaults(char *file, Agraph_t * s, Agraph_t * sc, int kind)
+{
+    Agsym_t *sym, *symc;
+
+    for (sym = NULL; (sym = agnxtattr(s, kind, sym));) {
+	symc = copysym(sc, kind, sym);
+	if (strcmp(sym->defval, symc->defval)
+	    || (islocal(s, kind, sym) != islocal(sc, kind, symc)))
+	    fail(file, "default in subgraph", agnameof(s), sym->name);
+    }
+}
+
+static void cmpsubgs(char *file, Agraph_t * g, Agraph_t * c)
+{
+    Agraph_t *s, *sc;
+    Agsym_t *sym;
+
+    for (s = agfstsubg(g); s; s = agnxtsubg(s)) {
+	if (!(sc = agsubg(c, agnameof(s), 0))) {
+	    fprintf(stderr, "attrcmp: %s: no subgraph %s in the copy\n",
+		    file, agnameof(s));
+	    Errors++;
+	    continue;
+	}
+	if ((agnnodes(s) != agnnodes(sc)) || (agnedges(s) != agnedges(sc))) {
+	    fprintf(stderr, "attrcmp: %s: subgraph %s, objects differ\n",
+		    file, agnameof(s));
+	    Errors++;
+	    continue;
+	}
+	for (sym = NULL; (sym = agnxtattr(s, AGRAPH, sym));)
+	    if (strcmp(agxget(s, sym), agget(sc, sym->name)))
+		fail(file, "graph", agnameof(s), sym->name);
+	cmpdefaults(file, s, sc, AGNODE);
+	cmpdefaults(file, s, sc, AGEDGE);
+	cmpkind(file, s, sc, AGNODE);
+	cmpkind(file, s, sc, AGEDGE);
+	cmpsubgs(file, s, sc);
+    }
+}
+
+static void cmpgraphs(char *file, Agraph_t * g, Agraph_t * c)
+{
+    Agsym_t *sym;
+
+    for (sym = NULL; (sym = agnxtattr(g, AGRAPH, sym));)
+	if (strcmp(agxget(g, sym), agget(c, sym->name)))
+	    fail(file, "graph", agnameof(g), sym->name);
+    cmpkind(file, g, c, AGNODE);
+    cmpkind(file, g, c, AGEDGE);
+    cmpsubgs(file, g, c);
+    cmpcsr(file, g, c);
+}
+
+int main(int argc, char **argv)
+{
+    FILE *fp;
+    Agraph_t *g, *c;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+	if (!(fp = fopen(argv[i], "r"))) {
+	    perror(argv[i]);
+	    return 2;
+	}
+	agsetfile(argv[i]);
+	while ((g = agread(fp, NULL))) {
+	    c = copygraph(g);
+	    copyvalues(g, c);
+	    cmpgraphs(argv[i], g, c);
+	    change(g, c);
+	    cmpgraphs(argv[i], g, c);
+	    chklocal(argv[i], g);
+	    chklocal(argv[i], c);
+	    agclose(c);
+	    agclose(g);
+	}
+	fclose(fp);
+    }
+    return (Errors > 0);
+}
@@ -0,0 +1,61 @@
+#!/bin/sh
+#
+# Detached rendering test
+#
+# Lays out a graph of several components with several OpenMP threads
+# and renders it to svgz and svg in child processes (-j). The child that
+# compresses must not wait on threads the parent started before fork,
+# so dot is given a time limit, and the decompressed svgz must be the
+# same as the svg.
+#
+# Usage: detach.sh [-d dot] [-t seconds] [-n threads]
+
+DOT=../cmd/dot/dot_builtins
+LIMIT=120
+THREADS=4
+TMP=detach$$
+
+while getopts "d:t:n:" c
+do
+  case $c in
+  d ) DOT=$OPTARG ;;
+  t ) LIMIT=$OPTARG ;;
+  n ) THREADS=$OPTARG ;;
+  * ) echo "Usage: detach.sh [-d dot] [-t seconds] [-n threads]" >&2
+      exit 1 ;;
+  esac
+done
+
+trap 'rm -f $TMP.gv $TMP.gv.svgz $TMP.gv.svg' 0
+
+# 4 trees of 600 nodes, large enough for several compressed blocks
+awk 'BEGIN {
+  print "digraph detach {"
+  for (c = 0; c < 4; c++)
+    for (i = 1; i < 600; i++)
+      printf "  n%d -> n%d\n", c * 600 + i, c * 600 + int((i - 1) / 3)
+  print "}"
+}' > $TMP.gv
+
+OMP_NUM_THREADS=$THREADS
+export OMP_NUM_THREADS
+
+$DOT -Tsvgz -Tsvg -O -j2 $TMP.gv &
+pid=$!
+( sleep $LIMIT; kill -9 $pid ) 2>/dev/null &
+watch=$!
+wait $pid
+rc=$?
+kill $watch 2>/dev/null
+
+if [ $rc -ne 0 ]
+then
+  echo "detach.sh: dot -j2 with $THREADS threads failed or hung (status $rc)" >&2
+  exit 1
+fi
+if gunzip -c $TMP.gv.svgz | cmp -s - $TMP.gv.svg
+then
+  exit 0
+fi
+echo "detach.sh: svgz and svg rendered in child processes differ" >&2
+exit 1
@@ -0,0 +1,52 @@
+#!/bin/sh
+#
+# Network simplex pivot benchmark
+#
+# Runs dot on every graph in the test corpus once per leaving edge
+# strategy (the nspivot attribute) and reports the number of network
+# simplex pivots, the time spent in network simplex and the resulting
+# pivots per second. The numbers are taken from the summary line that
+# dot -v prints after each network simplex run.
+#
+# Usage: nsbench.sh [-d dot] [-g graphdir] [strategy ...]
+
+DOT=../cmd/dot/dot_builtins
+GRAPHDIR=graphs
+STRATEGIES=
+
+while getopts "d:g:" c
+do
+  case $c in
+  d ) DOT=$OPTARG ;;
+  g ) GRAPHDIR=$OPTARG ;;
+  * ) echo "Usage: nsbench.sh [-d dot] [-g graphdir] [strategy ...]" >&2
+      exit 1 ;;
+  esac
+done
+shift `expr $OPTIND - 1`
+STRATEGIES=${*:-"block first best"}
+
+# one thread, so the per-run timings are not interleaved
+OMP_NUM_THREADS=1
+export OMP_NUM_THREADS
+
+for s in $STRATEGIES
+do
+  for g in $GRAPHDIR/*.gv
+  do
+    $DOT -v -Tcanon -Gnspivot=$s $g 2>&1 >/dev/null
+  done | awk -v strategy=$s '
+    /^network simplex: *[0-9]+ nodes [0-9]+ edges [0-9]+ iter/ {
+      for (i = 1; i < NF; i++) {
+        if ($(i+1) == "iter") iters += $i
+        if ($(i+1) == "sec") secs += $i
+      }
+      runs++
+    }
+    END {
+      printf "%-6s %6d runs %10d pivots %8.2f sec", strategy, runs, iters, secs
+      if (secs > 0)
+        printf " %12.0f pivots/sec", iters / secs
+      printf "\n"
+    }'
+done
@@ -0,0 +1,209 @@
+/* $Id$ $Revision$ */
+/* vim:set shiftwidth=4 ts=8: */
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: See CVS logs. Details at http://www.graphviz.org/
+ *************************************************************************/
+
+/*
+ * readcmp file ...
+ *
+ * Checks that the hand-written reader selected by
+ * agsetreader(AGREAD_FAST) builds the same graphs as the yacc parser.
+ * Each file is read to its end with agread, once with the default
+ * discipline, which lets the fast reader map it, and once through an
+ * I/O discipline of our own, which makes it read the file in chunks;
+ * then its contents are read with agmemread. Everything the graphs
+ * hold is written out, including the sequence numbers of the objects,
+ * the ids and defaults of the attributes seen and declared in each
+ * graph and subgraph, and the diagnostics, and the descriptions made
+ * with the two readers must be identical.
+ *
+ * Subgraphs are written in the order of their names, since the order
+ * of a graph's subgraphs depends on the addresses of their names, and
+ * anonymous ones by sequence under a common name, since the ids they
+ * are named after keep growing from one graph read to the next.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cgraph.h>
+
+/* from cghdr.h, to tell which attributes a subgraph declares itself */
+extern Dict_t *agdictof(Agraph_t * g, int kind);
+extern Agsym_t *aglocaldictsym(Dict_t * dict, char *name);
+
+static FILE *Out;
+
+typedef enum { READ_FILE, READ_CHUNKS, READ_MEM } readmode_t;
+static char *modename[] = { "agread", "agread in chunks", "agmemread" };
+
+static int chunkread(void *chan, char *buf, int bufsize)
+{
+    return AgIoDisc.afread(chan, buf, bufsize);
+}
+
+static Agiodisc_t ChunkIoDisc;
+static Agdisc_t ChunkDisc = { &AgMemDisc, &AgIdDisc, &ChunkIoDisc };
+
+static int errf(char *msg)
+{
+    return fputs(msg, Out);
+}
+
+static void dumpattrs(void *obj, Agraph_t * g, int kind)
+{
+    Agsym_t *sym = NULL;
+
+    while ((sym = agnxtattr(g, kind, sym)))
+	fprintf(Out, "  %s=\"%s\"\n", sym->name, agxget(obj, sym));
+}
+
+static char *subgname(Agraph_t * g)
+{
+    char *name = agnameof(g);
+
+    return ((name[0] == '%') ? "%" : name);
+}
+
+static int cmpsubg(const void *a, const void *b)
+{
+    Agraph_t *g0 = *(Agraph_t * const *) a;
+    Agraph_t *g1 = *(Agraph_t * const *) b;
+    int rv = strcmp(subgname(g0), subgname(g1));
+
+    if (rv == 0)
+	rv = (AGSEQ(g0) < AGSEQ(g1) ? -1 : 1);
+    return rv;
+}
+
+static void dump(Agraph_t * g)
+{
+    static int kinds[] = { AGRAPH, AGNODE, AGEDGE };
+    Agraph_t *root = agroot(g);
+    Agraph_t *sg;
+    Agraph_t **subgs;
+    Agnode_t *n;
+    Agedge_t *e;
+    Agsym_t *sym;
+    int i;
+    size_t j, cnt;
+
+    fprintf(Out, "graph \"%s\" %lu\n", subgname(g), (unsigned long) AGSEQ(g));
+    for (i = 0; i < 3; i++)
+	for (sym = NULL; (sym = agnxtattr(g, kinds[i], sym));)
+	    fprintf(Out, " decl %d %s %d %d %d %d \"%s\"\n", kinds[i],
+		    sym->name, sym->id, sym->print, sym->fixed,
+		    (aglocaldictsym(agdictof(g, kinds[i]), sym->name) != NULL),
+		    sym->defval);
+    dumpattrs(g, g, AGRAPH);
+    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	fprintf(Out, " node \"%s\" %lu\n", agnameof(n),
+		(unsigned long) AGSEQ(n));
+	if (g == root)
+	    dumpattrs(n, root, AGNODE);
+	for (e = agfstout(g, n); e; e = agnxtout(g, e)) {
+	    fprintf(Out, " edge \"%s\" \"%s\" \"%s\" %lu\n",
+		    agnameof(agtail(e)), agnameof(aghead(e)),
+		    agnameof(e) ? agnameof(e) : "",
+		    (unsigned long) AGSEQ(e));
+	    if (g == root)
+		dumpattrs(e, root, AGEDGE);
+	}
+    }
+
+    cnt = (size_t) agnsubg(g);
+    subgs = malloc((cnt + 1) * sizeof(Agraph_t *));
+    for (j = 0, sg = agfstsubg(g); sg; sg = agnxtsubg(sg))
+	subgs[j++] = sg;
+    qsort(subgs, cnt, sizeof(Agraph_t *), cmpsubg);
+    for (j = 0; j < cnt; j++)
+	dump(subgs[j]);
+    free(subgs);
+}
+
+/* read file as mode says with the given reader, and describe the
+ * result in a temporary file.
+ */
+static FILE *readfile(char *file, agreader_t reader, readmode_t mode)
+{
+    FILE *fp;
+    FILE *out;
+    Agraph_t *g;
+    char *buf;
+    size_t len;
+
+    if (!(fp = fopen(file, "rb"))) {
+	perror(file);
+	exit(2);
+    }
+    out = tmpfile();
+    Out = out;
+    agsetreader(reader);
+    agsetfile(file);
+    if (mode == READ_MEM) {
+	fseek(fp, 0, SEEK_END);
+	len = (size_t) ftell(fp);
+	rewind(fp);
+	buf = malloc(len + 1);
+	len = fread(buf, 1, len, fp);
+	buf[len] = '\0';
+	if ((g = agmemread(buf))) {
+	    dump(g);
+	    agclose(g);
+	}
+	free(buf);
+    } else {
+	while ((g = agread(fp, (mode == READ_CHUNKS ? &ChunkDisc : NULL)))) {
+	    dump(g);
+	    agclose(g);
+	}
+    }
+    fclose(fp);
+    agsetreader(AGREAD_YACC);
+    rewind(out);
+    return out;
+}
+
+static int same(FILE * f0, FILE * f1)
+{
+    int c;
+
+    do {
+	if ((c = getc(f0)) != getc(f1))
+	    return 0;
+    } while (c != EOF);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    FILE *yacc, *fast;
+    int i, rv = 0;
+    readmode_t mode;
+
+    ChunkIoDisc = AgIoDisc;
+    ChunkIoDisc.afread = chunkread;
+    agseterrf(errf);
+    for (i = 1; i < argc; i++) {
+	for (mode = READ_FILE; mode <= READ_MEM; mode++) {
+	    yacc = readfile(argv[i], AGREAD_YACC, mode);
+	    fast = readfile(argv[i], AGREAD_FAST, mode);
+	    if (!same(yacc, fast)) {
+		fprintf(stderr, "readcmp: %s: the readers differ (%s)\n",
+			argv[i], modename[mode]);
+		rv = 1;
+	    }
+	    fclose(yacc);
+	    fclose(fast);
+	}
+    }
+    return rv;
+}
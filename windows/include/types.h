@@ -228,6 +228,7 @@ extern "C" {
 	ratio_t ratio_kind;
 	void* xdots;
 	char* id;
+	void* spdx;		/* spatial index of node and edge boxes, see emit.c */
     } layout_t;
 
 /* for "record" shapes */